@@ -0,0 +1,166 @@
+#pragma once
+
+#include <QObject>
+#include <QEvent>
+#include <QImage>
+#include <QString>
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <vector>
+
+// Keeps the heavy lifting of the editor away from the GUI thread.
+// TXD files are parsed on a loader thread and texture previews are decoded by a small pool
+// of workers. Results come back to the GUI thread as events, so the editor stays responsive.
+// Decoded previews are kept in a LRU cache so that switching between textures is instant.
+class AsyncTxdLoader : public QObject
+{
+public:
+    AsyncTxdLoader( MainWindow *mainWnd, size_t previewCacheBudget );
+    ~AsyncTxdLoader( void );
+
+    // TXD loading.
+    // The result is given to the main window once the file has been parsed.
+    // Starting another load or cancelling throws away the result of the previous one.
+    void BeginTxdLoad( QString fileName );
+    void CancelTxdLoad( void );
+
+    // Preview decoding.
+    // Cached previews are returned immediately. Requesting a preview cancels any decoding that has
+    // not started yet, so that only the latest selection is waited upon. Prefetches go behind it.
+    bool GetCachedPreview( rw::Raster *texRaster, bool drawMipmaps, QImage& imageOut );
+    void RequestPreview( rw::Raster *texRaster, bool drawMipmaps );
+    void PrefetchPreview( rw::Raster *texRaster, bool drawMipmaps );
+    void CancelPreviews( void );
+
+    // Has to be called if raster contents have changed, so we do not show stale previews.
+    void InvalidatePreviews( void );
+
+    // Can be called from any thread.
+    void PostLogMessage( QString msg, eLogMessageType msgType );
+
+protected:
+    void customEvent( QEvent *evt ) override;
+
+private:
+    struct txdLoadTask
+    {
+        AsyncTxdLoader *loader;
+        rw::thread_t threadHandle;
+        QString fileName;
+        unsigned int generation;
+    };
+
+    struct previewJob
+    {
+        rw::Raster *texRaster;      // we hold a reference
+        bool drawMipmaps;
+        unsigned int generation;
+    };
+
+    struct previewCacheEntry
+    {
+        rw::Raster *texRaster;      // we hold a reference
+        bool drawMipmaps;
+        QImage image;
+        size_t imageSize;
+    };
+
+    struct log_message_event : public QEvent
+    {
+        inline log_message_event( QString msg, eLogMessageType msgType ) : QEvent( QEvent::User )
+        {
+            this->msg = std::move( msg );
+            this->msgType = msgType;
+        }
+
+        QString msg;
+        eLogMessageType msgType;
+    };
+
+    struct txd_loaded_event : public QEvent
+    {
+        inline txd_loaded_event( rw::Interface *rwEngine, txdLoadTask *task ) : QEvent( QEvent::User )
+        {
+            this->rwEngine = rwEngine;
+            this->task = task;
+            this->loadedTXD = NULL;
+        }
+
+        inline ~txd_loaded_event( void )
+        {
+            // If nobody took the TXD, it has to go.
+            if ( rw::TexDictionary *txd = this->loadedTXD )
+            {
+                this->rwEngine->DeleteRwObject( txd );
+            }
+        }
+
+        rw::Interface *rwEngine;
+        txdLoadTask *task;
+        rw::TexDictionary *loadedTXD;
+    };
+
+    struct preview_decoded_event : public QEvent
+    {
+        inline preview_decoded_event( const previewJob& job ) : QEvent( QEvent::User ), job( job )
+        {
+            this->hasImage = false;
+        }
+
+        inline ~preview_decoded_event( void )
+        {
+            if ( rw::Raster *texRaster = this->job.texRaster )
+            {
+                rw::DeleteRaster( texRaster );
+            }
+        }
+
+        previewJob job;
+        bool hasImage;
+        QImage image;
+        QString errorMsg;
+    };
+
+    static void __cdecl _txdLoadEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud );
+    static void __cdecl _previewWorkerEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud );
+
+    void DecodePreview( rw::Interface *rwEngine, preview_decoded_event *resultEvt );
+
+    bool IsPreviewPending( rw::Raster *texRaster, bool drawMipmaps ) const;
+    void ClearWaitingPreviews( void );
+    void PutIntoPreviewCache( rw::Raster *texRaster, bool drawMipmaps, const QImage& image );
+    void ClearPreviewCache( void );
+
+    MainWindow *mainWnd;
+
+    // TXD loading state.
+    unsigned int txdLoadGeneration;
+
+    std::list <txdLoadTask*> txdLoadTasks;
+
+    // Preview decoding state.
+    std::vector <rw::thread_t> previewWorkers;
+
+    mutable std::mutex previewLock;
+    std::condition_variable previewJobAvailableCond;
+
+    bool isTerminating;
+
+    unsigned int previewGeneration;
+
+    std::deque <previewJob> waitingPreviews;    // not picked up by any worker yet
+    std::list <previewJob> decodingPreviews;    // being decoded or waiting for delivery
+
+    // The preview that the main window wants to show once it is done.
+    bool hasWantedPreview;
+    rw::Raster *wantedRaster;
+    bool wantedDrawMipmaps;
+
+    // Only accessed on the GUI thread; most recently used entry at the front.
+    std::list <previewCacheEntry> previewCache;
+    size_t previewCacheSize;
+    size_t previewCacheBudget;
+};
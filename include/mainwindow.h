@@ -11,6 +11,7 @@
 #include <QSplitter>
 #include <QAction>
 #include <QMessageBox>
+#include <QThread>
 
 #include <renderware.h>
 
@@ -56,6 +57,7 @@ inline QString ansi_to_qt( const std::string& str )
 #include "guiserialization.h"
 #include "aboutdialog.h"
 #include "streamcompress.h"
+#include "asyncloader.h"
 
 #include "MagicExport.h"
 
@@ -73,6 +75,7 @@ class MainWindow : public QMainWindow, public magicTextLocalizationItem
     friend class AboutDialog;
     friend class OptionsDialog;
     friend class mainWindowSerializationEnv;
+    friend class AsyncTxdLoader;
 
 public:
     MainWindow(QString appPath, rw::Interface *rwEngine, CFileSystem *fsHandle, QWidget *parent = 0);
@@ -105,6 +108,8 @@ public:
     void updateAllTextureMetaInfo(void);
 
     void updateTextureView(void);
+    void requestTexturePreview(void);
+    void showTexturePreview(const QImage& texImage);
 
     void updateTextureViewport(void);
 
@@ -194,7 +199,17 @@ private:
 
         void OnWarning(std::string&& msg) override
         {
-            this->mainWnd->txdLog->addLogMessage(ansi_to_qt(msg), LOGMSG_WARNING);
+            // Warnings from worker threads have to be delivered on the GUI thread.
+            AsyncTxdLoader *asyncLoader = this->mainWnd->asyncLoader;
+
+            if (asyncLoader && QThread::currentThread() != this->mainWnd->thread())
+            {
+                asyncLoader->PostLogMessage(ansi_to_qt(msg), LOGMSG_WARNING);
+            }
+            else
+            {
+                this->mainWnd->txdLog->addLogMessage(ansi_to_qt(msg), LOGMSG_WARNING);
+            }
         }
 
     private:
@@ -208,6 +223,8 @@ private:
 
     TexInfoWidget *currentSelectedTexture;
 
+    AsyncTxdLoader *asyncLoader;    // TXD loading and preview decoding
+
     RwVersionSets versionSets;
 
     QFileInfo openedTXDFileInfo;
@@ -30,6 +30,8 @@ private:
     QCheckBox *propGenMipmaps;
     QLineEdit *propGenMipmapsMax;
     QCheckBox *propCompressTextures;
+    QLineEdit *editCacheRoot;
+    QLineEdit *editCacheMaxSize;
 
     RwListEntry <MassBuildWindow> node;
 };
\ No newline at end of file
@@ -33,6 +33,9 @@
 namespace rw
 {
 
+// Private memory management state (see rwmem.hxx).
+struct rwMemoryEnvironment;
+
 // Type system declaration for type abstraction.
 // This is where atomics, frames, geometries register to.
 struct EngineInterface : public Interface
@@ -45,6 +48,9 @@ struct EngineInterface : public Interface
     // DO NOT ACCESS THE FIELDS DIRECTLY.
     // THEY MUST BE ACCESSED UNDER MUTUAL EXCLUSION/CONTEXT LOCKING.
 
+    // Backs MemAllocate and PixelAllocate; created before and released after everything else.
+    rwMemoryEnvironment *memEnv;
+
     // General type system.
     RwMemoryAllocator memAlloc;
 
@@ -126,6 +132,9 @@ typedef EngineInterface::RwTypeSystem RwTypeSystem;
 // It uses the application variables of EngineInterface.
 std::string GetRunningSoftwareInformation( EngineInterface *engineInterface, bool outputShort = false );
 
+// Every stream has a lock that its users can share if they access it from multiple threads.
+rwlock* GetStreamAccessLock( Stream *theStream );
+
 // Factory for global RenderWare interfaces.
 typedef StaticPluginClassFactory <EngineInterface> RwInterfaceFactory_t;
 
@@ -243,6 +252,9 @@ struct WarningHandler abstract
 void GlobalPushWarningHandler( EngineInterface *engineInterface, WarningHandler *theHandler );
 void GlobalPopWarningHandler( EngineInterface *engineInterface );
 
+// Returns the warning handler on top of the stack of the current thread, or NULL.
+WarningHandler* GetCurrentWarningHandler( EngineInterface *engineInterface );
+
 }
 
 #pragma warning(push)
@@ -100,6 +100,10 @@ public:
 
     void skip( size_t skipCount ) throw( ... );
     int64 tell( void ) const;
+
+    // Zero-copy read; see Stream::borrow. Returns NULL if the underlying stream cannot lend
+    // its memory, in which case the caller has to use read instead.
+    const void* borrow( size_t borrowCount ) throw( ... );
     int64 tell_absolute( void ) const;
 
     void seek( int64 pos, eSeekMode mode ) throw( ... );
@@ -107,9 +111,13 @@ public:
     // Public verification API.
     void check_read_ahead( size_t readCount ) const;
 
+    // Returns the stream that the root block works on; tell_absolute offsets refer to it.
+    Stream* getRootStream( void ) const;
+
 protected:
     // Special helper algorithms.
     void read_native( void *out_buf, size_t readCount ) throw( ... );
+    const void* borrow_native( size_t borrowCount ) throw( ... );
     void write_native( const void *in_buf, size_t writeCount ) throw( ... );
 
     void skip_native( size_t skipCount ) throw( ... );
@@ -158,7 +158,7 @@ private:
 
         if ( origTexels )
         {
-            newTexels = new uint8[ right.dataSize ];
+            newTexels = PixelAllocateUnbound( right.dataSize );
 
             memcpy( newTexels, origTexels, right.dataSize );
         }
@@ -217,7 +217,7 @@ private:
         // If we have texel data, deallocate it.
         if ( void *ourTexels = this->texels )
         {
-            delete [] ourTexels;
+            PixelFreeUnbound( ourTexels );
 
             this->texels = NULL;
         }
@@ -290,7 +290,7 @@ public:
         // Deallocate texels if we already have some.
         if ( void *origTexels = this->texels )
         {
-            delete [] origTexels;
+            PixelFreeUnbound( origTexels );
 
             this->texels = NULL;
         }
@@ -300,7 +300,7 @@ public:
             // Copy the texels.
             if ( dataSize != 0 )
             {
-                void *newTexels = new uint8[ dataSize ];
+                void *newTexels = PixelAllocateUnbound( dataSize );
 
                 memcpy( newTexels, theTexels, dataSize );
 
@@ -414,7 +414,7 @@ public:
 
         if ( ourPixels )
         {
-            newPixels = new uint8[ this->dataSize ];
+            newPixels = PixelAllocateUnbound( this->dataSize );
 
             memcpy( newPixels, ourPixels, this->dataSize );
         }
@@ -441,6 +441,12 @@ public:
     bool browselum(uint32 x, uint32 y, uint8& lum, uint8& a) const;
     bool browsecolorex(uint32 x, uint32 y, abstractColorItem& colorItem ) const;
 
+    // Bulk access to a run of texels in one row, as packed 8bit RGBA (or BGRA) colors.
+    // Much faster than going through browsecolor for every texel.
+    // Returns false if the run is outside of the bitmap or the texel format cannot be converted.
+    bool fetchrow(uint32 x, uint32 y, uint32 count, void *colorsOut, eColorOrdering colorOrder = COLOR_RGBA) const;
+    bool storerow(uint32 x, uint32 y, uint32 count, const void *colorsIn, eColorOrdering colorOrder = COLOR_RGBA);
+
     eColorModel getColorModel( void ) const;
 
     enum eBlendMode
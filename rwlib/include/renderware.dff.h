@@ -168,8 +168,6 @@ private:
 	void deleteOverlapping(std::vector<uint32> &typesRead, uint32 split);
 	void readData(uint32 vertexCount, uint32 type, // native data block
                       uint32 split, std::istream &dff);
-
-	uint32 addTempVertexIfNew(uint32 index);
 };
 
 struct Clump : public RwObject
@@ -68,6 +68,12 @@ typedef unsigned int uint32;            // 4 bytes
 typedef unsigned long long uint64;      // 8 bytes
 typedef float float32;                  // 4 bytes
 
+// Pixel memory that is not bound to any engine interface, used by the Bitmap class.
+// Buffers from these functions and from Interface::PixelAllocate can be freed by either
+// PixelFreeUnbound or any Interface::PixelFree.
+void*   PixelAllocateUnbound    ( size_t memSize );
+void    PixelFreeUnbound        ( void *ptr );
+
 // These do not have to be exclusively defined, so be careful.
 enum : uint32
 {
@@ -453,11 +459,33 @@ struct softwareMetaInfo
     const char *description;
 };
 
+// Custom memory allocator that the library should obtain its memory from.
+// It has to be thread-safe and has to stay alive as long as memory that was allocated
+// through it has not been freed.
+struct MemoryAllocatorInterface abstract
+{
+    virtual void*   Allocate( size_t memSize ) = 0;
+    virtual void    Free( void *memPtr, size_t memSize ) = 0;
+};
+
+// Allocation counters of an engine interface, for measuring allocation churn.
+struct memoryAllocationStatistics
+{
+    uint64 allocationCount;     // amount of MemAllocate/PixelAllocate calls
+    uint64 freeCount;           // amount of MemFree/PixelFree calls
+    uint64 allocatedBytes;      // sum of all requested allocation sizes
+    uint64 liveBytes;           // bytes that are currently allocated
+    uint64 peakLiveBytes;       // highest amount of liveBytes since last reset
+    uint64 poolReuseCount;      // allocations that were served by the allocation pool
+    uint64 pooledBytes;         // bytes that are kept in the pool for reuse
+};
+
 // Palettization configuration.
 enum ePaletteRuntimeType
 {
     PALRUNTIME_NATIVE,      // use the palettizer that is embedded into rwtools
-    PALRUNTIME_PNGQUANT     // use the libimagequant vendor
+    PALRUNTIME_PNGQUANT,    // use the libimagequant vendor
+    PALRUNTIME_MEDIANCUT    // use the histogram based median-cut palettizer of rwtools (fast for many colors)
 };
 
 // DXT compression configuration.
@@ -523,6 +551,18 @@ public:
     void*               PixelAllocate           ( size_t memSize );
     void                PixelFree               ( void *pixels );
 
+    // Pass NULL to go back to the default allocator.
+    void                SetMemoryAllocator      ( MemoryAllocatorInterface *allocator );
+    MemoryAllocatorInterface*   GetMemoryAllocator  ( void ) const;
+
+    // Freed buffers are kept in size classes so that following allocations of similar size
+    // (like the intermediate buffers of pixel conversion) do not have to go to the allocator.
+    void                SetMemoryPooling        ( bool enable );
+    bool                GetMemoryPooling        ( void ) const;
+
+    void                GetMemoryStatistics     ( memoryAllocationStatistics& statsOut ) const;
+    void                ResetMemoryStatistics   ( void );
+
     void                SetWarningManager       ( WarningManagerInterface *warningMan );
     WarningManagerInterface*    GetWarningManager( void ) const;
 
@@ -540,6 +580,27 @@ public:
     void                    SetDXTRuntime       ( eDXTCompressionMethod dxtRunType );
     eDXTCompressionMethod   GetDXTRuntime       ( void ) const;
 
+    // Maximum amount of threads that DXT compression splits its blocks across, using the worker pool of the engine.
+    // 0 means that we pick by the amount of logical processors, 1 disables threading.
+    void                SetDXTCompressionWorkerCount    ( uint32 workerCount );
+    uint32              GetDXTCompressionWorkerCount    ( void ) const;
+
+    // Amount of threads, including the calling one, that texel work of a single texture is spread across,
+    // like decompression and pixel format conversion of its mipmap layers. It also sizes the pool behind
+    // ParallelFor and task groups, which grows on demand but does not shrink while it is alive.
+    // 0 means that we pick by the amount of logical processors, 1 disables threading.
+    void                SetWorkerPoolSize               ( uint32 poolSize );
+    uint32              GetWorkerPoolSize               ( void ) const;
+
+    // Textures with less texels than this (summed up over all mipmap layers) are processed serially.
+    void                SetParallelTexelThreshold       ( uint32 texelCount );
+    uint32              GetParallelTexelThreshold       ( void ) const;
+
+    // Mipmap layers bigger than this are split into bands of rows of about this many texels.
+    // 0 keeps every layer in one piece.
+    void                SetParallelBandTexelCount       ( uint32 texelCount );
+    uint32              GetParallelBandTexelCount       ( void ) const;
+
     void                SetFixIncompatibleRasters   ( bool doFix );
     bool                GetFixIncompatibleRasters   ( void ) const;
 
@@ -554,6 +615,14 @@ public:
 
     void                SetIgnoreSerializationBlockRegions  ( bool doIgnore );
     bool                GetIgnoreSerializationBlockRegions  ( void ) const;
+
+    // Native textures that support it only remember where their mipmap texels are in the
+    // deserialization stream and read them on first access. The stream must stay alive
+    // (and seekable) for as long as such textures have not been accessed.
+    // Call Raster::loadPendingTexels or TexDictionary::loadPendingTexels before you close the
+    // stream but want to keep the textures.
+    void                SetLazyTexelLoading     ( bool enable );
+    bool                GetLazyTexelLoading     ( void ) const;
 };
 
 #include "renderware.utils.h"
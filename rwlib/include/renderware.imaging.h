@@ -8,6 +8,12 @@ bool SerializeMipmapLayer( Stream *outputStream, const char *formatDescriptor, c
 
 bool IsImagingFormatAvailable( Interface *engineInterface, const char *formatDescriptor );
 
+// Returns the name of the imaging format that the stream is stored in, starting at its current position, or NULL if unknown.
+// Formats are recognized by their magic number. Formats without one (TGA) are only checked by structure if
+// allowStructuralProbing is true, since they could match about any stream.
+// The stream position is not changed.
+const char* IdentifyImagingFormat( Stream *inputStream, bool allowStructuralProbing );
+
 // The main API for pushing and pulling pixels.
 bool DeserializeImage( Stream *inputStream, Bitmap& outputPixels );
 bool SerializeImage( Stream *outputStream, const char *formatDescriptor, const Bitmap& inputPixels );
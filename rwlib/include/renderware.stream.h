@@ -8,7 +8,8 @@ enum eBuiltinStreamType
     RWSTREAMTYPE_FILE,
     RWSTREAMTYPE_FILE_W,
     RWSTREAMTYPE_MEMORY,
-    RWSTREAMTYPE_CUSTOM
+    RWSTREAMTYPE_CUSTOM,
+    RWSTREAMTYPE_MAPPED_FILE
 };
 
 enum eStreamMode
@@ -37,6 +38,9 @@ struct streamConstructionFileParam_t : public streamConstructionParam_t
     const char *filename;
 };
 
+// Mapped file streams take a streamConstructionFileParam_t and only support RWSTREAMMODE_READONLY.
+// The whole file is mapped into memory, so reads are plain copies and data can be borrowed.
+
 struct streamConstructionFileParamW_t : public streamConstructionParam_t
 {
     inline streamConstructionFileParamW_t( const wchar_t *filename )
@@ -48,6 +52,8 @@ struct streamConstructionFileParamW_t : public streamConstructionParam_t
     const wchar_t *filename;
 };
 
+// Memory streams work on the given buffer, which cannot grow.
+// If buf is NULL, the stream allocates its own buffer (bufSize bytes reserved) that grows while writing.
 struct streamConstructionMemoryParam_t : public streamConstructionParam_t
 {
     inline streamConstructionMemoryParam_t( void *buf, size_t bufSize )
@@ -158,4 +164,9 @@ struct Stream abstract
 
     // Capability functions.
     virtual bool supportsSize( void ) const;
+
+    // Returns a pointer to the next borrowCount bytes of the stream and advances the seek past them,
+    // without copying. Returns NULL (and leaves the seek alone) if the stream cannot hand out its
+    // memory or not enough bytes are left. The data stays valid until the stream is written to or destroyed.
+    virtual const void* borrow( size_t borrowCount ) throw( ... );
 };
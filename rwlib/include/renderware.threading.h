@@ -119,4 +119,28 @@ void TerminateThread( Interface *engineInterface, thread_t threadHandle, bool wa
 
 void CheckThreadHazards( Interface *engineInterface );
 
+// Task API.
+// Fine-grained jobs (like rows of a texture or blocks of compressed texels) are spread across a
+// work-stealing pool of worker threads that every engine owns (see Interface::SetWorkerPoolSize).
+// Jobs are no threads or fibers, so spawning them is very cheap. They see the configuration and the
+// warning handler of the thread that spawned them.
+typedef void (*taskRoutine_t)( void *ud );
+typedef void (*parallelRangeRoutine_t)( void *ud, size_t beginIndex, size_t endIndex );
+
+// Group of jobs that can be waited on together.
+// Waiting threads run pending jobs in the meantime, so jobs may spawn and wait on groups themselves.
+// If a job throws, the jobs of the group that have not started yet are skipped and wait throws the error.
+struct taskgroup abstract
+{
+    void run( taskRoutine_t routine, void *ud );
+    void wait( void );
+};
+
+taskgroup* CreateTaskGroup( Interface *engineInterface );
+void CloseTaskGroup( Interface *engineInterface, taskgroup *group );   // waits for running jobs
+
+// Calls the routine on subranges of [beginIndex, endIndex) that are no bigger than grainSize.
+// Returns once all of them are done; the calling thread takes part. Errors behave like with task groups.
+void ParallelFor( Interface *engineInterface, size_t beginIndex, size_t endIndex, size_t grainSize, parallelRangeRoutine_t routine, void *ud );
+
 void* GetThreadingNativeManager( Interface *engineInterface );
\ No newline at end of file
@@ -461,6 +461,9 @@ struct Raster
     void clearMipmaps( void );
     void generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGenMode = MIPMAPGEN_DEFAULT );
 
+    // Reads the texels that have not been loaded yet (see Interface::SetLazyTexelLoading).
+    void loadPendingTexels( void );
+
     // Data members.
     Interface *engineInterface;
 
@@ -611,6 +614,9 @@ struct TexDictionary : public RwObject
 	/* functions */
 	void clear( void );
 
+    // Makes all textures independent of the stream that we were read from.
+    void loadPendingTexels( void );
+
     inline texIter_t GetTextureIterator( void )
     {
         return texIter_t( this->textures );
@@ -811,6 +817,28 @@ struct rawMipmapLayer
 // Complex native texture API.
 bool ConvertRasterTo( Raster *theRaster, const char *nativeName );
 
+// Outcome of converting one raster in a batch.
+struct rasterConversionResult
+{
+    Raster *texRaster;
+    TextureBase *texHandle;                 // first texture of the batch that uses this raster
+
+    bool hasSucceeded;
+    std::string errorMessage;               // set if the conversion failed with an exception
+    std::vector <std::string> warnings;     // in the order that they were issued
+};
+
+typedef std::vector <rasterConversionResult> rasterConversionResults_t;
+
+// Converts the rasters of many textures to another native texture type at the same time.
+// Every raster is converted on its own worker of the engine pool (see Interface::SetWorkerPoolSize)
+// and is locked meanwhile; rasters that are shared by textures are converted once.
+// The warnings of every raster are pushed after the batch has finished, raster by raster in the
+// order of the textures, so that the output does not depend on thread scheduling.
+// Returns true if all rasters have been converted; details are put into resultsOut, if given.
+bool ConvertTextureRastersTo( Interface *engineInterface, TextureBase* const *textures, size_t textureCount, const char *nativeName, rasterConversionResults_t *resultsOut = NULL );
+bool ConvertTexDictionaryRastersTo( TexDictionary *txd, const char *nativeName, rasterConversionResults_t *resultsOut = NULL );
+
 void* GetNativeTextureDriverInterface( Interface *engineInterface, const char *nativeName );
 
 const char* GetNativeTextureImageFormatExtension( Interface *engineInterface, const char *nativeName );
@@ -843,6 +871,9 @@ Raster* CloneRaster( const Raster *rasterToClone );
 Raster* AcquireRaster( Raster *theRaster );
 void DeleteRaster( Raster *theRaster );
 
+// Calls generateMipmaps on every raster, spread across the worker pool of the engine (see Interface::SetWorkerPoolSize).
+void GenerateMipmapsParallel( Interface *engineInterface, Raster *const *rasters, size_t rasterCount, uint32 maxMipmapCount, eMipmapGenerationMode mipGenMode = MIPMAPGEN_DEFAULT );
+
 // Pixel manipulation API, exported for good compatibility.
 // Use this API if you are not sure how to map the raster format stuff properly.
 bool BrowseTexelRGBA(
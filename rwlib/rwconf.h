@@ -41,6 +41,10 @@
 // quality color-mapped images.
 #define RWLIB_INCLUDE_LIBIMAGEQUANT
 
+// Define this macro if you want rwlib to use SSE2/AVX2 accelerated pixel kernels.
+// The instruction set is picked at runtime, so the library still runs on older processors.
+#define RWLIB_ENABLE_SIMD_KERNELS
+
 // Define this if you want to use framework entry points for RenderWare in your project.
 // Those can be used to create managed RenderWare applications.
 #define RWLIB_INCLUDE_FRAMEWORK_ENTRYPOINTS
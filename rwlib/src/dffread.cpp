@@ -801,176 +801,297 @@ void Geometry::generateFaces(void)
 	}
 }
 
-// these hold the (temporary) cleaned up data
-static std::vector<float32>  vertices_new;
-static std::vector<float32>  normals_new;
-static std::vector<float32>  texCoords_new[8];
-static std::vector<uint8>    vertexColors_new;
-static std::vector<uint8>    nightColors_new;
-static std::vector<uint32>   vertexBoneIndices_new;
-static std::vector<float32>  vertexBoneWeights_new;
-
-// used only by Geometry::cleanUp()
-// adds new temporary vertex if it isn't already in the list
-// and returns the new index of that vertex
-uint32 Geometry::addTempVertexIfNew(uint32 index)
+// Welds vertices with identical attributes together.
+// Vertices are looked up through a hash of their attributes, so welding a mesh is O(n).
+// Each Geometry::cleanUp() call owns its welder, making it safe to clean up multiple geometries at once.
+struct geometryVertexWelder
 {
-	// return if we already have the vertex
-	for (uint32 i = 0; i < vertices_new.size()/3; i++)
+    inline geometryVertexWelder( const Geometry& geom ) : geom( geom )
     {
-		if (vertices_new[i*3+0] != vertices[index*3+0] ||
-		    vertices_new[i*3+1] != vertices[index*3+1] ||
-		    vertices_new[i*3+2] != vertices[index*3+2])
-			continue;
+        uint32 flags = geom.flags;
 
-		if (flags & FLAGS_NORMALS)
-        {
-			if (normals_new[i*3+0] != normals[index*3+0] ||
-			    normals_new[i*3+1] != normals[index*3+1] ||
-			    normals_new[i*3+2] != normals[index*3+2])
-				continue;
-		}
-		if (flags & FLAGS_TEXTURED || flags & FLAGS_TEXTURED2)
-        {
-			for (uint32 j = 0; j < numUVs; j++)
-            {
-				if (texCoords_new[j][i*2+0] != texCoords[j][index*2+0] ||
-				    texCoords_new[j][i*2+1] != texCoords[j][index*2+1])
-                {
-					goto cont;
-                }
-            }
-		}
-		if (flags & FLAGS_PRELIT)
-        {
-			if (vertexColors_new[i*4+0]!=vertexColors[index*4+0] ||
-			    vertexColors_new[i*4+1]!=vertexColors[index*4+1] ||
-			    vertexColors_new[i*4+2]!=vertexColors[index*4+2] ||
-			    vertexColors_new[i*4+3]!=vertexColors[index*4+3])
-				continue;
-		}
-		if (hasNightColors)
+        this->hasNormals = ( flags & FLAGS_NORMALS ) != 0;
+        this->hasTexCoords = ( flags & FLAGS_TEXTURED || flags & FLAGS_TEXTURED2 );
+        this->hasPrelit = ( flags & FLAGS_PRELIT ) != 0;
+        this->hasNightColors = geom.hasNightColors;
+        this->hasSkin = geom.hasSkin;
+
+        // We can never have more welded vertices than source vertices.
+        // Keep the table at most half full so that probe sequences stay short.
+        uint32 srcVertexCount = (uint32)( geom.vertices.size() / 3 );
+
+        uint32 bucketCount = 16;
+
+        while ( bucketCount < srcVertexCount * 2 )
         {
-			if (nightColors_new[i*4+0] != nightColors[index*4+0] ||
-			    nightColors_new[i*4+1] != nightColors[index*4+1] ||
-			    nightColors_new[i*4+2] != nightColors[index*4+2] ||
-			    nightColors_new[i*4+3] != nightColors[index*4+3])
-				continue;
-		}
-		if (hasSkin)
+            bucketCount *= 2;
+        }
+
+        this->buckets.resize( bucketCount, 0 );
+        this->bucketMask = ( bucketCount - 1 );
+
+        this->vertexHashes.reserve( srcVertexCount );
+    }
+
+    // Returns the new index of the source vertex at index.
+    // The vertex is added to the welded list if we do not know about it yet.
+    inline uint32 weld( uint32 index )
+    {
+        uint32 hash = hashVertex( index );
+
+        uint32 bucketIndex = ( hash & this->bucketMask );
+
+        while ( uint32 entry = this->buckets[ bucketIndex ] )
         {
-			if ( vertexBoneIndices_new[i] != vertexBoneIndices[index] )
-				continue;
+            uint32 newIndex = ( entry - 1 );
 
-			if (vertexBoneWeights_new[i*4+0] != vertexBoneWeights[index*4+0] ||
-			    vertexBoneWeights_new[i*4+1] != vertexBoneWeights[index*4+1] ||
-			    vertexBoneWeights_new[i*4+2] != vertexBoneWeights[index*4+2] ||
-			    vertexBoneWeights_new[i*4+3] != vertexBoneWeights[index*4+3])
+            if ( this->vertexHashes[ newIndex ] == hash && isSameVertex( newIndex, index ) )
             {
-				continue;
+                return newIndex;
             }
-		}
-		// this is only reached when the vertex is already in the list
-		return i;
 
-		cont: ;
-	}
+            bucketIndex = ( ( bucketIndex + 1 ) & this->bucketMask );
+        }
 
-	// else add the vertex
-	vertices_new.push_back(vertices[index*3+0]);
-	vertices_new.push_back(vertices[index*3+1]);
-	vertices_new.push_back(vertices[index*3+2]);
+        uint32 newIndex = addVertex( index );
 
-	if (flags & FLAGS_NORMALS)
-    {
-		normals_new.push_back(normals[index*3+0]);
-		normals_new.push_back(normals[index*3+1]);
-		normals_new.push_back(normals[index*3+2]);
-	}
-	if (flags & FLAGS_TEXTURED || flags & FLAGS_TEXTURED2)
-    {
-		for (uint32 j = 0; j < numUVs; j++)
-        {
-			texCoords_new[j].push_back(texCoords[j][index*2+0]);
-			texCoords_new[j].push_back(texCoords[j][index*2+1]);
-		}
-	}
-	if (flags & FLAGS_PRELIT)
-    {
-		vertexColors_new.push_back(vertexColors[index*4+0]);
-		vertexColors_new.push_back(vertexColors[index*4+1]);
-		vertexColors_new.push_back(vertexColors[index*4+2]);
-		vertexColors_new.push_back(vertexColors[index*4+3]);
-	}
-	if (hasNightColors)
-    {
-		nightColors_new.push_back(nightColors[index*4+0]);
-		nightColors_new.push_back(nightColors[index*4+1]);
-		nightColors_new.push_back(nightColors[index*4+2]);
-		nightColors_new.push_back(nightColors[index*4+3]);
-	}
-	if (hasSkin)
-    {
-		vertexBoneIndices_new.push_back(vertexBoneIndices[index]);
+        this->vertexHashes.push_back( hash );
 
-		vertexBoneWeights_new.push_back(vertexBoneWeights[index*4+0]);
-		vertexBoneWeights_new.push_back(vertexBoneWeights[index*4+1]);
-		vertexBoneWeights_new.push_back(vertexBoneWeights[index*4+2]);
-		vertexBoneWeights_new.push_back(vertexBoneWeights[index*4+3]);
-	}
-	return vertices_new.size()/3 - 1;
-}
+        // Bucket entries are stored with an offset of one, so that zero means free.
+        this->buckets[ bucketIndex ] = ( newIndex + 1 );
 
-// removes duplicate vertices (only useful with ps2 meshes)
-void Geometry::cleanUp(void)
-{
-	vertices_new.clear();
-	normals_new.clear();
-	vertexColors_new.clear();
-	nightColors_new.clear();
+        return newIndex;
+    }
 
-	for (uint32 i = 0; i < 8; i++)
+    // Replaces the vertex data of the geometry with the welded vertex data.
+    inline void apply( Geometry& dstGeom )
     {
-		texCoords_new[i].clear();
+        dstGeom.vertices = std::move( this->vertices );
+
+        if ( this->hasNormals )
+        {
+            dstGeom.normals = std::move( this->normals );
+        }
+        if ( this->hasTexCoords )
+        {
+            for ( uint32 j = 0; j < dstGeom.numUVs; j++ )
+            {
+                dstGeom.texCoords[j] = std::move( this->texCoords[j] );
+            }
+        }
+        if ( this->hasPrelit )
+        {
+            dstGeom.vertexColors = std::move( this->vertexColors );
+        }
+        if ( this->hasNightColors )
+        {
+            dstGeom.nightColors = std::move( this->nightColors );
+        }
+        if ( this->hasSkin )
+        {
+            dstGeom.vertexBoneIndices = std::move( this->vertexBoneIndices );
+            dstGeom.vertexBoneWeights = std::move( this->vertexBoneWeights );
+        }
     }
 
-	vertexBoneIndices_new.clear();
-	vertexBoneWeights_new.clear();
+private:
+    // Attributes are compared using the float equality operator, so +0 and -0 have to hash the same.
+    static inline uint32 hashFloat( float32 value )
+    {
+        if ( value == 0.0f )
+            return 0;
 
-	std::vector<uint32> newIndices;
+        uint32 bits;
+        memcpy( &bits, &value, sizeof( bits ) );
 
-	// create new vertex list
-	for (uint32 i = 0; i < vertices.size()/3; i++)
-    {
-		newIndices.push_back(addTempVertexIfNew(i));
+        return bits;
     }
 
-	vertices = vertices_new;
+    static inline uint32 hashColor( const uint8 *color )
+    {
+        uint32 bits;
+        memcpy( &bits, color, sizeof( bits ) );
+
+        return bits;
+    }
 
-	if (flags & FLAGS_NORMALS)
+    static inline void hashCombine( uint32& hash, uint32 value )
     {
-		normals = normals_new;
+        // FNV-1a over 32bit words.
+        hash = ( hash ^ value ) * 16777619u;
     }
-	if (flags & FLAGS_TEXTURED || flags & FLAGS_TEXTURED2)
+
+    inline uint32 hashVertex( uint32 index ) const
     {
-		for ( uint32 j = 0; j < numUVs; j++ )
+        const Geometry& geom = this->geom;
+
+        uint32 hash = 2166136261u;
+
+        hashCombine( hash, hashFloat( geom.vertices[index*3+0] ) );
+        hashCombine( hash, hashFloat( geom.vertices[index*3+1] ) );
+        hashCombine( hash, hashFloat( geom.vertices[index*3+2] ) );
+
+        if ( this->hasNormals )
         {
-			texCoords[j] = texCoords_new[j];
+            hashCombine( hash, hashFloat( geom.normals[index*3+0] ) );
+            hashCombine( hash, hashFloat( geom.normals[index*3+1] ) );
+            hashCombine( hash, hashFloat( geom.normals[index*3+2] ) );
+        }
+        if ( this->hasTexCoords )
+        {
+            for ( uint32 j = 0; j < geom.numUVs; j++ )
+            {
+                hashCombine( hash, hashFloat( geom.texCoords[j][index*2+0] ) );
+                hashCombine( hash, hashFloat( geom.texCoords[j][index*2+1] ) );
+            }
+        }
+        if ( this->hasPrelit )
+        {
+            hashCombine( hash, hashColor( &geom.vertexColors[index*4] ) );
+        }
+        if ( this->hasNightColors )
+        {
+            hashCombine( hash, hashColor( &geom.nightColors[index*4] ) );
+        }
+        if ( this->hasSkin )
+        {
+            hashCombine( hash, geom.vertexBoneIndices[index] );
+
+            for ( uint32 j = 0; j < 4; j++ )
+            {
+                hashCombine( hash, hashFloat( geom.vertexBoneWeights[index*4+j] ) );
+            }
         }
+
+        // Mix the lower bits, since we use them to index the buckets.
+        hash ^= ( hash >> 16 );
+        hash *= 0x85EBCA6Bu;
+        hash ^= ( hash >> 13 );
+
+        return hash;
     }
-	if (flags & FLAGS_PRELIT)
+
+    inline bool isSameVertex( uint32 i, uint32 index ) const
     {
-		vertexColors = vertexColors_new;
+        const Geometry& geom = this->geom;
+
+        if (vertices[i*3+0] != geom.vertices[index*3+0] ||
+            vertices[i*3+1] != geom.vertices[index*3+1] ||
+            vertices[i*3+2] != geom.vertices[index*3+2])
+            return false;
+
+        if (this->hasNormals)
+        {
+            if (normals[i*3+0] != geom.normals[index*3+0] ||
+                normals[i*3+1] != geom.normals[index*3+1] ||
+                normals[i*3+2] != geom.normals[index*3+2])
+                return false;
+        }
+        if (this->hasTexCoords)
+        {
+            for (uint32 j = 0; j < geom.numUVs; j++)
+            {
+                if (texCoords[j][i*2+0] != geom.texCoords[j][index*2+0] ||
+                    texCoords[j][i*2+1] != geom.texCoords[j][index*2+1])
+                    return false;
+            }
+        }
+        if (this->hasPrelit)
+        {
+            if (memcmp( &vertexColors[i*4], &geom.vertexColors[index*4], 4 ) != 0)
+                return false;
+        }
+        if (this->hasNightColors)
+        {
+            if (memcmp( &nightColors[i*4], &geom.nightColors[index*4], 4 ) != 0)
+                return false;
+        }
+        if (this->hasSkin)
+        {
+            if (vertexBoneIndices[i] != geom.vertexBoneIndices[index])
+                return false;
+
+            if (vertexBoneWeights[i*4+0] != geom.vertexBoneWeights[index*4+0] ||
+                vertexBoneWeights[i*4+1] != geom.vertexBoneWeights[index*4+1] ||
+                vertexBoneWeights[i*4+2] != geom.vertexBoneWeights[index*4+2] ||
+                vertexBoneWeights[i*4+3] != geom.vertexBoneWeights[index*4+3])
+                return false;
+        }
+        return true;
     }
-	if (hasNightColors)
+
+    inline uint32 addVertex( uint32 index )
     {
-		nightColors = nightColors_new;
+        const Geometry& geom = this->geom;
+
+        vertices.insert( vertices.end(), &geom.vertices[index*3], &geom.vertices[index*3] + 3 );
+
+        if (this->hasNormals)
+        {
+            normals.insert( normals.end(), &geom.normals[index*3], &geom.normals[index*3] + 3 );
+        }
+        if (this->hasTexCoords)
+        {
+            for (uint32 j = 0; j < geom.numUVs; j++)
+            {
+                texCoords[j].insert( texCoords[j].end(), &geom.texCoords[j][index*2], &geom.texCoords[j][index*2] + 2 );
+            }
+        }
+        if (this->hasPrelit)
+        {
+            vertexColors.insert( vertexColors.end(), &geom.vertexColors[index*4], &geom.vertexColors[index*4] + 4 );
+        }
+        if (this->hasNightColors)
+        {
+            nightColors.insert( nightColors.end(), &geom.nightColors[index*4], &geom.nightColors[index*4] + 4 );
+        }
+        if (this->hasSkin)
+        {
+            vertexBoneIndices.push_back( geom.vertexBoneIndices[index] );
+
+            vertexBoneWeights.insert( vertexBoneWeights.end(), &geom.vertexBoneWeights[index*4], &geom.vertexBoneWeights[index*4] + 4 );
+        }
+        return (uint32)( vertices.size() / 3 - 1 );
     }
-	if (hasSkin)
+
+    const Geometry& geom;
+
+    bool hasNormals;
+    bool hasTexCoords;
+    bool hasPrelit;
+    bool hasNightColors;
+    bool hasSkin;
+
+    // the (temporary) cleaned up data
+    std::vector<float32>  vertices;
+    std::vector<float32>  normals;
+    std::vector<float32>  texCoords[8];
+    std::vector<uint8>    vertexColors;
+    std::vector<uint8>    nightColors;
+    std::vector<uint32>   vertexBoneIndices;
+    std::vector<float32>  vertexBoneWeights;
+
+    std::vector<uint32> vertexHashes;   // hash of every welded vertex
+    std::vector<uint32> buckets;        // welded vertex index + 1, 0 if free
+    uint32 bucketMask;
+};
+
+// removes duplicate vertices (only useful with ps2 meshes)
+void Geometry::cleanUp(void)
+{
+	geometryVertexWelder welder( *this );
+
+	uint32 srcVertexCount = vertices.size()/3;
+
+	std::vector<uint32> newIndices( srcVertexCount );
+
+	// create new vertex list
+	for (uint32 i = 0; i < srcVertexCount; i++)
     {
-		vertexBoneIndices = vertexBoneIndices_new;
-		vertexBoneWeights = vertexBoneWeights_new;
-	}
+		newIndices[i] = welder.weld(i);
+    }
+
+	welder.apply( *this );
 
 	// correct indices
 	for (uint32 i = 0; i < splits.size(); i++)
@@ -976,6 +976,35 @@ public:
     }
 };
 
+// Specialized converter of a row of raw color texels (see txdread.pixelconv.kernels.cpp).
+typedef void (*texelRowKernel_t)( const void *srcRow, void *dstRow, uint32 srcOffX, uint32 dstOffX, uint32 texelCount );
+
+// Returns NULL if there is no specialized kernel for this format combination.
+texelRowKernel_t GetTexelRowKernel(
+    eRasterFormat srcRasterFormat, uint32 srcDepth, eColorOrdering srcColorOrder,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder
+);
+
+// Transformations of the alpha channel that row kernels can apply while converting.
+enum eTexelAlphaRemap
+{
+    TEXEL_ALPHA_KEEP,
+    TEXEL_ALPHA_PC_TO_PS2,      // 0-255 to the 0-128 range of the PS2 GS
+    TEXEL_ALPHA_PS2_TO_PC
+};
+
+// Same as GetTexelRowKernel, but the alpha channel is remapped on the way.
+texelRowKernel_t GetAlphaRemapTexelRowKernel(
+    eRasterFormat srcRasterFormat, uint32 srcDepth, eColorOrdering srcColorOrder,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder,
+    eTexelAlphaRemap alphaRemap
+);
+
+// Lookup tables of the PS2 alpha remapping, indexed by the source alpha.
+// They match convertPCAlpha2PS2Alpha and convertPS2Alpha2PCAlpha of txdread.ps2shared.enc.hxx.
+extern const uint8 ps2AlphaFromPCAlphaTable[256];
+extern const uint8 pcAlphaFromPS2AlphaTable[256];
+
 template <typename srcColorDispatcher, typename dstColorDispatcher>
 inline void copyTexelDataEx(
     const void *srcTexels, void *dstTexels,
@@ -986,6 +1015,31 @@ inline void copyTexelDataEx(
     uint32 srcRowSize, uint32 dstRowSize
 )
 {
+    // Decide on a specialized kernel once for the entire layer.
+    texelRowKernel_t rowKernel = NULL;
+
+    if ( fetchDispatch.paletteType == PALETTE_NONE && putDispatch.paletteType == PALETTE_NONE )
+    {
+        rowKernel =
+            GetTexelRowKernel(
+                fetchDispatch.rasterFormat, fetchDispatch.depth, fetchDispatch.colorOrder,
+                putDispatch.rasterFormat, putDispatch.depth, putDispatch.colorOrder
+            );
+    }
+
+    if ( rowKernel != NULL )
+    {
+        for ( uint32 row = 0; row < srcHeight; row++ )
+        {
+            const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, row + srcOffY );
+            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, row + dstOffY );
+
+            rowKernel( srcRow, dstRow, srcOffX, dstOffX, srcWidth );
+        }
+
+        return;
+    }
+
     // If we are not a palette, then we have to process colors.
     for ( uint32 row = 0; row < srcHeight; row++ )
     {
@@ -381,6 +381,55 @@ void BlockProvider::read( void *out_buf, size_t readCount ) throw( ... )
     this->blockContext.context_seek += readCount;
 }
 
+const void* BlockProvider::borrow_native( size_t borrowCount ) throw( ... )
+{
+    Stream *contextStream = this->contextStream;
+
+    if ( contextStream != NULL )
+    {
+        return contextStream->borrow( borrowCount );
+    }
+
+    BlockProvider *parentProvider = this->parent;
+
+    if ( parentProvider )
+    {
+        return parentProvider->borrow( borrowCount );
+    }
+
+    throw RwBlockException( "no block context for borrowing operation" );
+}
+
+const void* BlockProvider::borrow( size_t borrowCount ) throw( ... )
+{
+    if ( this->isInContext == false )
+    {
+        throw RwBlockException( "not in a block context" );
+    }
+
+    if ( this->blockMode != RWBLOCKMODE_READ )
+    {
+        return NULL;
+    }
+
+    int64 totalStreamOffset = this->tell_absolute();
+
+    // Verify this access just like a read.
+    streamMemSlice_t readAccess( totalStreamOffset, borrowCount );
+
+    this->verifyLocalStreamAccess( readAccess );
+
+    const void *borrowedData = this->borrow_native( borrowCount );
+
+    if ( borrowedData != NULL )
+    {
+        // Advance the virtual block context seek.
+        this->blockContext.context_seek += borrowCount;
+    }
+
+    return borrowedData;
+}
+
 void BlockProvider::write_native( const void *in_buf, size_t writeCount ) throw( ... )
 {
     Stream *contextStream = this->contextStream;
@@ -658,6 +707,25 @@ Interface* BlockProvider::getEngineInterface( void ) const
     return NULL;
 }
 
+Stream* BlockProvider::getRootStream( void ) const
+{
+    Stream *contextStream = this->contextStream;
+
+    if ( contextStream )
+    {
+        return contextStream;
+    }
+
+    BlockProvider *parentProvider = this->parent;
+
+    if ( parentProvider )
+    {
+        return parentProvider->getRootStream();
+    }
+
+    return NULL;
+}
+
 // Meta-data API.
 void BlockProvider::setBlockID( uint32 id )
 {
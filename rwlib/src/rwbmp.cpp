@@ -21,7 +21,7 @@ void Bitmap::setSize( uint32 width, uint32 height )
 
     if ( dataSize != 0 )
     {
-        newTexels = new uint8[ dataSize ];
+        newTexels = PixelAllocateUnbound( dataSize );
 
         eRasterFormat rasterFormat = this->rasterFormat;
         eColorOrdering colorOrder = this->colorOrder;
@@ -74,7 +74,7 @@ void Bitmap::setSize( uint32 width, uint32 height )
     // Delete old data.
     if ( oldTexels )
     {
-        delete [] oldTexels;
+        PixelFreeUnbound( oldTexels );
     }
 
     // Set new data.
@@ -291,6 +291,111 @@ bool Bitmap::browsecolorex(uint32 x, uint32 y, abstractColorItem& colorItem) con
     return hasColor;
 }
 
+inline bool isValidRowColorOrder( eColorOrdering colorOrder )
+{
+    return ( colorOrder == COLOR_RGBA || colorOrder == COLOR_BGRA );
+}
+
+bool Bitmap::fetchrow(uint32 x, uint32 y, uint32 count, void *colorsOut, eColorOrdering colorOrder) const
+{
+    if ( !isValidRowColorOrder( colorOrder ) )
+    {
+        throw RwException( "invalid color ordering for bitmap row fetch" );
+    }
+
+    uint32 width = this->width;
+
+    if ( y >= this->height || x > width || count > width - x )
+        return false;
+
+    const void *srcRow = getConstTexelDataRow( this->texels, this->rowSize, y );
+
+    // Most formats have a specialized kernel.
+    texelRowKernel_t rowKernel = GetTexelRowKernel( this->rasterFormat, this->depth, this->colorOrder, RASTER_8888, 32, colorOrder );
+
+    if ( rowKernel )
+    {
+        rowKernel( srcRow, colorsOut, x, 0, count );
+
+        return true;
+    }
+
+    colorModelDispatcher <const void> fetchDispatch( this->rasterFormat, this->colorOrder, this->depth, NULL, 0, PALETTE_NONE );
+
+    uint8 *dstColors = (uint8*)colorsOut;
+
+    for ( uint32 n = 0; n < count; n++ )
+    {
+        uint8 red, green, blue, alpha;
+
+        bool hasColor = fetchDispatch.getRGBA( srcRow, x + n, red, green, blue, alpha );
+
+        if ( !hasColor )
+            return false;
+
+        uint8 *dstColor = ( dstColors + n * 4 );
+
+        if ( colorOrder == COLOR_RGBA )
+        {
+            dstColor[0] = red;
+            dstColor[2] = blue;
+        }
+        else
+        {
+            dstColor[0] = blue;
+            dstColor[2] = red;
+        }
+
+        dstColor[1] = green;
+        dstColor[3] = alpha;
+    }
+
+    return true;
+}
+
+bool Bitmap::storerow(uint32 x, uint32 y, uint32 count, const void *colorsIn, eColorOrdering colorOrder)
+{
+    if ( !isValidRowColorOrder( colorOrder ) )
+    {
+        throw RwException( "invalid color ordering for bitmap row store" );
+    }
+
+    uint32 width = this->width;
+
+    if ( y >= this->height || x > width || count > width - x )
+        return false;
+
+    void *dstRow = getTexelDataRow( this->texels, this->rowSize, y );
+
+    texelRowKernel_t rowKernel = GetTexelRowKernel( RASTER_8888, 32, colorOrder, this->rasterFormat, this->depth, this->colorOrder );
+
+    if ( rowKernel )
+    {
+        rowKernel( colorsIn, dstRow, 0, x, count );
+
+        return true;
+    }
+
+    colorModelDispatcher <void> putDispatch( this->rasterFormat, this->colorOrder, this->depth, NULL, 0, PALETTE_NONE );
+
+    const uint8 *srcColors = (const uint8*)colorsIn;
+
+    for ( uint32 n = 0; n < count; n++ )
+    {
+        const uint8 *srcColor = ( srcColors + n * 4 );
+
+        uint8 red = ( colorOrder == COLOR_RGBA ) ? srcColor[0] : srcColor[2];
+        uint8 blue = ( colorOrder == COLOR_RGBA ) ? srcColor[2] : srcColor[0];
+
+        bool couldSet = putDispatch.setRGBA( dstRow, x + n, red, srcColor[1], blue, srcColor[3] );
+
+        if ( !couldSet )
+            return false;
+    }
+
+    return true;
+}
+
 void Bitmap::draw(
     sourceColorPipeline& colorSource, uint32 offX, uint32 offY, uint32 drawWidth, uint32 drawHeight,
     eShadeMode srcChannel, eShadeMode dstChannel, eBlendMode blendMode
@@ -10,34 +10,50 @@ rwConfigBlock::rwConfigBlock( EngineInterface *intf )
 {
     this->engineInterface = intf;
 
+    rwConfigSnapshot *cfg = new rwConfigSnapshot;
+
     // We default to the San Andreas engine.
-    this->version = KnownVersions::getGameVersion( KnownVersions::SA );
+    cfg->version = KnownVersions::getGameVersion( KnownVersions::SA );
 
     // Setup standard members.
-    this->customFileInterface = NULL;
+    cfg->customFileInterface = NULL;
 
-    this->warningManager = NULL;
-    this->warningLevel = 3;
-    this->ignoreSecureWarnings = true;
+    cfg->warningManager = NULL;
+    cfg->warningLevel = 3;
+    cfg->ignoreSecureWarnings = true;
 
     // Only use the native toolchain.
-    this->palRuntimeType = PALRUNTIME_NATIVE;
+    cfg->palRuntimeType = PALRUNTIME_NATIVE;
 
     // Prefer the native toolchain.
-    this->dxtRuntimeType = DXTRUNTIME_NATIVE;
+    cfg->dxtRuntimeType = DXTRUNTIME_NATIVE;
+
+    // Let the runtime decide how many threads to compress with.
+    cfg->dxtCompressionWorkerCount = 0;
+
+    // Spread texel work of big textures across all logical processors.
+    cfg->workerPoolSize = 0;
+    cfg->parallelTexelThreshold = 65536;
+    cfg->parallelBandTexelCount = 65536;
+
+    cfg->fixIncompatibleRasters = true;
+    cfg->dxtPackedDecompression = false;
+
+    cfg->compatibilityTransformNativeImaging = false;
+    cfg->preferPackedSampleExport = true;
 
-    this->fixIncompatibleRasters = true;
-    this->dxtPackedDecompression = false;
+    cfg->ignoreSerializationBlockRegions = false;
 
-    this->compatibilityTransformNativeImaging = false;
-    this->preferPackedSampleExport = true;
+    cfg->lazyTexelLoading = false;
 
-    this->ignoreSerializationBlockRegions = false;
+    cfg->enableMetaDataTagging = true;
 
-    this->enableMetaDataTagging = true;
+    this->currentSnapshot.store( cfg, std::memory_order_release );
+    this->foreignReaderCount.store( 0, std::memory_order_relaxed );
 
     // Set per-thread states.
     this->enableThreadedConfig = false;
+    this->redirectedConfig = NULL;
 }
 
 rwlock* rwConfigBlock::GetConfigLock( void ) const
@@ -54,228 +70,385 @@ rwlock* rwConfigBlock::GetConfigLock( void ) const
 
 rwConfigBlock::rwConfigBlock( const rwConfigBlock& right )
 {
-    scoped_rwlock_reader <rwlock> cfgConsistency( right.GetConfigLock() );
-
     this->engineInterface = right.engineInterface;
-        
-    this->version = right.version;
 
-    this->customFileInterface = right.customFileInterface;
+    // Snapshots are immutable, so a plain copy of the current one is consistent.
+    this->currentSnapshot.store( CopySnapshotFrom( right ), std::memory_order_release );
+    this->foreignReaderCount.store( 0, std::memory_order_relaxed );
 
-    this->warningManager = right.warningManager;
+    // Copy per-thread states.
+    this->enableThreadedConfig = right.enableThreadedConfig;
 
-    this->palRuntimeType = right.palRuntimeType;
-    this->dxtRuntimeType = right.dxtRuntimeType;
+    // Redirection is bound to what the thread is currently doing.
+    this->redirectedConfig = NULL;
+}
 
-    this->warningLevel = right.warningLevel;
-    this->ignoreSecureWarnings = right.ignoreSecureWarnings;
+rwConfigBlock::~rwConfigBlock( void )
+{
+    delete this->currentSnapshot.load( std::memory_order_relaxed );
 
-    this->fixIncompatibleRasters = right.fixIncompatibleRasters;
-    this->dxtPackedDecompression = right.dxtPackedDecompression;
+    for ( const rwConfigSnapshot *oldSnapshot : this->retiredSnapshots )
+    {
+        delete oldSnapshot;
+    }
+}
 
-    this->compatibilityTransformNativeImaging = right.compatibilityTransformNativeImaging;
-    this->preferPackedSampleExport = right.preferPackedSampleExport;
+rwConfigBlock& rwConfigBlock::operator = ( const rwConfigBlock& right )
+{
+    rwConfigSnapshot *cfg = CopySnapshotFrom( right );
 
-    this->ignoreSerializationBlockRegions = right.ignoreSerializationBlockRegions;
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->enableMetaDataTagging = right.enableMetaDataTagging;
+    PublishSnapshot( cfg );
 
-    // Copy per-thread states.
     this->enableThreadedConfig = right.enableThreadedConfig;
+
+    return *this;
 }
 
-rwConfigBlock::~rwConfigBlock( void )
+rwConfigSnapshot* rwConfigBlock::CopySnapshot( void ) const
+{
+    return new rwConfigSnapshot( *this->currentSnapshot.load( std::memory_order_acquire ) );
+}
+
+rwConfigSnapshot* rwConfigBlock::CopySnapshotFrom( const rwConfigBlock& right )
+{
+    // Writers free replaced snapshots while they hold the lock, so it keeps the current one alive.
+    scoped_rwlock_reader <rwlock> lock( right.GetConfigLock() );
+
+    return right.CopySnapshot();
+}
+
+void rwConfigBlock::PublishSnapshot( rwConfigSnapshot *newSnapshot )
 {
-    return;
+    const rwConfigSnapshot *oldSnapshot = this->currentSnapshot.exchange( newSnapshot, std::memory_order_acq_rel );
+
+    this->retiredSnapshots.push_back( oldSnapshot );
+
+    // Getters are a plain load, so we have to know when nobody could still look at a replaced snapshot.
+    // A per-thread block is only read by its thread and by the jobs that it waits for; the jobs are
+    // counted as foreign readers. So if its own thread publishes while no job reads, we are at a
+    // quiescent point. The global block is read by any thread at any time, hence its snapshots are
+    // kept until it is destroyed; it is only changed when applications set up the engine.
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( this->foreignReaderCount.load( std::memory_order_acquire ) == 0 &&
+         IsCurrentThreadConfigBlock( this->engineInterface, this ) )
+    {
+        for ( const rwConfigSnapshot *retiredSnapshot : this->retiredSnapshots )
+        {
+            delete retiredSnapshot;
+        }
+
+        this->retiredSnapshots.clear();
+    }
+}
+
+void rwConfigBlock::AddForeignReader( void )
+{
+    this->foreignReaderCount.fetch_add( 1, std::memory_order_relaxed );
+
+    // Pairs with the fence in PublishSnapshot: either the writer sees us or we see its new snapshot.
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+}
+
+void rwConfigBlock::RemoveForeignReader( void )
+{
+    this->foreignReaderCount.fetch_sub( 1, std::memory_order_release );
 }
 
 void rwConfigBlock::SetVersion( LibraryVersion ver )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->version = ver;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->version = ver;
+
+    PublishSnapshot( cfg );
 }
 
 LibraryVersion rwConfigBlock::GetVersion( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->version;
+    return ReadSnapshot( &rwConfigSnapshot::version );
 }
 
 void rwConfigBlock::SetMetaDataTagging( bool enable )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
+    rwConfigSnapshot *cfg = CopySnapshot();
+
     // Meta data tagging is useful so that people will find you if they need to (debugging, etc).
-    this->enableMetaDataTagging = enable;
+    cfg->enableMetaDataTagging = enable;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetMetaDataTagging( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->enableMetaDataTagging;
+    return ReadSnapshot( &rwConfigSnapshot::enableMetaDataTagging );
 }
 
 void rwConfigBlock::SetWarningManager( WarningManagerInterface *intf )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->warningManager = intf;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->warningManager = intf;
+
+    PublishSnapshot( cfg );
 }
 
 WarningManagerInterface* rwConfigBlock::GetWarningManager( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->warningManager;
+    return ReadSnapshot( &rwConfigSnapshot::warningManager );
 }
 
 void rwConfigBlock::SetWarningLevel( int level )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->warningLevel = level;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->warningLevel = level;
+
+    PublishSnapshot( cfg );
 }
 
 int rwConfigBlock::GetWarningLevel( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->warningLevel;
+    return ReadSnapshot( &rwConfigSnapshot::warningLevel );
 }
 
 void rwConfigBlock::SetIgnoreSecureWarnings( bool ignore )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->ignoreSecureWarnings = ignore;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->ignoreSecureWarnings = ignore;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetIgnoreSecureWarnings( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->ignoreSecureWarnings;
+    return ReadSnapshot( &rwConfigSnapshot::ignoreSecureWarnings );
 }
 
 bool rwConfigBlock::SetPaletteRuntime( ePaletteRuntimeType palRunType )
 {
-    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
-
     // Make sure we support this runtime.
     bool success = false;
 
-    if ( palRunType == PALRUNTIME_NATIVE )
+    if ( palRunType == PALRUNTIME_NATIVE || palRunType == PALRUNTIME_MEDIANCUT )
     {
-        // We always support the native palette system.
-        this->palRuntimeType = palRunType;
-
+        // We always support the native palette systems.
         success = true;
     }
 #ifdef RWLIB_INCLUDE_LIBIMAGEQUANT
     else if ( palRunType == PALRUNTIME_PNGQUANT )
     {
         // Depends on whether we compiled with support for it.
-        this->palRuntimeType = palRunType;
-
         success = true;
     }
 #endif //RWLIB_INCLUDE_LIBIMAGEQUANT
 
+    if ( success )
+    {
+        scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+        rwConfigSnapshot *cfg = CopySnapshot();
+
+        cfg->palRuntimeType = palRunType;
+
+        PublishSnapshot( cfg );
+    }
+
     return success;
 }
 
 ePaletteRuntimeType rwConfigBlock::GetPaletteRuntime( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->palRuntimeType;
+    return ReadSnapshot( &rwConfigSnapshot::palRuntimeType );
 }
 
 void rwConfigBlock::SetDXTRuntime( eDXTCompressionMethod method )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
-    
-    this->dxtRuntimeType = method;
+
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->dxtRuntimeType = method;
+
+    PublishSnapshot( cfg );
 }
 
 eDXTCompressionMethod rwConfigBlock::GetDXTRuntime( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+    return ReadSnapshot( &rwConfigSnapshot::dxtRuntimeType );
+}
+
+void rwConfigBlock::SetDXTCompressionWorkerCount( uint32 workerCount )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->dxtCompressionWorkerCount = workerCount;
 
-    return this->dxtRuntimeType;
+    PublishSnapshot( cfg );
+}
+
+uint32 rwConfigBlock::GetDXTCompressionWorkerCount( void ) const
+{
+    return ReadSnapshot( &rwConfigSnapshot::dxtCompressionWorkerCount );
+}
+
+void rwConfigBlock::SetWorkerPoolSize( uint32 poolSize )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->workerPoolSize = poolSize;
+
+    PublishSnapshot( cfg );
+}
+
+uint32 rwConfigBlock::GetWorkerPoolSize( void ) const
+{
+    return ReadSnapshot( &rwConfigSnapshot::workerPoolSize );
+}
+
+void rwConfigBlock::SetParallelTexelThreshold( uint32 texelCount )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->parallelTexelThreshold = texelCount;
+
+    PublishSnapshot( cfg );
+}
+
+uint32 rwConfigBlock::GetParallelTexelThreshold( void ) const
+{
+    return ReadSnapshot( &rwConfigSnapshot::parallelTexelThreshold );
+}
+
+void rwConfigBlock::SetParallelBandTexelCount( uint32 texelCount )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->parallelBandTexelCount = texelCount;
+
+    PublishSnapshot( cfg );
+}
+
+uint32 rwConfigBlock::GetParallelBandTexelCount( void ) const
+{
+    return ReadSnapshot( &rwConfigSnapshot::parallelBandTexelCount );
 }
 
 void rwConfigBlock::SetFixIncompatibleRasters( bool enable )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->fixIncompatibleRasters = enable;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->fixIncompatibleRasters = enable;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetFixIncompatibleRasters( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->fixIncompatibleRasters;
+    return ReadSnapshot( &rwConfigSnapshot::fixIncompatibleRasters );
 }
 
 void rwConfigBlock::SetDXTPackedDecompression( bool enable )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->dxtPackedDecompression = enable;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->dxtPackedDecompression = enable;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetDXTPackedDecompression( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->dxtPackedDecompression;
+    return ReadSnapshot( &rwConfigSnapshot::dxtPackedDecompression );
 }
 
 void rwConfigBlock::SetCompatTransformNativeImaging( bool transfEnable )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->compatibilityTransformNativeImaging = transfEnable;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->compatibilityTransformNativeImaging = transfEnable;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetCompatTransformNativeImaging( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->compatibilityTransformNativeImaging;
+    return ReadSnapshot( &rwConfigSnapshot::compatibilityTransformNativeImaging );
 }
 
 void rwConfigBlock::SetPreferPackedSampleExport( bool preferPacked )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->preferPackedSampleExport = preferPacked;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->preferPackedSampleExport = preferPacked;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetPreferPackedSampleExport( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    return this->preferPackedSampleExport;
+    return ReadSnapshot( &rwConfigSnapshot::preferPackedSampleExport );
 }
 
 void rwConfigBlock::SetIgnoreSerializationBlockRegions( bool ignore )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->ignoreSerializationBlockRegions = ignore;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->ignoreSerializationBlockRegions = ignore;
+
+    PublishSnapshot( cfg );
 }
 
 bool rwConfigBlock::GetIgnoreSerializationBlockRegions( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+    return ReadSnapshot( &rwConfigSnapshot::ignoreSerializationBlockRegions );
+}
+
+void rwConfigBlock::SetLazyTexelLoading( bool enable )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    rwConfigSnapshot *cfg = CopySnapshot();
 
-    return this->ignoreSerializationBlockRegions;
+    cfg->lazyTexelLoading = enable;
+
+    PublishSnapshot( cfg );
+}
+
+bool rwConfigBlock::GetLazyTexelLoading( void ) const
+{
+    return ReadSnapshot( &rwConfigSnapshot::lazyTexelLoading );
 }
 
 rwConfigEnvRegister_t rwConfigEnvRegister;
@@ -147,6 +147,11 @@ rwConfigBlock& GetEnvironmentConfigBlock( EngineInterface *engineInterface )
         {
             rwConfigBlock *cfgBlock = cfgEnv->GetThreadConfig( curThread );
 
+            if ( cfgBlock && cfgBlock->redirectedConfig )
+            {
+                return *cfgBlock->redirectedConfig;
+            }
+
             if ( cfgBlock && cfgBlock->enableThreadedConfig )
             {
                 return *cfgBlock;
@@ -177,6 +182,11 @@ const rwConfigBlock& GetConstEnvironmentConfigBlock( const EngineInterface *engi
         {
             const rwConfigBlock *cfgBlock = cfgEnv->GetConstThreadConfig( curThread );
 
+            if ( cfgBlock && cfgBlock->redirectedConfig )
+            {
+                return *cfgBlock->redirectedConfig;
+            }
+
             if ( cfgBlock && cfgBlock->enableThreadedConfig )
             {
                 return *cfgBlock;
@@ -266,6 +276,69 @@ void ReleaseThreadedRuntimeConfig( Interface *intf )
     // Success!
 }
 
+rwConfigBlock* RedirectThreadConfigBlock( EngineInterface *engineInterface, rwConfigBlock *cfgBlock )
+{
+    rwConfigDispatchEnv *cfgDispatch = rwConfigDispatchEnvRegister.GetPluginStruct( engineInterface );
+
+    if ( !cfgDispatch )
+        return NULL;
+
+    CExecutiveManager *nativeMan = GetNativeExecutive( engineInterface );
+
+    if ( !nativeMan )
+        return NULL;
+
+    CExecThread *curThread = nativeMan->GetCurrentThread();
+
+    if ( !curThread )
+        return NULL;
+
+    rwConfigBlock *threadedCfg = cfgDispatch->GetThreadConfig( curThread );
+
+    if ( !threadedCfg )
+        return NULL;
+
+    rwConfigBlock *prevRedirect = threadedCfg->redirectedConfig;
+
+    // Do not redirect to ourselves.
+    rwConfigBlock *newRedirect = ( cfgBlock != threadedCfg ? cfgBlock : NULL );
+
+    // We read the other block while its thread could change it.
+    if ( newRedirect )
+    {
+        newRedirect->AddForeignReader();
+    }
+
+    threadedCfg->redirectedConfig = newRedirect;
+
+    if ( prevRedirect )
+    {
+        prevRedirect->RemoveForeignReader();
+    }
+
+    return prevRedirect;
+}
+
+bool IsCurrentThreadConfigBlock( const EngineInterface *engineInterface, const rwConfigBlock *cfgBlock )
+{
+    const rwConfigDispatchEnv *cfgDispatch = rwConfigDispatchEnvRegister.GetConstPluginStruct( engineInterface );
+
+    if ( !cfgDispatch )
+        return false;
+
+    CExecutiveManager *nativeMan = GetNativeExecutive( engineInterface );
+
+    if ( !nativeMan )
+        return false;
+
+    CExecThread *curThread = nativeMan->GetCurrentThread();
+
+    if ( !curThread )
+        return false;
+
+    return ( cfgDispatch->GetConstThreadConfig( curThread ) == cfgBlock );
+}
+
 void registerConfigurationBlockDispatching( void )
 {
     rwConfigDispatchEnvRegister.RegisterPlugin( engineFactory );
@@ -6,6 +6,40 @@
 namespace rw
 {
 
+// Immutable set of configuration values.
+// A config block never changes a published snapshot; it publishes a modified copy instead,
+// so getters do not have to lock.
+struct rwConfigSnapshot
+{
+    LibraryVersion version;     // version of the output files (III, VC, SA, Manhunt, ...)
+
+    FileInterface *customFileInterface;
+
+    WarningManagerInterface *warningManager;
+
+    ePaletteRuntimeType palRuntimeType;
+    eDXTCompressionMethod dxtRuntimeType;
+    uint32 dxtCompressionWorkerCount;
+
+    uint32 workerPoolSize;
+    uint32 parallelTexelThreshold;
+    uint32 parallelBandTexelCount;
+
+    int warningLevel;
+    bool ignoreSecureWarnings;
+
+    bool fixIncompatibleRasters;
+    bool dxtPackedDecompression;
+
+    bool compatibilityTransformNativeImaging;
+    bool preferPackedSampleExport;
+
+    bool ignoreSerializationBlockRegions;
+    bool lazyTexelLoading;
+
+    bool enableMetaDataTagging;
+};
+
 struct rwConfigBlock
 {
     rwConfigBlock( EngineInterface *intf );
@@ -13,6 +47,8 @@ struct rwConfigBlock
 
     ~rwConfigBlock( void );
 
+    rwConfigBlock&              operator = ( const rwConfigBlock& right );
+
     rwlock* GetConfigLock( void ) const;
 
     // Thread-Safe access to this object.
@@ -40,6 +76,18 @@ struct rwConfigBlock
     void                        SetDXTRuntime( eDXTCompressionMethod method );
     eDXTCompressionMethod       GetDXTRuntime( void ) const;
 
+    void                        SetDXTCompressionWorkerCount( uint32 workerCount );
+    uint32                      GetDXTCompressionWorkerCount( void ) const;
+
+    void                        SetWorkerPoolSize( uint32 poolSize );
+    uint32                      GetWorkerPoolSize( void ) const;
+
+    void                        SetParallelTexelThreshold( uint32 texelCount );
+    uint32                      GetParallelTexelThreshold( void ) const;
+
+    void                        SetParallelBandTexelCount( uint32 texelCount );
+    uint32                      GetParallelBandTexelCount( void ) const;
+
     void                        SetFixIncompatibleRasters( bool doFix );
     bool                        GetFixIncompatibleRasters( void ) const;
 
@@ -55,34 +103,42 @@ struct rwConfigBlock
     void                        SetIgnoreSerializationBlockRegions( bool doIgnore );
     bool                        GetIgnoreSerializationBlockRegions( void ) const;
 
+    void                        SetLazyTexelLoading( bool enable );
+    bool                        GetLazyTexelLoading( void ) const;
+
+    // Threads that read this block on behalf of the thread that owns it (see RedirectThreadConfigBlock)
+    // are counted for as long as they do.
+    void                        AddForeignReader( void );
+    void                        RemoveForeignReader( void );
+
     EngineInterface *engineInterface;
 
 private:
-    LibraryVersion version;     // version of the output files (III, VC, SA, Manhunt, ...)
+    // Writers have to hold the config lock.
+    rwConfigSnapshot*           CopySnapshot( void ) const;
+    void                        PublishSnapshot( rwConfigSnapshot *newSnapshot );
 
-    FileInterface *customFileInterface;
-
-    WarningManagerInterface *warningManager;
+    // Takes the config lock of the other block.
+    static rwConfigSnapshot*    CopySnapshotFrom( const rwConfigBlock& right );
 
-    ePaletteRuntimeType palRuntimeType;
-    eDXTCompressionMethod dxtRuntimeType;
-    
-    int warningLevel;
-    bool ignoreSecureWarnings;
-
-    bool fixIncompatibleRasters;
-    bool dxtPackedDecompression;
+    template <typename fieldType>
+    inline fieldType ReadSnapshot( fieldType rwConfigSnapshot::*field ) const
+    {
+        return this->currentSnapshot.load( std::memory_order_acquire )->*field;
+    }
 
-    bool compatibilityTransformNativeImaging;
-    bool preferPackedSampleExport;
+    std::atomic <const rwConfigSnapshot*> currentSnapshot;
 
-    bool ignoreSerializationBlockRegions;
+    std::atomic <uint32> foreignReaderCount;
 
-    bool enableMetaDataTagging;
+    // Replaced snapshots that readers might still look at.
+    // They are deleted at the next quiescent point (see PublishSnapshot) or with the block.
+    std::vector <const rwConfigSnapshot*> retiredSnapshots;
 
 public:
     // Per-Thread config states (only valid if accessed from thread).
     bool enableThreadedConfig;
+    rwConfigBlock *redirectedConfig;    // configuration of the thread that we work for, if any
 };
 
 struct cfg_block_constructor
@@ -162,4 +218,11 @@ extern rwConfigEnvRegister_t rwConfigEnvRegister;
 rwConfigBlock& GetEnvironmentConfigBlock( EngineInterface *engineInterface );
 const rwConfigBlock& GetConstEnvironmentConfigBlock( const EngineInterface *engineInterface );
 
+// Makes the current thread use another configuration block until it is redirected back.
+// Returns the previous redirection target (NULL if there was none).
+rwConfigBlock* RedirectThreadConfigBlock( EngineInterface *engineInterface, rwConfigBlock *cfgBlock );
+
+// Returns whether the block is the per-thread block of the current thread.
+bool IsCurrentThreadConfigBlock( const EngineInterface *engineInterface, const rwConfigBlock *cfgBlock );
+
 };
\ No newline at end of file
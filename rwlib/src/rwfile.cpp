@@ -79,14 +79,16 @@ void rwConfigBlock::SetFileInterface( FileInterface *intf )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
 
-    this->customFileInterface = intf;
+    rwConfigSnapshot *cfg = CopySnapshot();
+
+    cfg->customFileInterface = intf;
+
+    PublishSnapshot( cfg );
 }
 
 FileInterface* rwConfigBlock::GetFileInterface( void ) const
 {
-    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
-
-    FileInterface *ourInterface = this->customFileInterface;
+    FileInterface *ourInterface = ReadSnapshot( &rwConfigSnapshot::customFileInterface );
 
     if ( ourInterface == NULL )
     {
@@ -50,12 +50,17 @@ static const imaging_filename_ext bmp_ext[] =
     { "BMP", true }
 };
 
+static const imagingFormatSignature bmp_sig[] =
+{
+    { "BM", 2 }
+};
+
 struct bmpImagingEnv : public imagingFormatExtension
 {
     inline void Initialize( Interface *engineInterface )
     {
         // Register ourselves.
-        RegisterImagingFormat( engineInterface, "Raw Bitmap", IMAGING_COUNT_EXT(bmp_ext), bmp_ext, this );
+        RegisterImagingFormat( engineInterface, "Raw Bitmap", IMAGING_COUNT_EXT(bmp_ext), bmp_ext, IMAGING_COUNT_EXT(bmp_sig), bmp_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
@@ -145,6 +145,8 @@ struct rwImagingEnv
         const char *formatName;
         uint32 num_ext;
         const imaging_filename_ext *ext_array;
+        uint32 num_sig;
+        const imagingFormatSignature *sig_array;
         imagingFormatExtension *intf;
     };
 
@@ -152,52 +154,128 @@ struct rwImagingEnv
 
     formatList_t registeredFormats;
 
-    inline bool Deserialize( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& layerOut ) const
+    // Signatures of all registered formats, indexed by their first byte.
+    struct registeredSignature
     {
-        // Loop through all imaging extensions and check which one identifies with the given stream.
-        // For the one that identifies with it, try to deserialize the picture data with it.
-        const int64 rasterStreamPos = inputStream->tell();
+        imagingFormatSignature signature;
+        const registeredExtension *format;
+    };
 
-        const imagingFormatExtension *supportedExt = NULL;
+    typedef std::vector <registeredSignature> signatureList_t;
+
+    signatureList_t signaturesByLeadByte[ 256 ];
 
+    inline void RegisterSignatures( const registeredExtension& regExt, uint32 num_sig, const imagingFormatSignature *sig_array )
+    {
+        for ( uint32 n = 0; n < num_sig; n++ )
         {
-            bool needsPositionReset = false;
+            const imagingFormatSignature& sig = sig_array[ n ];
 
-            for ( rwImagingEnv::formatList_t::const_iterator iter = this->registeredFormats.cbegin(); iter != this->registeredFormats.cend(); iter++ )
-            {
-                if ( needsPositionReset )
-                {
-                    inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
-                
-                    needsPositionReset = false;
-                }
+            registeredSignature regSig;
+            regSig.signature = sig;
+            regSig.format = &regExt;
 
-                // Ask the imaging extension for support.
-                const imagingFormatExtension *imgExt = (*iter).second.intf;
+            this->signaturesByLeadByte[ (unsigned char)sig.bytes[ 0 ] ].push_back( regSig );
+        }
+    }
+
+    inline void UnregisterSignatures( const registeredExtension& regExt )
+    {
+        for ( uint32 n = 0; n < regExt.num_sig; n++ )
+        {
+            signatureList_t& sigList = this->signaturesByLeadByte[ (unsigned char)regExt.sig_array[ n ].bytes[ 0 ] ];
 
-                bool hasSupport = false;
+            signatureList_t::iterator iter = sigList.begin();
 
-                try
+            while ( iter != sigList.end() )
+            {
+                if ( (*iter).format == &regExt )
                 {
-                    hasSupport = imgExt->IsStreamCompatible( engineInterface, inputStream );
+                    iter = sigList.erase( iter );
                 }
-                catch( RwException& )
+                else
                 {
-                    // We do not have support, I guess.
-                    hasSupport = false;
+                    iter++;
                 }
+            }
+        }
+    }
 
-                if ( hasSupport )
+    // Finds the format of the stream at its current position; the position is restored afterwards.
+    // If allowStructuralProbing is false, only formats with a signature are considered.
+    inline const registeredExtension* IdentifyFormat( Interface *engineInterface, Stream *inputStream, bool allowStructuralProbing ) const
+    {
+        const int64 rasterStreamPos = inputStream->tell();
+
+        // Read the beginning of the stream only once and look it up by its first byte.
+        unsigned char prefix[ IMAGING_MAX_SIGNATURE_SIZE ];
+
+        size_t prefixSize = inputStream->read( prefix, sizeof( prefix ) );
+
+        inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
+
+        if ( prefixSize != 0 )
+        {
+            const signatureList_t& sigList = this->signaturesByLeadByte[ prefix[ 0 ] ];
+
+            for ( signatureList_t::const_iterator iter = sigList.cbegin(); iter != sigList.cend(); iter++ )
+            {
+                const imagingFormatSignature& sig = (*iter).signature;
+
+                if ( sig.byteCount <= prefixSize && memcmp( prefix, sig.bytes, sig.byteCount ) == 0 )
                 {
-                    supportedExt = imgExt;
-                    break;
+                    return (*iter).format;
                 }
+            }
+        }
+
+        if ( !allowStructuralProbing )
+            return NULL;
+
+        // Last resort: ask the formats that have no magic number.
+        for ( rwImagingEnv::formatList_t::const_iterator iter = this->registeredFormats.cbegin(); iter != this->registeredFormats.cend(); iter++ )
+        {
+            const registeredExtension& regExt = (*iter).second;
+
+            if ( regExt.num_sig != 0 )
+                continue;
+
+            bool hasSupport = false;
+
+            try
+            {
+                hasSupport = regExt.intf->IsStreamCompatible( engineInterface, inputStream );
+            }
+            catch( RwException& )
+            {
+                // We do not have support, I guess.
+                hasSupport = false;
+            }
+
+            inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
 
-                // We continue searching.
-                needsPositionReset = true;
+            if ( hasSupport )
+            {
+                return &regExt;
             }
         }
 
+        return NULL;
+    }
+
+    inline bool Deserialize( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& layerOut ) const
+    {
+        // Find the imaging extension that identifies with the given stream.
+        // Formats with a matching signature get the stream directly; if it turns out broken, they throw.
+        const int64 rasterStreamPos = inputStream->tell();
+
+        const imagingFormatExtension *supportedExt = NULL;
+
+        if ( const registeredExtension *regExt = IdentifyFormat( engineInterface, inputStream, true ) )
+        {
+            supportedExt = regExt->intf;
+        }
+
         // If we have a valid supported extension, try to fetch it's pixel data and put it into a Bitmap.
         if ( supportedExt != NULL )
         {
@@ -595,11 +673,27 @@ bool SerializeImage( Stream *outputStream, const char *formatDescriptor, const B
     return success;
 }
 
-bool RegisterImagingFormat( Interface *engineInterface, const char *formatName, uint32 num_ext, const imaging_filename_ext *ext_array, imagingFormatExtension *intf )
+bool RegisterImagingFormat(
+    Interface *engineInterface, const char *formatName,
+    uint32 num_ext, const imaging_filename_ext *ext_array,
+    uint32 num_sig, const imagingFormatSignature *sig_array,
+    imagingFormatExtension *intf
+)
 {
     bool success = false;
 
 #ifdef RWLIB_INCLUDE_IMAGING
+    // Signatures have to fit into the prefix that is read for identification.
+    for ( uint32 n = 0; n < num_sig; n++ )
+    {
+        uint32 sigSize = sig_array[ n ].byteCount;
+
+        if ( sigSize == 0 || sigSize > IMAGING_MAX_SIGNATURE_SIZE )
+        {
+            return false;
+        }
+    }
+
     if ( rwImagingEnv *imgEnv = GetImagingEnvironment( engineInterface ) )
     {
         // If we do not have a plugin with that name already, we register it.
@@ -612,9 +706,14 @@ bool RegisterImagingFormat( Interface *engineInterface, const char *formatName,
             newExt.formatName = formatName;
             newExt.num_ext = num_ext;
             newExt.ext_array = ext_array;
+            newExt.num_sig = num_sig;
+            newExt.sig_array = sig_array;
             newExt.intf = intf;
 
-            imgEnv->registeredFormats[ formatName ] = newExt;
+            // Map nodes keep their address, so the signature index can point to them.
+            const rwImagingEnv::registeredExtension& regExt = ( imgEnv->registeredFormats[ formatName ] = newExt );
+
+            imgEnv->RegisterSignatures( regExt, num_sig, sig_array );
 
             success = true;
         }
@@ -640,6 +739,8 @@ bool UnregisterImagingFormat( Interface *engineInterface, imagingFormatExtension
             if ( regExt.intf == intf )
             {
                 // Remove us.
+                imgEnv->UnregisterSignatures( regExt );
+
                 imgEnv->registeredFormats.erase( iter );
 
                 success = true;
@@ -669,6 +770,24 @@ bool IsImagingFormatAvailable( Interface *engineInterface, const char *formatDes
     return false;
 }
 
+// Public function to identify the imaging format of a stream without deserializing it.
+const char* IdentifyImagingFormat( Stream *inputStream, bool allowStructuralProbing )
+{
+#ifdef RWLIB_INCLUDE_IMAGING
+    Interface *engineInterface = inputStream->engineInterface;
+
+    if ( const rwImagingEnv *imgEnv = GetImagingEnvironment( engineInterface ) )
+    {
+        if ( const rwImagingEnv::registeredExtension *regExt = imgEnv->IdentifyFormat( engineInterface, inputStream, allowStructuralProbing ) )
+        {
+            return regExt->formatName;
+        }
+    }
+#endif //RWLIB_INCLUDE_IMAGING
+
+    return NULL;
+}
+
 // Public function to get all registered imaging formats.
 void GetRegisteredImageFormats( Interface *engineInterface, registered_image_formats_t& formatsOut )
 {
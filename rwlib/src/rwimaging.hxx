@@ -41,8 +41,24 @@ struct imagingFormatExtension abstract
 
 #define IMAGING_COUNT_EXT(x)    ( sizeof(x) / sizeof(*x) )
 
+// Bytes that every stream of an imaging format starts with (its magic number).
+// Streams whose beginning matches a signature are handed to that format directly.
+// Formats without a signature (like TGA) are probed with IsStreamCompatible if no signature matches.
+struct imagingFormatSignature
+{
+    const char *bytes;
+    uint32 byteCount;
+};
+
+#define IMAGING_MAX_SIGNATURE_SIZE  16
+
 // Function to register new imaging formats.
-bool RegisterImagingFormat( Interface *engineInterface, const char *formatName, uint32 num_ext, const imaging_filename_ext *ext_array, imagingFormatExtension *intf );
+bool RegisterImagingFormat(
+    Interface *engineInterface, const char *formatName,
+    uint32 num_ext, const imaging_filename_ext *ext_array,
+    uint32 num_sig, const imagingFormatSignature *sig_array,
+    imagingFormatExtension *intf
+);
 bool UnregisterImagingFormat( Interface *engineInterface, imagingFormatExtension *intf );
 
 }
\ No newline at end of file
@@ -26,6 +26,11 @@ static const imaging_filename_ext jpeg_ext[] =
     { "JPG", true }
 };
 
+static const imagingFormatSignature jpeg_sig[] =
+{
+    { "\xFF\xD8", 2 }
+};
+
 // JPEG compliant serialization library for RenderWare.
 struct jpegImagingExtension : public imagingFormatExtension
 {
@@ -772,7 +777,7 @@ struct jpegImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Joint Photographic Experts Group", IMAGING_COUNT_EXT(jpeg_ext), jpeg_ext, this );
+        RegisterImagingFormat( engineInterface, "Joint Photographic Experts Group", IMAGING_COUNT_EXT(jpeg_ext), jpeg_ext, IMAGING_COUNT_EXT(jpeg_sig), jpeg_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
@@ -33,6 +33,11 @@ static const imaging_filename_ext png_ext[] =
     { "PNG", true }
 };
 
+static const imagingFormatSignature png_sig[] =
+{
+    { "\x89PNG\r\n\x1A\n", 8 }
+};
+
 struct pngImagingExtension : public imagingFormatExtension
 {
     struct png_chunk_header
@@ -1016,7 +1021,7 @@ struct pngImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Portable Network Graphics", IMAGING_COUNT_EXT(png_ext), png_ext, this );
+        RegisterImagingFormat( engineInterface, "Portable Network Graphics", IMAGING_COUNT_EXT(png_ext), png_ext, IMAGING_COUNT_EXT(png_sig), png_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
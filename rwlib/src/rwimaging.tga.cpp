@@ -182,7 +182,8 @@ struct tgaImagingExtension : public imagingFormatExtension
     inline void Initialize( Interface *engineInterface )
     {
         // We can now address the imaging environment and register ourselves, quite exciting.
-        RegisterImagingFormat( engineInterface, "Truevision Raster Graphics", IMAGING_COUNT_EXT(tga_ext), tga_ext, this );
+        // TGA has no magic number, so it is probed by structure if no other format claims the stream.
+        RegisterImagingFormat( engineInterface, "Truevision Raster Graphics", IMAGING_COUNT_EXT(tga_ext), tga_ext, 0, NULL, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
@@ -29,6 +29,12 @@ static const imaging_filename_ext tiff_ext[] =
     { "TIF", true }
 };
 
+static const imagingFormatSignature tiff_sig[] =
+{
+    { "II\x2A\x00", 4 },
+    { "MM\x00\x2A", 4 }
+};
+
 // RenderWare TIFF imaging extension, because it is a great format!
 // Criterion's toolchain had TIFF support, too.
 struct tiffImagingExtension : public imagingFormatExtension
@@ -1372,7 +1378,7 @@ struct tiffImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Tag Image File Format", IMAGING_COUNT_EXT(tiff_ext), tiff_ext, this );
+        RegisterImagingFormat( engineInterface, "Tag Image File Format", IMAGING_COUNT_EXT(tiff_ext), tiff_ext, IMAGING_COUNT_EXT(tiff_sig), tiff_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
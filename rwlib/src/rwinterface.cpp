@@ -8,6 +8,10 @@
 
 #include "rwthreading.hxx"
 
+#include "rwparallel.hxx"
+
+#include "rwmem.hxx"
+
 namespace rw
 {
 
@@ -58,6 +62,9 @@ RwInterfaceFactory_t engineFactory;
 
 EngineInterface::EngineInterface( void )
 {
+    // Memory allocation has to work for everything that follows.
+    this->memEnv = CreateMemoryEnvironment();
+
     // Set up the type system.
     this->typeSystem._memAlloc = &memAlloc;
     this->typeSystem.lockProvider.engineInterface = this;
@@ -104,6 +111,11 @@ EngineInterface::~EngineInterface( void )
         SafeDeleteType( this, this->rasterTypeInfo );
         SafeDeleteType( this, this->streamTypeInfo );
     }
+
+    // Memory that is still alive keeps the environment around.
+    ReleaseMemoryEnvironment( this->memEnv );
+
+    this->memEnv = NULL;
 }
 
 rwLockProvider_t rwlockProvider;
@@ -536,6 +548,62 @@ eDXTCompressionMethod Interface::GetDXTRuntime( void ) const
     return GetConstEnvironmentConfigBlock( engineInterface ).GetDXTRuntime();
 }
 
+void Interface::SetDXTCompressionWorkerCount( uint32 workerCount )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetDXTCompressionWorkerCount( workerCount );
+}
+
+uint32 Interface::GetDXTCompressionWorkerCount( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetDXTCompressionWorkerCount();
+}
+
+void Interface::SetWorkerPoolSize( uint32 poolSize )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetWorkerPoolSize( poolSize );
+}
+
+uint32 Interface::GetWorkerPoolSize( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetWorkerPoolSize();
+}
+
+void Interface::SetParallelTexelThreshold( uint32 texelCount )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetParallelTexelThreshold( texelCount );
+}
+
+uint32 Interface::GetParallelTexelThreshold( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetParallelTexelThreshold();
+}
+
+void Interface::SetParallelBandTexelCount( uint32 texelCount )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetParallelBandTexelCount( texelCount );
+}
+
+uint32 Interface::GetParallelBandTexelCount( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetParallelBandTexelCount();
+}
+
 void Interface::SetFixIncompatibleRasters( bool doFix )
 {
     EngineInterface *engineInterface = (EngineInterface*)this;
@@ -606,9 +674,24 @@ bool Interface::GetIgnoreSerializationBlockRegions( void ) const
     return GetConstEnvironmentConfigBlock( engineInterface ).GetIgnoreSerializationBlockRegions();
 }
 
+void Interface::SetLazyTexelLoading( bool enable )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetLazyTexelLoading( enable );
+}
+
+bool Interface::GetLazyTexelLoading( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetLazyTexelLoading();
+}
+
 // Static library object that takes care of initializing the module dependencies properly.
 extern void registerConfigurationEnvironment( void );
 extern void registerThreadingEnvironment( void );
+extern void registerParallelWorkerPool( void );
 extern void registerWarningHandlerEnvironment( void );
 extern void registerRasterConsistency( void );
 extern void registerEventSystem( void );
@@ -660,6 +743,7 @@ Interface* CreateEngine( LibraryVersion theVersion )
 
             // Now do the main modules.
             registerThreadingEnvironment();
+            registerParallelWorkerPool();
             registerWarningHandlerEnvironment();
             registerRasterConsistency();
             registerEventSystem();
@@ -703,6 +787,9 @@ void DeleteEngine( Interface *theEngine )
 
     EngineInterface *engineInterface = (EngineInterface*)theEngine;
 
+    // Pool workers are threads too, so let them quit in peace first.
+    ShutdownParallelWorkerPool( engineInterface );
+
     // Kill everything threading related, so we can terminate (WARNING: HACK)
     PurgeActiveThreadingObjects( engineInterface );
 
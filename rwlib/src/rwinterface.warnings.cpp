@@ -201,6 +201,33 @@ void GlobalPopWarningHandler( EngineInterface *engineInterface )
     }
 }
 
+WarningHandler* GetCurrentWarningHandler( EngineInterface *engineInterface )
+{
+    warningHandlerPlugin *whandlerEnv = warningHandlerPluginRegister.GetPluginStruct( engineInterface );
+
+    if ( whandlerEnv )
+    {
+        CExecutiveManager *nativeMan = GetNativeExecutive( engineInterface );
+
+        if ( nativeMan )
+        {
+            CExecThread *curThread = nativeMan->GetCurrentThread();
+
+            if ( curThread )
+            {
+                warningHandlerThreadEnv *threadEnv = whandlerEnv->GetWarningHandlers( curThread );
+
+                if ( threadEnv && !threadEnv->warningHandlerStack.empty() )
+                {
+                    return threadEnv->warningHandlerStack.back();
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
 void registerWarningHandlerEnvironment( void )
 {
     warningHandlerPluginRegister.RegisterPlugin( engineFactory );
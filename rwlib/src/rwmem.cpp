@@ -1,28 +1,507 @@
 #include "StdInc.h"
 
+#include "rwmem.hxx"
+
+#include <mutex>
+
 namespace rw
 {
 
+// Every block starts with a header, so that it can be freed without knowing its engine or size.
+struct memoryBlockHeader
+{
+    rwMemoryEnvironment *memEnv;            // NULL for unbound memory
+    MemoryAllocatorInterface *allocator;    // the allocator that this block has to go back to
+    size_t blockSize;                       // usable size of the block
+    size_t requestedSize;
+};
+
+// Keep the returned memory aligned like the memory that we get from the allocator.
+static const size_t MEMORY_HEADER_SIZE = ( ( sizeof( memoryBlockHeader ) + 15 ) & ~(size_t)15 );
+
+AINLINE void* GetBlockMemory( memoryBlockHeader *header )
+{
+    return ( (uint8*)header + MEMORY_HEADER_SIZE );
+}
+
+AINLINE memoryBlockHeader* GetBlockHeader( void *memPtr )
+{
+    return (memoryBlockHeader*)( (uint8*)memPtr - MEMORY_HEADER_SIZE );
+}
+
+struct defaultMemoryAllocator : public MemoryAllocatorInterface
+{
+    void* Allocate( size_t memSize ) override
+    {
+        return new (std::nothrow) uint8[ memSize ];
+    }
+
+    void Free( void *memPtr, size_t memSize ) override
+    {
+        delete [] (uint8*)memPtr;
+    }
+};
+
+static defaultMemoryAllocator _defaultMemAlloc;
+
+// Pooled size classes are powers of two.
+// Bigger buffers are rare enough that they can go straight to the allocator.
+static const uint32 MEMPOOL_MIN_CLASS_BITS = 6;     // 64 bytes
+static const uint32 MEMPOOL_MAX_CLASS_BITS = 24;    // 16 MiB
+static const uint32 MEMPOOL_NUM_CLASSES = ( MEMPOOL_MAX_CLASS_BITS - MEMPOOL_MIN_CLASS_BITS + 1 );
+
+// Amount of freed memory that we keep around for reuse.
+static const size_t MEMPOOL_CAPACITY = ( 64 * 1024 * 1024 );
+
+AINLINE bool GetPoolSizeClass( size_t memSize, uint32& sizeClassOut )
+{
+    uint32 bits = MEMPOOL_MIN_CLASS_BITS;
+
+    while ( ( (size_t)1 << bits ) < memSize )
+    {
+        if ( bits == MEMPOOL_MAX_CLASS_BITS )
+            return false;
+
+        bits++;
+    }
+
+    sizeClassOut = ( bits - MEMPOOL_MIN_CLASS_BITS );
+    return true;
+}
+
+AINLINE size_t GetPoolSizeClassSize( uint32 sizeClass )
+{
+    return ( (size_t)1 << ( sizeClass + MEMPOOL_MIN_CLASS_BITS ) );
+}
+
+struct rwMemoryEnvironment
+{
+    inline rwMemoryEnvironment( void )
+    {
+        this->allocator = NULL;
+        this->isPoolingEnabled = true;
+        this->isEngineAlive = true;
+        this->refCount = 1;     // the engine interface.
+
+        this->pooledBytes = 0;
+
+        this->allocationCount = 0;
+        this->freeCount = 0;
+        this->allocatedBytes = 0;
+        this->liveBytes = 0;
+        this->peakLiveBytes = 0;
+        this->poolReuseCount = 0;
+    }
+
+    inline ~rwMemoryEnvironment( void )
+    {
+        this->FlushPool();
+    }
+
+    inline MemoryAllocatorInterface* GetAllocator( void ) const
+    {
+        MemoryAllocatorInterface *customAlloc = this->allocator.load( std::memory_order_acquire );
+
+        if ( customAlloc == NULL )
+        {
+            return &_defaultMemAlloc;
+        }
+
+        return customAlloc;
+    }
+
+    inline memoryBlockHeader* TakeFromPool( uint32 sizeClass )
+    {
+        sizeClassPool& pool = this->pools[ sizeClass ];
+
+        std::lock_guard <std::mutex> lock( pool.lock );
+
+        memoryBlockHeader *header = pool.freeList;
+
+        if ( header )
+        {
+            // The free list is linked through the memory of the blocks.
+            pool.freeList = *(memoryBlockHeader**)GetBlockMemory( header );
+
+            this->pooledBytes -= header->blockSize;
+        }
+
+        return header;
+    }
+
+    inline bool PutIntoPool( memoryBlockHeader *header )
+    {
+        if ( !this->isPoolingEnabled || !this->isEngineAlive )
+            return false;
+
+        size_t blockSize = header->blockSize;
+
+        uint32 sizeClass;
+
+        if ( !GetPoolSizeClass( blockSize, sizeClass ) || GetPoolSizeClassSize( sizeClass ) != blockSize )
+            return false;
+
+        // Blocks of an allocator that was replaced must go back to it.
+        if ( header->allocator != GetAllocator() )
+            return false;
+
+        sizeClassPool& pool = this->pools[ sizeClass ];
+
+        std::lock_guard <std::mutex> lock( pool.lock );
+
+        // The capacity is shared by pools that have their own locks, so we reserve our share
+        // in one step; otherwise two threads could both see room for just one block.
+        size_t curPooledBytes = this->pooledBytes.load( std::memory_order_relaxed );
+
+        do
+        {
+            if ( curPooledBytes + blockSize > MEMPOOL_CAPACITY )
+                return false;
+        }
+        while ( !this->pooledBytes.compare_exchange_weak( curPooledBytes, curPooledBytes + blockSize, std::memory_order_relaxed ) );
+
+        *(memoryBlockHeader**)GetBlockMemory( header ) = pool.freeList;
+
+        pool.freeList = header;
+
+        return true;
+    }
+
+    inline void FlushPool( void )
+    {
+        for ( sizeClassPool& pool : this->pools )
+        {
+            std::lock_guard <std::mutex> lock( pool.lock );
+
+            memoryBlockHeader *header = pool.freeList;
+
+            while ( header )
+            {
+                memoryBlockHeader *nextHeader = *(memoryBlockHeader**)GetBlockMemory( header );
+
+                this->pooledBytes -= header->blockSize;
+
+                header->allocator->Free( header, MEMORY_HEADER_SIZE + header->blockSize );
+
+                header = nextHeader;
+            }
+
+            pool.freeList = NULL;
+        }
+    }
+
+    inline void AddRef( void )
+    {
+        this->refCount++;
+    }
+
+    inline void Release( void )
+    {
+        if ( this->refCount.fetch_sub( 1 ) == 1 )
+        {
+            delete this;
+        }
+    }
+
+    std::atomic <MemoryAllocatorInterface*> allocator;     // NULL means default allocator
+    std::atomic <bool> isPoolingEnabled;
+    std::atomic <bool> isEngineAlive;
+
+    // One reference for the engine and one for every alive block.
+    std::atomic <size_t> refCount;
+
+    struct sizeClassPool
+    {
+        inline sizeClassPool( void )
+        {
+            this->freeList = NULL;
+        }
+
+        std::mutex lock;
+        memoryBlockHeader *freeList;
+    };
+
+    sizeClassPool pools[ MEMPOOL_NUM_CLASSES ];
+
+    std::atomic <size_t> pooledBytes;
+
+    // Statistics.
+    std::atomic <uint64> allocationCount;
+    std::atomic <uint64> freeCount;
+    std::atomic <uint64> allocatedBytes;
+    std::atomic <uint64> liveBytes;
+    std::atomic <uint64> peakLiveBytes;
+    std::atomic <uint64> poolReuseCount;
+};
+
+rwMemoryEnvironment* CreateMemoryEnvironment( void )
+{
+    return new rwMemoryEnvironment();
+}
+
+void ReleaseMemoryEnvironment( rwMemoryEnvironment *memEnv )
+{
+    // Blocks that are freed from now on go straight back to their allocator.
+    memEnv->isEngineAlive = false;
+
+    memEnv->FlushPool();
+
+    memEnv->Release();
+}
+
+static void* AllocateMemoryBlock( rwMemoryEnvironment *memEnv, size_t memSize )
+{
+    memoryBlockHeader *header = NULL;
+    size_t blockSize = memSize;
+
+    if ( memEnv && memEnv->isPoolingEnabled )
+    {
+        uint32 sizeClass;
+
+        if ( GetPoolSizeClass( memSize, sizeClass ) )
+        {
+            blockSize = GetPoolSizeClassSize( sizeClass );
+
+            header = memEnv->TakeFromPool( sizeClass );
+
+            if ( header )
+            {
+                memEnv->poolReuseCount++;
+            }
+        }
+    }
+
+    if ( header == NULL )
+    {
+        MemoryAllocatorInterface *allocator = ( memEnv ? memEnv->GetAllocator() : &_defaultMemAlloc );
+
+        void *blockMem = allocator->Allocate( MEMORY_HEADER_SIZE + blockSize );
+
+        if ( blockMem == NULL )
+        {
+            throw RwException( "failed to allocate memory block of " + std::to_string( memSize ) + " bytes" );
+        }
+
+        header = (memoryBlockHeader*)blockMem;
+        header->memEnv = memEnv;
+        header->allocator = allocator;
+        header->blockSize = blockSize;
+    }
+
+    header->requestedSize = memSize;
+
+    if ( memEnv )
+    {
+        memEnv->AddRef();
+
+        memEnv->allocationCount++;
+        memEnv->allocatedBytes += memSize;
+
+        uint64 newLiveBytes = ( memEnv->liveBytes.fetch_add( memSize ) + memSize );
+        uint64 peakLiveBytes = memEnv->peakLiveBytes.load();
+
+        while ( newLiveBytes > peakLiveBytes && !memEnv->peakLiveBytes.compare_exchange_weak( peakLiveBytes, newLiveBytes ) );
+    }
+
+    return GetBlockMemory( header );
+}
+
+static void FreeMemoryBlock( void *memPtr )
+{
+    if ( memPtr == NULL )
+        return;
+
+    memoryBlockHeader *header = GetBlockHeader( memPtr );
+
+    rwMemoryEnvironment *memEnv = header->memEnv;
+
+    if ( memEnv == NULL )
+    {
+        header->allocator->Free( header, MEMORY_HEADER_SIZE + header->blockSize );
+        return;
+    }
+
+    memEnv->freeCount++;
+    memEnv->liveBytes -= header->requestedSize;
+
+    if ( !memEnv->PutIntoPool( header ) )
+    {
+        header->allocator->Free( header, MEMORY_HEADER_SIZE + header->blockSize );
+    }
+
+    // Might destroy the environment if the engine is gone already.
+    memEnv->Release();
+}
+
+void* PixelAllocateUnbound( size_t memSize )
+{
+    return AllocateMemoryBlock( NULL, memSize );
+}
+
+void PixelFreeUnbound( void *ptr )
+{
+    FreeMemoryBlock( ptr );
+}
+
 // General memory allocation routines.
 // These should be used by the entire library.
 void* Interface::MemAllocate( size_t memSize )
 {
-    return new uint8[ memSize ];
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    return AllocateMemoryBlock( engineInterface->memEnv, memSize );
 }
 
 void Interface::MemFree( void *ptr )
 {
-    delete [] ptr;
+    FreeMemoryBlock( ptr );
 }
 
 void* Interface::PixelAllocate( size_t memSize )
 {
-    return new uint8[ memSize ];
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    return AllocateMemoryBlock( engineInterface->memEnv, memSize );
 }
 
 void Interface::PixelFree( void *ptr )
 {
-    delete [] ptr;
+    FreeMemoryBlock( ptr );
+}
+
+void Interface::SetMemoryAllocator( MemoryAllocatorInterface *allocator )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    rwMemoryEnvironment *memEnv = engineInterface->memEnv;
+
+    memEnv->allocator.store( allocator, std::memory_order_release );
+
+    // Pooled blocks belong to the previous allocator.
+    memEnv->FlushPool();
+}
+
+MemoryAllocatorInterface* Interface::GetMemoryAllocator( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return engineInterface->memEnv->allocator.load( std::memory_order_acquire );
+}
+
+void Interface::SetMemoryPooling( bool enable )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    rwMemoryEnvironment *memEnv = engineInterface->memEnv;
+
+    memEnv->isPoolingEnabled = enable;
+
+    if ( !enable )
+    {
+        memEnv->FlushPool();
+    }
+}
+
+bool Interface::GetMemoryPooling( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return engineInterface->memEnv->isPoolingEnabled;
+}
+
+void Interface::GetMemoryStatistics( memoryAllocationStatistics& statsOut ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    const rwMemoryEnvironment *memEnv = engineInterface->memEnv;
+
+    statsOut.allocationCount = memEnv->allocationCount;
+    statsOut.freeCount = memEnv->freeCount;
+    statsOut.allocatedBytes = memEnv->allocatedBytes;
+    statsOut.liveBytes = memEnv->liveBytes;
+    statsOut.peakLiveBytes = memEnv->peakLiveBytes;
+    statsOut.poolReuseCount = memEnv->poolReuseCount;
+    statsOut.pooledBytes = memEnv->pooledBytes;
+}
+
+void Interface::ResetMemoryStatistics( void )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    rwMemoryEnvironment *memEnv = engineInterface->memEnv;
+
+    memEnv->allocationCount = 0;
+    memEnv->freeCount = 0;
+    memEnv->allocatedBytes = 0;
+    memEnv->poolReuseCount = 0;
+
+    // Live memory stays alive, so the peak starts from there.
+    memEnv->peakLiveBytes = memEnv->liveBytes.load();
+}
+
+// Scratch arena implementation.
+rwScratchArena::rwScratchArena( Interface *engineInterface, size_t blockSize )
+{
+    this->engineInterface = engineInterface;
+    this->blockSize = blockSize;
+    this->currentBlock = NULL;
+}
+
+rwScratchArena::~rwScratchArena( void )
+{
+    arenaBlock *block = this->currentBlock;
+
+    while ( block )
+    {
+        arenaBlock *prevBlock = block->prev;
+
+        this->engineInterface->PixelFree( block );
+
+        block = prevBlock;
+    }
+}
+
+void* rwScratchArena::Allocate( size_t memSize )
+{
+    static const size_t ARENA_ALIGNMENT = 16;
+
+    const size_t blockHeaderSize = ( ( sizeof( arenaBlock ) + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 ) );
+
+    memSize = ( ( memSize + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 ) );
+
+    arenaBlock *block = this->currentBlock;
+
+    if ( block && block->size - block->used >= memSize )
+    {
+        void *mem = ( (uint8*)block + blockHeaderSize + block->used );
+
+        block->used += memSize;
+
+        return mem;
+    }
+
+    // Big requests get a block of their own, so that we do not throw away the current block.
+    bool isDedicated = ( memSize > this->blockSize / 2 );
+
+    size_t newBlockSize = ( isDedicated ? memSize : this->blockSize );
+
+    arenaBlock *newBlock = (arenaBlock*)this->engineInterface->PixelAllocate( blockHeaderSize + newBlockSize );
+
+    newBlock->size = newBlockSize;
+    newBlock->used = memSize;
+
+    if ( isDedicated && block )
+    {
+        newBlock->prev = block->prev;
+        block->prev = newBlock;
+    }
+    else
+    {
+        newBlock->prev = block;
+        this->currentBlock = newBlock;
+    }
+
+    return ( (uint8*)newBlock + blockHeaderSize );
 }
 
-};
\ No newline at end of file
+};
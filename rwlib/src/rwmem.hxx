@@ -0,0 +1,37 @@
+// RenderWare memory management internals.
+// Every engine interface owns a memory environment that serves MemAllocate and PixelAllocate.
+// It stays alive for as long as memory from it is alive, so buffers can outlive their engine.
+
+namespace rw
+{
+
+struct rwMemoryEnvironment;
+
+rwMemoryEnvironment*    CreateMemoryEnvironment     ( void );
+void                    ReleaseMemoryEnvironment    ( rwMemoryEnvironment *memEnv );
+
+// Bump allocator for the temporary buffers of a single operation.
+// Everything is given back at once when the arena is destroyed, so pointers from it
+// must not leave the operation.
+struct rwScratchArena
+{
+    rwScratchArena( Interface *engineInterface, size_t blockSize = 64 * 1024 );
+    ~rwScratchArena( void );
+
+    void*   Allocate( size_t memSize );
+
+private:
+    struct arenaBlock
+    {
+        arenaBlock *prev;
+        size_t size;
+        size_t used;
+    };
+
+    Interface *engineInterface;
+    size_t blockSize;
+
+    arenaBlock *currentBlock;
+};
+
+};
@@ -0,0 +1,470 @@
+#include "StdInc.h"
+
+#include "rwparallel.hxx"
+
+#include "pluginutil.hxx"
+
+#include "rwconf.hxx"
+
+#include "rwthreading.hxx"
+
+#include <mutex>
+#include <thread>
+
+using namespace NativeExecutive;
+
+namespace rw
+{
+
+static uint32 getWorkerPoolSize( Interface *engineInterface )
+{
+    uint32 poolSize = engineInterface->GetWorkerPoolSize();
+
+    if ( poolSize == 0 )
+    {
+        poolSize = std::thread::hardware_concurrency();
+
+        if ( poolSize == 0 )
+        {
+            poolSize = 1;
+        }
+    }
+
+    return poolSize;
+}
+
+// Jobs act on behalf of the thread that spawned them.
+struct parallelCallerContext
+{
+    inline void Capture( EngineInterface *engineInterface )
+    {
+        this->engineInterface = engineInterface;
+        this->callerConfig = &GetEnvironmentConfigBlock( engineInterface );
+        this->callerWarningHandler = GetCurrentWarningHandler( engineInterface );
+    }
+
+    EngineInterface *engineInterface;
+    rwConfigBlock *callerConfig;
+    WarningHandler *callerWarningHandler;
+};
+
+// Makes the running thread see the configuration and the warning handler of the caller.
+struct parallelCallerContextScope
+{
+    inline parallelCallerContextScope( const parallelCallerContext& context ) : context( context )
+    {
+        this->prevConfig = RedirectThreadConfigBlock( context.engineInterface, context.callerConfig );
+
+        if ( WarningHandler *warningHandler = context.callerWarningHandler )
+        {
+            GlobalPushWarningHandler( context.engineInterface, warningHandler );
+        }
+    }
+
+    inline ~parallelCallerContextScope( void )
+    {
+        if ( this->context.callerWarningHandler )
+        {
+            GlobalPopWarningHandler( this->context.engineInterface );
+        }
+
+        RedirectThreadConfigBlock( this->context.engineInterface, this->prevConfig );
+    }
+
+    const parallelCallerContext& context;
+    rwConfigBlock *prevConfig;
+};
+
+// Every engine owns a work-stealing pool of NativeExecutive.
+// It is created on first use and grows with Interface::SetWorkerPoolSize while nobody uses it.
+struct parallelWorkerPoolEnv
+{
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        this->pool = NULL;
+        this->activeUserCount = 0;
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        this->ClosePool( engineInterface );
+    }
+
+    // Returns the pool, which stays alive until ReleasePool is called.
+    inline CWorkStealingPool* AcquirePool( EngineInterface *engineInterface, unsigned int workerCount )
+    {
+        std::unique_lock <std::mutex> lock( this->poolLock );
+
+        CExecutiveManager *nativeMan = GetNativeExecutive( engineInterface );
+
+        if ( nativeMan == NULL )
+            return NULL;
+
+        CWorkStealingPool *pool = this->pool;
+
+        if ( pool != NULL && this->activeUserCount == 0 && pool->GetWorkerCount() < workerCount )
+        {
+            nativeMan->CloseWorkStealingPool( pool );
+
+            pool = NULL;
+        }
+
+        if ( pool == NULL )
+        {
+            pool = nativeMan->CreateWorkStealingPool( workerCount );
+
+            if ( pool == NULL )
+                return NULL;
+
+            this->pool = pool;
+        }
+
+        this->activeUserCount++;
+
+        return pool;
+    }
+
+    inline void ReleasePool( void )
+    {
+        std::unique_lock <std::mutex> lock( this->poolLock );
+
+        this->activeUserCount--;
+    }
+
+    inline void ClosePool( EngineInterface *engineInterface )
+    {
+        std::unique_lock <std::mutex> lock( this->poolLock );
+
+        if ( CWorkStealingPool *pool = this->pool )
+        {
+            assert( this->activeUserCount == 0 );
+
+            if ( CExecutiveManager *nativeMan = GetNativeExecutive( engineInterface ) )
+            {
+                nativeMan->CloseWorkStealingPool( pool );
+            }
+
+            this->pool = NULL;
+        }
+    }
+
+    std::mutex poolLock;
+
+    CWorkStealingPool *pool;
+    size_t activeUserCount;
+};
+
+static PluginDependantStructRegister <parallelWorkerPoolEnv, RwInterfaceFactory_t> parallelWorkerPoolRegister;
+
+// Keeps the pool alive while it is used.
+struct parallelPoolReference
+{
+    inline parallelPoolReference( parallelWorkerPoolEnv *poolEnv, CWorkStealingPool *pool )
+    {
+        this->poolEnv = poolEnv;
+        this->pool = pool;
+    }
+
+    inline ~parallelPoolReference( void )
+    {
+        this->poolEnv->ReleasePool();
+    }
+
+    parallelWorkerPoolEnv *poolEnv;
+    CWorkStealingPool *pool;
+};
+
+// A single call of ParallelFor.
+struct parallelRangeCall
+{
+    parallelCallerContext context;
+
+    parallelRangeRoutine_t routine;
+    void *ud;
+};
+
+static void _parallelRangeEntry( void *ud, size_t beginIndex, size_t endIndex )
+{
+    parallelRangeCall *call = (parallelRangeCall*)ud;
+
+    parallelCallerContextScope contextScope( call->context );
+
+    call->routine( call->ud, beginIndex, endIndex );
+}
+
+void ParallelFor( Interface *intf, size_t beginIndex, size_t endIndex, size_t grainSize, parallelRangeRoutine_t routine, void *ud )
+{
+    EngineInterface *engineInterface = (EngineInterface*)intf;
+
+    if ( endIndex <= beginIndex )
+        return;
+
+    if ( grainSize == 0 )
+    {
+        grainSize = 1;
+    }
+
+    // The calling thread counts as a member of the pool.
+    uint32 poolSize = getWorkerPoolSize( engineInterface );
+
+    parallelWorkerPoolEnv *poolEnv = parallelWorkerPoolRegister.GetPluginStruct( engineInterface );
+
+    CWorkStealingPool *pool = NULL;
+
+    if ( poolEnv != NULL && poolSize > 1 && ( endIndex - beginIndex ) > grainSize )
+    {
+        pool = poolEnv->AcquirePool( engineInterface, poolSize - 1 );
+    }
+
+    if ( pool == NULL )
+    {
+        while ( beginIndex < endIndex )
+        {
+            size_t rangeEnd = beginIndex + std::min( grainSize, endIndex - beginIndex );
+
+            routine( ud, beginIndex, rangeEnd );
+
+            beginIndex = rangeEnd;
+        }
+
+        return;
+    }
+
+    parallelPoolReference poolRef( poolEnv, pool );
+
+    parallelRangeCall call;
+    call.context.Capture( engineInterface );
+    call.routine = routine;
+    call.ud = ud;
+
+    pool->ParallelFor( beginIndex, endIndex, grainSize, _parallelRangeEntry, &call );
+}
+
+// ParallelForEach runs on top of ParallelFor with single tasks as ranges.
+struct parallelTaskCall
+{
+    parallelTaskRoutine_t routine;
+    void *ud;
+};
+
+static void _parallelTaskRangeEntry( void *ud, size_t beginIndex, size_t endIndex )
+{
+    parallelTaskCall *call = (parallelTaskCall*)ud;
+
+    for ( size_t taskIndex = beginIndex; taskIndex < endIndex; taskIndex++ )
+    {
+        call->routine( call->ud, taskIndex );
+    }
+}
+
+void ParallelForEach( Interface *engineInterface, size_t taskCount, parallelTaskRoutine_t routine, void *ud )
+{
+    parallelTaskCall call;
+    call.routine = routine;
+    call.ud = ud;
+
+    ParallelFor( engineInterface, 0, taskCount, 1, _parallelTaskRangeEntry, &call );
+}
+
+// Task groups.
+// The job infos belong to the group until wait, because jobs are skipped after an error.
+struct taskgroupJob
+{
+    parallelCallerContext context;
+
+    taskRoutine_t routine;
+    void *ud;
+};
+
+struct taskgroup_implementation : public taskgroup
+{
+    EngineInterface *engineInterface;
+    parallelWorkerPoolEnv *poolEnv;
+    CWorkStealingPool *pool;
+    CTaskGroup *nativeGroup;
+
+    std::mutex jobListLock;
+    std::vector <taskgroupJob*> jobs;
+
+    inline void FreeJobs( void )
+    {
+        EngineInterface *engineInterface = this->engineInterface;
+
+        for ( taskgroupJob *job : this->jobs )
+        {
+            job->~taskgroupJob();
+
+            engineInterface->MemFree( job );
+        }
+
+        this->jobs.clear();
+    }
+};
+
+static void _taskgroupJobEntry( void *ud )
+{
+    taskgroupJob *job = (taskgroupJob*)ud;
+
+    parallelCallerContextScope contextScope( job->context );
+
+    job->routine( job->ud );
+}
+
+void taskgroup::run( taskRoutine_t routine, void *ud )
+{
+    taskgroup_implementation *group = (taskgroup_implementation*)this;
+
+    EngineInterface *engineInterface = group->engineInterface;
+
+    void *jobMem = engineInterface->MemAllocate( sizeof( taskgroupJob ) );
+
+    if ( jobMem == NULL )
+    {
+        throw RwException( "failed to allocate task group job" );
+    }
+
+    taskgroupJob *job = new (jobMem) taskgroupJob;
+    job->context.Capture( engineInterface );
+    job->routine = routine;
+    job->ud = ud;
+
+    {
+        std::unique_lock <std::mutex> lock( group->jobListLock );
+
+        group->jobs.push_back( job );
+    }
+
+    group->nativeGroup->Run( _taskgroupJobEntry, job );
+}
+
+void taskgroup::wait( void )
+{
+    taskgroup_implementation *group = (taskgroup_implementation*)this;
+
+    try
+    {
+        group->nativeGroup->Wait();
+    }
+    catch( ... )
+    {
+        group->FreeJobs();
+
+        throw;
+    }
+
+    group->FreeJobs();
+}
+
+taskgroup* CreateTaskGroup( Interface *intf )
+{
+    EngineInterface *engineInterface = (EngineInterface*)intf;
+
+    parallelWorkerPoolEnv *poolEnv = parallelWorkerPoolRegister.GetPluginStruct( engineInterface );
+
+    if ( poolEnv == NULL )
+        return NULL;
+
+    CWorkStealingPool *pool = poolEnv->AcquirePool( engineInterface, getWorkerPoolSize( engineInterface ) - 1 );
+
+    if ( pool == NULL )
+        return NULL;
+
+    size_t nativeGroupSize = pool->GetTaskGroupStructSize();
+
+    void *groupMem = engineInterface->MemAllocate( sizeof( taskgroup_implementation ) + nativeGroupSize );
+
+    if ( groupMem == NULL )
+    {
+        poolEnv->ReleasePool();
+        return NULL;
+    }
+
+    taskgroup_implementation *group = new (groupMem) taskgroup_implementation;
+    group->engineInterface = engineInterface;
+    group->poolEnv = poolEnv;
+    group->pool = pool;
+    group->nativeGroup = pool->CreatePlacedTaskGroup( group + 1 );
+
+    return group;
+}
+
+void CloseTaskGroup( Interface *engineInterface, taskgroup *theGroup )
+{
+    taskgroup_implementation *group = (taskgroup_implementation*)theGroup;
+
+    // Waits for jobs that are still running.
+    group->pool->ClosePlacedTaskGroup( group->nativeGroup );
+
+    group->FreeJobs();
+
+    parallelWorkerPoolEnv *poolEnv = group->poolEnv;
+
+    group->~taskgroup_implementation();
+
+    engineInterface->MemFree( group );
+
+    poolEnv->ReleasePool();
+}
+
+bool ShouldProcessTexelsInParallel( Interface *engineInterface, uint64 texelCount )
+{
+    if ( getWorkerPoolSize( engineInterface ) <= 1 )
+        return false;
+
+    return ( texelCount >= engineInterface->GetParallelTexelThreshold() );
+}
+
+void SplitLayerIntoBands(
+    Interface *engineInterface, size_t mipIndex, uint32 layerWidth, uint32 layerHeight, uint32 rowGranularity,
+    std::vector <parallelTexelBand>& bandsOut
+)
+{
+    if ( layerHeight == 0 )
+        return;
+
+    uint32 bandTexelCount = engineInterface->GetParallelBandTexelCount();
+
+    uint32 rowsPerBand = layerHeight;
+
+    if ( bandTexelCount != 0 && layerWidth != 0 )
+    {
+        rowsPerBand = std::max( 1u, bandTexelCount / layerWidth );
+
+        rowsPerBand = ALIGN_SIZE( rowsPerBand, rowGranularity );
+    }
+
+    if ( rowsPerBand == 0 )
+    {
+        rowsPerBand = 1;
+    }
+
+    uint32 firstRow = 0;
+
+    do
+    {
+        parallelTexelBand band;
+        band.mipIndex = mipIndex;
+        band.firstRow = firstRow;
+        band.endRow = std::min( layerHeight, firstRow + rowsPerBand );
+
+        bandsOut.push_back( band );
+
+        firstRow = band.endRow;
+    }
+    while ( firstRow < layerHeight );
+}
+
+void ShutdownParallelWorkerPool( EngineInterface *engineInterface )
+{
+    if ( parallelWorkerPoolEnv *poolEnv = parallelWorkerPoolRegister.GetPluginStruct( engineInterface ) )
+    {
+        poolEnv->ClosePool( engineInterface );
+    }
+}
+
+void registerParallelWorkerPool( void )
+{
+    parallelWorkerPoolRegister.RegisterPlugin( engineFactory );
+}
+
+};
@@ -0,0 +1,69 @@
+// RenderWare parallel texel processing.
+// Independent pieces of work of a single operation (like the mipmap levels of a texture) are spread
+// across the work-stealing pool of the engine (see ParallelFor in renderware.threading.h).
+
+namespace rw
+{
+
+typedef void (*parallelTaskRoutine_t)( void *ud, size_t taskIndex );
+
+// Runs every task once and returns after all of them have finished; the calling thread takes part.
+// If a task throws, the remaining tasks are skipped and the first exception is rethrown here.
+// Tasks may call ParallelForEach themselves.
+// Tasks see the configuration and the warning handler of the calling thread, no matter where they run.
+void ParallelForEach( Interface *engineInterface, size_t taskCount, parallelTaskRoutine_t routine, void *ud );
+
+template <typename callbackType>
+struct _parallelCallbackDispatch
+{
+    static void Run( void *ud, size_t taskIndex )
+    {
+        ( *(callbackType*)ud )( taskIndex );
+    }
+};
+
+// Same as above, for function objects with an operator () ( size_t taskIndex ).
+template <typename callbackType>
+inline void ParallelForEach( Interface *engineInterface, size_t taskCount, callbackType& cb )
+{
+    ParallelForEach( engineInterface, taskCount, _parallelCallbackDispatch <callbackType>::Run, &cb );
+}
+
+// Band of rows of a mipmap layer; the unit of work of parallel texel processing.
+struct parallelTexelBand
+{
+    size_t mipIndex;
+    uint32 firstRow, endRow;
+};
+
+// Sums up the texels of a list of mipmap layers, for ShouldProcessTexelsInParallel.
+template <typename mipmapListType>
+inline uint64 GetMipmapLayersTexelCount( const mipmapListType& mipmaps )
+{
+    uint64 texelCount = 0;
+
+    size_t mipmapCount = mipmaps.size();
+
+    for ( size_t n = 0; n < mipmapCount; n++ )
+    {
+        texelCount += (uint64)mipmaps[ n ].width * mipmaps[ n ].height;
+    }
+
+    return texelCount;
+}
+
+// Decides whether texel work of the given size is worth splitting across the pool.
+// See Interface::SetWorkerPoolSize and Interface::SetParallelTexelThreshold.
+bool ShouldProcessTexelsInParallel( Interface *engineInterface, uint64 texelCount );
+
+// Adds one band per layer, or several if the layer is bigger than the band size
+// (Interface::SetParallelBandTexelCount). Bands start at multiples of rowGranularity.
+void SplitLayerIntoBands(
+    Interface *engineInterface, size_t mipIndex, uint32 layerWidth, uint32 layerHeight, uint32 rowGranularity,
+    std::vector <parallelTexelBand>& bandsOut
+);
+
+// Lets pool workers quit; the pool restarts on demand. Must not be called while the pool is in use.
+void ShutdownParallelWorkerPool( EngineInterface *engineInterface );
+
+};
@@ -0,0 +1,79 @@
+// Private SIMD helpers for rwlib pixel kernels.
+// Include this file if you want to provide vectorized code paths; always
+// keep a scalar path around, because the instruction sets are decided at runtime.
+
+#ifndef _RENDERWARE_SIMD_PRIVATE_
+#define _RENDERWARE_SIMD_PRIVATE_
+
+#ifdef RWLIB_ENABLE_SIMD_KERNELS
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RWLIB_SIMD_SSE2
+
+#include <emmintrin.h>
+
+// MSVC allows AVX2 intrinsics in any translation unit, but GCC/clang only when
+// the compilation target has them enabled.
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define RWLIB_SIMD_AVX2
+
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#endif
+
+#endif //RWLIB_ENABLE_SIMD_KERNELS
+
+namespace rw
+{
+
+// Returns true if the processor (and operating system) allow the execution of AVX2 code.
+inline bool IsAVX2Supported( void )
+{
+#ifdef RWLIB_SIMD_AVX2
+#ifdef _MSC_VER
+    int cpuInfo[4];
+
+    __cpuid( cpuInfo, 0 );
+
+    if ( cpuInfo[0] < 7 )
+        return false;
+
+    __cpuid( cpuInfo, 1 );
+
+    bool hasOSXSAVE = ( cpuInfo[2] & ( 1 << 27 ) ) != 0;
+    bool hasAVX = ( cpuInfo[2] & ( 1 << 28 ) ) != 0;
+
+    if ( !hasOSXSAVE || !hasAVX )
+        return false;
+
+    // The OS has to save the YMM registers for us.
+    if ( ( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+        return false;
+
+    __cpuidex( cpuInfo, 7, 0 );
+
+    return ( cpuInfo[1] & ( 1 << 5 ) ) != 0;
+#else
+    return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+// Cached variant, since the CPUID instruction is not exactly cheap.
+inline bool HasAVX2Support( void )
+{
+    static const bool hasSupport = IsAVX2Supported();
+
+    return hasSupport;
+}
+
+};
+
+#endif //_RENDERWARE_SIMD_PRIVATE_
@@ -2,6 +2,13 @@
 
 #include "pluginutil.hxx"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace rw
 {
 
@@ -44,6 +51,12 @@ bool Stream::supportsSize( void ) const
     return false;
 }
 
+const void* Stream::borrow( size_t borrowCount ) throw( ... )
+{
+    // By default streams cannot hand out their memory.
+    return NULL;
+}
+
 // File stream.
 struct FileStream : public Stream
 {
@@ -154,47 +167,397 @@ struct FileStream : public Stream
 };
 
 // Memory stream.
+// Either works on a buffer given by the user (fixed size) or on a buffer that it owns and grows on demand.
 struct MemoryStream : public Stream
 {
     inline MemoryStream( Interface *engineInterface, void *construction_params ) : Stream( engineInterface, construction_params )
     {
-        return;
+        this->buf = NULL;
+        this->bufSize = 0;
+        this->bufCapacity = 0;
+        this->seekOffset = 0;
+        this->isBufferOwned = false;
+        this->isWriteable = false;
     }
 
-    size_t read( void *out_buf, size_t readCount )
+    inline ~MemoryStream( void )
     {
-        return 0;
+        if ( this->isBufferOwned )
+        {
+            if ( void *buf = this->buf )
+            {
+                this->engineInterface->MemFree( buf );
+            }
+        }
     }
 
-    size_t write( const void *in_buf, size_t writeCount )
+    size_t read( void *out_buf, size_t readCount ) override
     {
-        return 0;
+        size_t seekOffset = this->seekOffset;
+        size_t bufSize = this->bufSize;
+
+        if ( seekOffset >= bufSize )
+            return 0;
+
+        size_t actualReadCount = std::min( readCount, bufSize - seekOffset );
+
+        memcpy( out_buf, (const char*)this->buf + seekOffset, actualReadCount );
+
+        this->seekOffset = ( seekOffset + actualReadCount );
+
+        return actualReadCount;
     }
 
-    void skip( int64 skipCount )
+    size_t write( const void *in_buf, size_t writeCount ) override
     {
+        if ( !this->isWriteable )
+        {
+            throw RwStreamException( "attempt to write to a read-only memory stream" );
+        }
+
+        size_t seekOffset = this->seekOffset;
+        size_t writeEnd = ( seekOffset + writeCount );
+
+        if ( writeEnd > this->bufCapacity )
+        {
+            if ( !this->isBufferOwned )
+            {
+                // We cannot grow user buffers.
+                if ( seekOffset >= this->bufCapacity )
+                    return 0;
+
+                writeCount = ( this->bufCapacity - seekOffset );
+                writeEnd = this->bufCapacity;
+            }
+            else
+            {
+                reserve( writeEnd );
+            }
+        }
+
+        // Fill any gap that was created by seeking beyond the end.
+        if ( seekOffset > this->bufSize )
+        {
+            memset( (char*)this->buf + this->bufSize, 0, seekOffset - this->bufSize );
+        }
 
+        memcpy( (char*)this->buf + seekOffset, in_buf, writeCount );
+
+        this->seekOffset = writeEnd;
+
+        if ( writeEnd > this->bufSize )
+        {
+            this->bufSize = writeEnd;
+        }
+
+        return writeCount;
     }
 
-    int64 tell( void ) const
+    void skip( int64 skipCount ) override
     {
-        return 0;
+        seek( skipCount, RWSEEK_CUR );
     }
 
-    void seek( int64 seek_off, eSeekMode seek_mode )
+    int64 tell( void ) const override
+    {
+        return (int64)this->seekOffset;
+    }
+
+    void seek( int64 seek_off, eSeekMode seek_mode ) override
     {
+        int64 newOffset = 0;
+
+        if ( seek_mode == RWSEEK_BEG )
+        {
+            newOffset = seek_off;
+        }
+        else if ( seek_mode == RWSEEK_CUR )
+        {
+            newOffset = (int64)this->seekOffset + seek_off;
+        }
+        else if ( seek_mode == RWSEEK_END )
+        {
+            newOffset = (int64)this->bufSize + seek_off;
+        }
 
+        if ( newOffset < 0 )
+        {
+            throw RwStreamException( "attempt to seek before the beginning of a memory stream" );
+        }
+
+        this->seekOffset = (size_t)newOffset;
     }
 
-    int64 size( void ) const
+    int64 size( void ) const override
     {
-        return 0;
+        return (int64)this->bufSize;
     }
 
-    bool supportsSize( void ) const
+    bool supportsSize( void ) const override
+    {
+        return true;
+    }
+
+    const void* borrow( size_t borrowCount ) override
+    {
+        size_t seekOffset = this->seekOffset;
+        size_t bufSize = this->bufSize;
+
+        if ( seekOffset > bufSize || borrowCount > bufSize - seekOffset )
+            return NULL;
+
+        this->seekOffset = ( seekOffset + borrowCount );
+
+        return (const char*)this->buf + seekOffset;
+    }
+
+    inline void reserve( size_t minCapacity )
+    {
+        size_t newCapacity = std::max( (size_t)256, this->bufCapacity );
+
+        while ( newCapacity < minCapacity )
+        {
+            newCapacity *= 2;
+        }
+
+        void *newBuf = this->engineInterface->MemAllocate( newCapacity );
+
+        if ( newBuf == NULL )
+        {
+            throw RwStreamException( "failed to grow memory stream buffer" );
+        }
+
+        if ( void *oldBuf = this->buf )
+        {
+            memcpy( newBuf, oldBuf, this->bufSize );
+
+            this->engineInterface->MemFree( oldBuf );
+        }
+
+        this->buf = newBuf;
+        this->bufCapacity = newCapacity;
+    }
+
+    void *buf;
+    size_t bufSize;         // amount of valid bytes
+    size_t bufCapacity;     // amount of addressable bytes
+    size_t seekOffset;
+    bool isBufferOwned;
+    bool isWriteable;
+};
+
+// Memory-mapped file stream.
+// Read-only view of a whole file; reads are served straight from the mapping.
+struct MappedFileStream : public Stream
+{
+    inline MappedFileStream( Interface *engineInterface, void *construction_params ) : Stream( engineInterface, construction_params )
+    {
+        this->data = NULL;
+        this->dataSize = 0;
+        this->seekOffset = 0;
+#ifdef _WIN32
+        this->mappingHandle = NULL;
+#endif
+    }
+
+    inline ~MappedFileStream( void )
+    {
+        unmap();
+    }
+
+    // Maps the file with the given name, returning false if it could not be opened.
+    inline bool map( const char *filename )
+    {
+#ifdef _WIN32
+        HANDLE fileHandle = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+        if ( fileHandle == INVALID_HANDLE_VALUE )
+            return false;
+
+        bool success = false;
+
+        LARGE_INTEGER fileSize;
+
+        if ( GetFileSizeEx( fileHandle, &fileSize ) != FALSE && (uint64)fileSize.QuadPart <= (uint64)std::numeric_limits <size_t>::max() )
+        {
+            if ( fileSize.QuadPart == 0 )
+            {
+                // Empty files cannot be mapped, but they are valid streams.
+                success = true;
+            }
+            else if ( HANDLE mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL ) )
+            {
+                void *view = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+
+                if ( view != NULL )
+                {
+                    this->mappingHandle = mappingHandle;
+                    this->data = (const char*)view;
+                    this->dataSize = (size_t)fileSize.QuadPart;
+
+                    success = true;
+                }
+                else
+                {
+                    CloseHandle( mappingHandle );
+                }
+            }
+        }
+
+        // The mapping keeps the file alive on its own.
+        CloseHandle( fileHandle );
+
+        return success;
+#else
+        int fd = open( filename, O_RDONLY );
+
+        if ( fd == -1 )
+            return false;
+
+        bool success = false;
+
+        struct stat fileStats;
+
+        if ( fstat( fd, &fileStats ) == 0 && (uint64)fileStats.st_size <= (uint64)std::numeric_limits <size_t>::max() )
+        {
+            size_t fileSize = (size_t)fileStats.st_size;
+
+            if ( fileSize == 0 )
+            {
+                // Empty files cannot be mapped, but they are valid streams.
+                success = true;
+            }
+            else
+            {
+                void *view = mmap( NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+                if ( view != MAP_FAILED )
+                {
+                    // RenderWare files are mostly parsed front to back.
+                    madvise( view, fileSize, MADV_SEQUENTIAL );
+
+                    this->data = (const char*)view;
+                    this->dataSize = fileSize;
+
+                    success = true;
+                }
+            }
+        }
+
+        // The mapping keeps the file alive on its own.
+        close( fd );
+
+        return success;
+#endif
+    }
+
+    inline void unmap( void )
+    {
+        if ( const char *data = this->data )
+        {
+#ifdef _WIN32
+            UnmapViewOfFile( data );
+
+            CloseHandle( this->mappingHandle );
+
+            this->mappingHandle = NULL;
+#else
+            munmap( (void*)data, this->dataSize );
+#endif
+
+            this->data = NULL;
+        }
+
+        this->dataSize = 0;
+        this->seekOffset = 0;
+    }
+
+    size_t read( void *out_buf, size_t readCount ) override
+    {
+        size_t seekOffset = this->seekOffset;
+        size_t dataSize = this->dataSize;
+
+        if ( seekOffset >= dataSize )
+            return 0;
+
+        size_t actualReadCount = std::min( readCount, dataSize - seekOffset );
+
+        memcpy( out_buf, this->data + seekOffset, actualReadCount );
+
+        this->seekOffset = ( seekOffset + actualReadCount );
+
+        return actualReadCount;
+    }
+
+    size_t write( const void *in_buf, size_t writeCount ) override
+    {
+        throw RwStreamException( "attempt to write to a memory-mapped file stream" );
+    }
+
+    void skip( int64 skipCount ) override
+    {
+        seek( skipCount, RWSEEK_CUR );
+    }
+
+    int64 tell( void ) const override
+    {
+        return (int64)this->seekOffset;
+    }
+
+    void seek( int64 seek_off, eSeekMode seek_mode ) override
+    {
+        int64 newOffset = 0;
+
+        if ( seek_mode == RWSEEK_BEG )
+        {
+            newOffset = seek_off;
+        }
+        else if ( seek_mode == RWSEEK_CUR )
+        {
+            newOffset = (int64)this->seekOffset + seek_off;
+        }
+        else if ( seek_mode == RWSEEK_END )
+        {
+            newOffset = (int64)this->dataSize + seek_off;
+        }
+
+        if ( newOffset < 0 )
+        {
+            throw RwStreamException( "attempt to seek before the beginning of a memory-mapped file stream" );
+        }
+
+        this->seekOffset = (size_t)newOffset;
+    }
+
+    int64 size( void ) const override
+    {
+        return (int64)this->dataSize;
+    }
+
+    bool supportsSize( void ) const override
     {
         return true;
     }
+
+    const void* borrow( size_t borrowCount ) override
+    {
+        size_t seekOffset = this->seekOffset;
+        size_t dataSize = this->dataSize;
+
+        if ( seekOffset > dataSize || borrowCount > dataSize - seekOffset )
+            return NULL;
+
+        this->seekOffset = ( seekOffset + borrowCount );
+
+        return this->data + seekOffset;
+    }
+
+    const char *data;
+    size_t dataSize;
+    size_t seekOffset;
+#ifdef _WIN32
+    HANDLE mappingHandle;
+#endif
 };
 
 // Custom stream.
@@ -299,6 +662,34 @@ struct CustomStream : public Stream
     customStreamInterface *streamProvider;
 };
 
+// Lock for the users of a stream that share it, like lazily loaded textures of one TXD.
+struct streamAccessLock
+{
+    inline void Initialize( GenericRTTI *rtObj )
+    {
+        Stream *theStream = (Stream*)RwTypeSystem::GetObjectFromTypeStruct( rtObj );
+
+        this->accessLock = CreateReadWriteLock( theStream->engineInterface );
+    }
+
+    inline void Shutdown( GenericRTTI *rtObj )
+    {
+        Stream *theStream = (Stream*)RwTypeSystem::GetObjectFromTypeStruct( rtObj );
+
+        if ( rwlock *lock = this->accessLock )
+        {
+            CloseReadWriteLock( theStream->engineInterface, lock );
+        }
+    }
+
+    inline void operator = ( const streamAccessLock& right )
+    {
+        // Streams cannot be cloned anyway.
+    }
+
+    rwlock *accessLock;
+};
+
 // Register the stream plugin to the interface.
 struct streamSystemPlugin
 {
@@ -306,11 +697,18 @@ struct streamSystemPlugin
     {
         this->fileStreamTypeInfo = NULL;
         this->memoryStreamTypeInfo = NULL;
+        this->mappedFileStreamTypeInfo = NULL;
+
+        this->accessLockPluginOffset = RwTypeSystem::INVALID_PLUGIN_OFFSET;
 
         if ( engine->streamTypeInfo != NULL )
         {
             this->fileStreamTypeInfo = engine->typeSystem.RegisterStructType <FileStream> ( "file_stream", engine->streamTypeInfo );
             this->memoryStreamTypeInfo = engine->typeSystem.RegisterStructType <MemoryStream> ( "memory_stream", engine->streamTypeInfo );
+            this->mappedFileStreamTypeInfo = engine->typeSystem.RegisterStructType <MappedFileStream> ( "mapped_file_stream", engine->streamTypeInfo );
+
+            this->accessLockPluginOffset =
+                engine->typeSystem.RegisterDependantStructPlugin <streamAccessLock> ( engine->streamTypeInfo, RwTypeSystem::ANONYMOUS_PLUGIN_ID );
         }
 
         this->streamEnvLock = rw::CreateReadWriteLock( engine );
@@ -323,6 +721,11 @@ struct streamSystemPlugin
             rw::CloseReadWriteLock( engine, lock );
         }
 
+        if ( RwTypeSystem::IsOffsetValid( this->accessLockPluginOffset ) )
+        {
+            engine->typeSystem.UnregisterPlugin( engine->streamTypeInfo, this->accessLockPluginOffset );
+        }
+
         // Delete all custom types first.
         for ( typeInfoList_t::const_iterator iter = custom_types.begin(); iter != custom_types.end(); iter++ )
         {
@@ -341,11 +744,17 @@ struct streamSystemPlugin
         {
             engine->typeSystem.DeleteType( memoryStreamTypeInfo );
         }
+
+        if ( RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo = this->mappedFileStreamTypeInfo )
+        {
+            engine->typeSystem.DeleteType( mappedFileStreamTypeInfo );
+        }
     }
 
     // Built-in stream types.
     RwTypeSystem::typeInfoBase *fileStreamTypeInfo;
     RwTypeSystem::typeInfoBase *memoryStreamTypeInfo;
+    RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo;
     
     // Custom stream types.
     typedef std::vector <RwTypeSystem::typeInfoBase*> typeInfoList_t;
@@ -354,10 +763,32 @@ struct streamSystemPlugin
 
     // Thread-safety lock.
     rw::rwlock *streamEnvLock;
+
+    RwTypeSystem::pluginOffset_t accessLockPluginOffset;
 };
 
 static PluginDependantStructRegister <streamSystemPlugin, RwInterfaceFactory_t> streamSystemPluginRegister;
 
+rwlock* GetStreamAccessLock( Stream *theStream )
+{
+    EngineInterface *engineInterface = (EngineInterface*)theStream->engineInterface;
+
+    streamSystemPlugin *streamSysEnv = streamSystemPluginRegister.GetPluginStruct( engineInterface );
+
+    if ( !streamSysEnv || !RwTypeSystem::IsOffsetValid( streamSysEnv->accessLockPluginOffset ) )
+        return NULL;
+
+    GenericRTTI *rtObj = RwTypeSystem::GetTypeStructFromObject( theStream );
+
+    streamAccessLock *lockPlugin =
+        RwTypeSystem::RESOLVE_STRUCT <streamAccessLock> ( engineInterface, rtObj, engineInterface->streamTypeInfo, streamSysEnv->accessLockPluginOffset );
+
+    if ( !lockPlugin )
+        return NULL;
+
+    return lockPlugin->accessLock;
+}
+
 struct customStreamConstructionParams
 {
     eStreamMode streamMode;
@@ -578,7 +1009,70 @@ Stream* Interface::CreateStream( eBuiltinStreamType streamType, eStreamMode stre
         }
         else if ( streamType == RWSTREAMTYPE_MEMORY )
         {
+            if ( RwTypeSystem::typeInfoBase *memoryStreamTypeInfo = streamSysEnv->memoryStreamTypeInfo )
+            {
+                if ( param->dwSize >= sizeof( streamConstructionMemoryParam_t ) )
+                {
+                    streamConstructionMemoryParam_t *mem_param = (streamConstructionMemoryParam_t*)param;
+
+                    GenericRTTI *rttiObj = engineInterface->typeSystem.Construct( engineInterface, memoryStreamTypeInfo, NULL );
 
+                    if ( rttiObj )
+                    {
+                        MemoryStream *memStream = (MemoryStream*)RwTypeSystem::GetObjectFromTypeStruct( rttiObj );
+
+                        memStream->isWriteable = ( streamMode != RWSTREAMMODE_READONLY );
+
+                        if ( void *userBuf = mem_param->buf )
+                        {
+                            memStream->buf = userBuf;
+                            memStream->bufCapacity = mem_param->bufSize;
+
+                            // Unless we create the stream, the user buffer has valid contents.
+                            memStream->bufSize = ( streamMode == RWSTREAMMODE_CREATE ? 0 : mem_param->bufSize );
+                        }
+                        else
+                        {
+                            // We manage our own buffer.
+                            memStream->isBufferOwned = true;
+
+                            if ( size_t initialCapacity = mem_param->bufSize )
+                            {
+                                memStream->reserve( initialCapacity );
+                            }
+                        }
+
+                        outputStream = memStream;
+                    }
+                }
+            }
+        }
+        else if ( streamType == RWSTREAMTYPE_MAPPED_FILE )
+        {
+            if ( RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo = streamSysEnv->mappedFileStreamTypeInfo )
+            {
+                // Mappings are read-only views.
+                if ( streamMode == RWSTREAMMODE_READONLY && param->dwSize >= sizeof( streamConstructionFileParam_t ) )
+                {
+                    streamConstructionFileParam_t *file_param = (streamConstructionFileParam_t*)param;
+
+                    GenericRTTI *rttiObj = engineInterface->typeSystem.Construct( engineInterface, mappedFileStreamTypeInfo, NULL );
+
+                    if ( rttiObj )
+                    {
+                        MappedFileStream *mappedStream = (MappedFileStream*)RwTypeSystem::GetObjectFromTypeStruct( rttiObj );
+
+                        if ( mappedStream->map( file_param->filename ) )
+                        {
+                            outputStream = mappedStream;
+                        }
+                        else
+                        {
+                            engineInterface->typeSystem.Destroy( engineInterface, rttiObj );
+                        }
+                    }
+                }
+            }
         }
         else if ( streamType == RWSTREAMTYPE_CUSTOM )
         {
@@ -7,6 +7,7 @@
 #include <math.h>
 #include <map>
 #include <algorithm>
+#include <mutex>
 #include <cmath>
 
 #include "pixelformat.hxx"
@@ -27,6 +28,8 @@
 
 #include "txdread.rasterplg.hxx"
 
+#include "rwparallel.hxx"
+
 namespace rw
 {
 
@@ -260,6 +263,19 @@ void TexDictionary::clear(void)
     }
 }
 
+void TexDictionary::loadPendingTexels( void )
+{
+    for ( texIter_t iter( this->GetTextureIterator() ); !iter.IsEnd(); iter.Increment() )
+    {
+        TextureBase *texture = iter.Resolve();
+
+        if ( Raster *texRaster = texture->GetRaster() )
+        {
+            texRaster->loadPendingTexels();
+        }
+    }
+}
+
 TexDictionary* CreateTexDictionary( Interface *intf )
 {
     EngineInterface *engineInterface = (EngineInterface*)intf;
@@ -1484,6 +1500,154 @@ bool ConvertRasterTo( Raster *theRaster, const char *nativeName )
     return conversionSuccess;
 }
 
+// Collects the warnings of one raster conversion of a batch.
+// Parallel work inside of the conversion inherits the handler, so warnings can come from many threads.
+struct rasterBatchWarningQueue : public WarningHandler
+{
+    inline rasterBatchWarningQueue( rasterConversionResult& result ) : result( result )
+    {
+        return;
+    }
+
+    void OnWarningMessage( std::string&& theMessage ) override
+    {
+        std::lock_guard <std::mutex> queueGuard( this->queueLock );
+
+        this->result.warnings.push_back( std::move( theMessage ) );
+    }
+
+    rasterConversionResult& result;
+
+    std::mutex queueLock;
+};
+
+struct rasterBatchConverter
+{
+    EngineInterface *engineInterface;
+    const char *nativeName;
+
+    rasterConversionResult *results;
+
+    void operator () ( size_t taskIndex ) const
+    {
+        EngineInterface *engineInterface = this->engineInterface;
+
+        rasterConversionResult& result = this->results[ taskIndex ];
+
+        // Warnings are issued on the thread that converts.
+        rasterBatchWarningQueue warningQueue( result );
+
+        GlobalPushWarningHandler( engineInterface, &warningQueue );
+
+        try
+        {
+            try
+            {
+                scoped_rwlock_writer <rwlock> rasterConsistency( GetRasterLock( result.texRaster ) );
+
+                result.hasSucceeded = ConvertRasterTo( result.texRaster, this->nativeName );
+            }
+            catch( RwException& except )
+            {
+                // Other rasters continue converting.
+                result.hasSucceeded = false;
+                result.errorMessage = std::move( except.message );
+            }
+        }
+        catch( ... )
+        {
+            GlobalPopWarningHandler( engineInterface );
+
+            throw;
+        }
+
+        GlobalPopWarningHandler( engineInterface );
+    }
+};
+
+bool ConvertTextureRastersTo( Interface *intf, TextureBase* const *textures, size_t textureCount, const char *nativeName, rasterConversionResults_t *resultsOut )
+{
+    EngineInterface *engineInterface = (EngineInterface*)intf;
+
+    rasterConversionResults_t results;
+
+    for ( size_t n = 0; n < textureCount; n++ )
+    {
+        TextureBase *texHandle = textures[ n ];
+
+        Raster *texRaster = texHandle->GetRaster();
+
+        if ( texRaster == NULL )
+            continue;
+
+        // Shared rasters must be converted only once.
+        bool isAlreadyQueued = false;
+
+        for ( const rasterConversionResult& queuedResult : results )
+        {
+            if ( queuedResult.texRaster == texRaster )
+            {
+                isAlreadyQueued = true;
+                break;
+            }
+        }
+
+        if ( isAlreadyQueued )
+            continue;
+
+        rasterConversionResult result;
+        result.texRaster = texRaster;
+        result.texHandle = texHandle;
+        result.hasSucceeded = false;
+
+        results.push_back( std::move( result ) );
+    }
+
+    rasterBatchConverter converter;
+    converter.engineInterface = engineInterface;
+    converter.nativeName = nativeName;
+    converter.results = results.data();
+
+    ParallelForEach( engineInterface, results.size(), converter );
+
+    // Report in a stable order.
+    bool allSucceeded = true;
+
+    for ( rasterConversionResult& result : results )
+    {
+        for ( const std::string& warning : result.warnings )
+        {
+            engineInterface->PushWarning( std::string( warning ) );
+        }
+
+        if ( !result.hasSucceeded )
+        {
+            allSucceeded = false;
+        }
+    }
+
+    if ( resultsOut )
+    {
+        *resultsOut = std::move( results );
+    }
+
+    return allSucceeded;
+}
+
+bool ConvertTexDictionaryRastersTo( TexDictionary *txd, const char *nativeName, rasterConversionResults_t *resultsOut )
+{
+    std::vector <TextureBase*> textures;
+
+    textures.reserve( txd->GetTextureCount() );
+
+    for ( TexDictionary::texIter_t iter( txd->GetTextureIterator() ); !iter.IsEnd(); iter.Increment() )
+    {
+        textures.push_back( iter.Resolve() );
+    }
+
+    return ConvertTextureRastersTo( txd->engineInterface, textures.data(), textures.size(), nativeName, resultsOut );
+}
+
 void* GetNativeTextureDriverInterface( Interface *engineInterface, const char *typeName )
 {
     void *intf = NULL;
@@ -2430,6 +2594,26 @@ void* Raster::getNativeInterface( void )
     return texProvider->GetNativeInterface( platformTex );
 }
 
+void Raster::loadPendingTexels( void )
+{
+    // Loading is safe against other readers of the texture.
+    scoped_rwlock_reader <rwlock> rasterConsistency( GetRasterLock( this ) );
+
+    PlatformTexture *platformTex = this->platformData;
+
+    if ( !platformTex )
+        return;
+
+    Interface *engineInterface = this->engineInterface;
+
+    texNativeTypeProvider *texProvider = GetNativeTextureTypeProvider( engineInterface, platformTex );
+
+    if ( !texProvider )
+        return;
+
+    texProvider->LoadPendingTexels( engineInterface, platformTex );
+}
+
 void* Raster::getDriverNativeInterface( void )
 {
     scoped_rwlock_reader <rwlock> rasterConsistency( GetRasterLock( this ) );
@@ -0,0 +1,565 @@
+#include "StdInc.h"
+
+#include "txdread.d3d.dxt.hxx"
+
+#include "rwsimd.hxx"
+
+#include "rwparallel.hxx"
+
+#include <vector>
+#include <thread>
+
+// Batch DXT decoder that writes whole block rows straight into the destination texels.
+// It produces the same texels as decompressDXTBlock for both runtimes.
+
+namespace rw
+{
+
+AINLINE uint32 packDXTColor( uint32 red, uint32 green, uint32 blue, uint32 alpha, bool isBGRA )
+{
+    if ( isBGRA )
+    {
+        return ( blue | ( green << 8 ) | ( red << 16 ) | ( alpha << 24 ) );
+    }
+
+    return ( red | ( green << 8 ) | ( blue << 16 ) | ( alpha << 24 ) );
+}
+
+// Calculates the four block colors with an empty alpha channel.
+// If isDXT1 is true, the alpha channel is filled in according to the DXT1 rules.
+AINLINE void calculateDXTColorPalette( rgb565 col0, rgb565 col1, bool isDXT1, bool isBGRA, uint32 paletteOut[4] )
+{
+    uint32 c[4][3];
+
+    c[0][0] = col0.red * 0xFF/0x1F;
+    c[0][1] = col0.green * 0xFF/0x3F;
+    c[0][2] = col0.blue * 0xFF/0x1F;
+
+    c[1][0] = col1.red * 0xFF/0x1F;
+    c[1][1] = col1.green * 0xFF/0x3F;
+    c[1][2] = col1.blue * 0xFF/0x1F;
+
+    uint32 alphaMain = ( isDXT1 ? 0xFF : 0 );
+
+    paletteOut[0] = packDXTColor( c[0][0], c[0][1], c[0][2], alphaMain, isBGRA );
+    paletteOut[1] = packDXTColor( c[1][0], c[1][1], c[1][2], alphaMain, isBGRA );
+
+    if ( !isDXT1 || col0.val > col1.val )
+    {
+        for ( uint32 n = 0; n < 3; n++ )
+        {
+            c[2][n] = (2*c[0][n] + 1*c[1][n])/3;
+            c[3][n] = (1*c[0][n] + 2*c[1][n])/3;
+        }
+
+        paletteOut[2] = packDXTColor( c[2][0], c[2][1], c[2][2], alphaMain, isBGRA );
+        paletteOut[3] = packDXTColor( c[3][0], c[3][1], c[3][2], alphaMain, isBGRA );
+    }
+    else
+    {
+        for ( uint32 n = 0; n < 3; n++ )
+        {
+            c[2][n] = (c[0][n] + c[1][n])/2;
+        }
+
+        paletteOut[2] = packDXTColor( c[2][0], c[2][1], c[2][2], alphaMain, isBGRA );
+        paletteOut[3] = 0;
+    }
+}
+
+// Writes the 4x4 texels of a block using the color palette, the 2bit color indice
+// and the per-texel alpha values (shifted into the alpha byte already).
+AINLINE void writeDXTBlockTexels(
+    const uint32 palette[4], uint32 indexList, const uint32 alphaBits[16],
+    void *dstTexels, uint32 dstRowSize
+)
+{
+#ifdef RWLIB_SIMD_SSE2
+    // Select the palette entry of each texel in a row using comparison masks.
+    const __m128i laneMask = _mm_set_epi32( 3 << 6, 3 << 4, 3 << 2, 3 );
+    const __m128i laneUnit = _mm_set_epi32( 1 << 6, 1 << 4, 1 << 2, 1 );
+    const __m128i laneUnitTwice = _mm_add_epi32( laneUnit, laneUnit );
+    const __m128i laneUnitThrice = _mm_add_epi32( laneUnitTwice, laneUnit );
+
+    const __m128i pal0 = _mm_set1_epi32( (int)palette[0] );
+    const __m128i pal1 = _mm_set1_epi32( (int)palette[1] );
+    const __m128i pal2 = _mm_set1_epi32( (int)palette[2] );
+    const __m128i pal3 = _mm_set1_epi32( (int)palette[3] );
+
+    for ( uint32 y = 0; y < 4; y++ )
+    {
+        __m128i rowIndice = _mm_and_si128( _mm_set1_epi32( (int)( ( indexList >> ( y * 8 ) ) & 0xFF ) ), laneMask );
+
+        __m128i texels =
+            _mm_or_si128(
+                _mm_or_si128(
+                    _mm_and_si128( _mm_cmpeq_epi32( rowIndice, _mm_setzero_si128() ), pal0 ),
+                    _mm_and_si128( _mm_cmpeq_epi32( rowIndice, laneUnit ), pal1 )
+                ),
+                _mm_or_si128(
+                    _mm_and_si128( _mm_cmpeq_epi32( rowIndice, laneUnitTwice ), pal2 ),
+                    _mm_and_si128( _mm_cmpeq_epi32( rowIndice, laneUnitThrice ), pal3 )
+                )
+            );
+
+        if ( alphaBits != NULL )
+        {
+            const uint32 *rowAlpha = ( alphaBits + y * 4 );
+
+            texels = _mm_or_si128( texels, _mm_set_epi32( (int)rowAlpha[3], (int)rowAlpha[2], (int)rowAlpha[1], (int)rowAlpha[0] ) );
+        }
+
+        _mm_storeu_si128( (__m128i*)getTexelDataRow( dstTexels, dstRowSize, y ), texels );
+    }
+#else
+    for ( uint32 y = 0; y < 4; y++ )
+    {
+        uint32 *dstRow = (uint32*)getTexelDataRow( dstTexels, dstRowSize, y );
+
+        for ( uint32 x = 0; x < 4; x++ )
+        {
+            uint32 coordIndex = getDXTLocalBlockIndex( x, y );
+
+            uint32 texel = palette[ ( indexList >> ( coordIndex * 2 ) ) & 0x3 ];
+
+            if ( alphaBits != NULL )
+            {
+                texel |= alphaBits[ coordIndex ];
+            }
+
+            dstRow[ x ] = texel;
+        }
+    }
+#endif //RWLIB_SIMD_SSE2
+}
+
+// Reverses the alpha premultiplication of DXT2 and DXT4 in a 32bit block.
+AINLINE void unpremultiplyDXTBlockTexels( void *dstTexels, uint32 dstRowSize )
+{
+    for ( uint32 y = 0; y < 4; y++ )
+    {
+        uint8 *dstRow = (uint8*)getTexelDataRow( dstTexels, dstRowSize, y );
+
+        for ( uint32 x = 0; x < 4; x++ )
+        {
+            uint8 *texel = ( dstRow + x * 4 );
+
+            // The color channels are treated the same, so the color order does not matter.
+            unpremultiplyByAlpha( texel[0], texel[1], texel[2], texel[3], texel[0], texel[1], texel[2] );
+        }
+    }
+}
+
+// Decodes one DXT block into 32bit texels of RGBA or BGRA order.
+AINLINE void decodeDXTBlockToRGBA32(
+    bool useNative, uint32 dxtType, const void *blockData, bool isBGRA,
+    void *dstTexels, uint32 dstRowSize
+)
+{
+    if ( useNative )
+    {
+        uint32 palette[4];
+
+        if ( dxtType == 1 )
+        {
+            const dxt1_block *block = (const dxt1_block*)blockData;
+
+            calculateDXTColorPalette( block->col0, block->col1, true, isBGRA, palette );
+
+            writeDXTBlockTexels( palette, block->indexList, NULL, dstTexels, dstRowSize );
+        }
+        else if ( dxtType == 2 || dxtType == 3 )
+        {
+            const dxt2_3_block *block = (const dxt2_3_block*)blockData;
+
+            calculateDXTColorPalette( block->col0, block->col1, false, isBGRA, palette );
+
+            uint32 alphaBits[16];
+
+            uint64 alphasint = block->alphaList;
+
+            for ( uint32 k = 0; k < 16; k++ )
+            {
+                alphaBits[k] = (uint32)( ( alphasint & 0xF ) * 17 ) << 24;
+
+                alphasint >>= 4;
+            }
+
+            writeDXTBlockTexels( palette, block->indexList, alphaBits, dstTexels, dstRowSize );
+        }
+        else if ( dxtType == 4 || dxtType == 5 )
+        {
+            const dxt4_5_block *block = (const dxt4_5_block*)blockData;
+
+            calculateDXTColorPalette( block->col0, block->col1, false, isBGRA, palette );
+
+            uint32 alphaPalette[8];
+
+            uint8 first_alpha = block->alphaPreMult[0];
+            uint8 second_alpha = block->alphaPreMult[1];
+
+            for ( uint32 n = 0; n < 8; n++ )
+            {
+                alphaPalette[n] = (uint32)dxt4_5_block::getAlphaByIndex( first_alpha, second_alpha, n ) << 24;
+            }
+
+            // The alpha indice take up 48 bits.
+            uint64 alphasint = 0;
+
+            for ( uint32 n = 0; n < 6; n++ )
+            {
+                alphasint |= ( (uint64)block->alphaList[n] << ( n * 8 ) );
+            }
+
+            uint32 alphaBits[16];
+
+            for ( uint32 k = 0; k < 16; k++ )
+            {
+                alphaBits[k] = alphaPalette[ alphasint & 0x7 ];
+
+                alphasint >>= 3;
+            }
+
+            writeDXTBlockTexels( palette, block->indexList, alphaBits, dstTexels, dstRowSize );
+        }
+    }
+    else
+    {
+        int dxt_flags = 0;
+
+        if ( dxtType == 1 )
+        {
+            dxt_flags |= squish::kDxt1;
+        }
+        else if ( dxtType == 2 || dxtType == 3 )
+        {
+            dxt_flags |= squish::kDxt3;
+        }
+        else if ( dxtType == 4 || dxtType == 5 )
+        {
+            dxt_flags |= squish::kDxt5;
+        }
+
+        // SQUISH always writes RGBA.
+        uint32 colors[16];
+
+        squish::Decompress( (squish::u8*)colors, blockData, dxt_flags );
+
+        for ( uint32 y = 0; y < 4; y++ )
+        {
+            uint32 *dstRow = (uint32*)getTexelDataRow( dstTexels, dstRowSize, y );
+
+            for ( uint32 x = 0; x < 4; x++ )
+            {
+                uint32 texel = colors[ getDXTLocalBlockIndex( x, y ) ];
+
+                if ( isBGRA )
+                {
+                    texel = ( texel & 0xFF00FF00 ) | ( ( texel & 0xFF ) << 16 ) | ( ( texel >> 16 ) & 0xFF );
+                }
+
+                dstRow[ x ] = texel;
+            }
+        }
+    }
+
+    if ( dxtType == 2 || dxtType == 4 )
+    {
+        unpremultiplyDXTBlockTexels( dstTexels, dstRowSize );
+    }
+}
+
+inline bool isDXTDirectOutput( eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder )
+{
+    return ( dstRasterFormat == RASTER_8888 && dstDepth == 32 && ( dstColorOrder == COLOR_RGBA || dstColorOrder == COLOR_BGRA ) );
+}
+
+bool canDecompressDXTLayerFast( uint32 dxtType, eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder )
+{
+    if ( getDXTBlockSize( dxtType ) == 0 )
+        return false;
+
+    if ( isDXTDirectOutput( dstRasterFormat, dstDepth, dstColorOrder ) )
+        return true;
+
+    return ( GetTexelRowKernel( RASTER_8888, 32, COLOR_RGBA, dstRasterFormat, dstDepth, dstColorOrder ) != NULL );
+}
+
+bool decompressDXTLayerRowsFast(
+    eDXTCompressionMethod dxtMethod, uint32 dxtType,
+    const void *srcBlocks, uint32 texWidth, uint32 texHeight,
+    void *dstTexels, uint32 dstRowSize, uint32 layerWidth, uint32 layerHeight,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder,
+    uint32 firstBlockRow, uint32 endBlockRow
+)
+{
+    uint32 blockSize = getDXTBlockSize( dxtType );
+
+    if ( blockSize == 0 )
+        return false;
+
+    // Decide how to put the texels.
+    // 8888 RGBA/BGRA is written directly, everything else goes through a block row
+    // strip in RGBA and the row kernels of txdread.pixelconv.kernels.cpp.
+    bool isDirectOutput = isDXTDirectOutput( dstRasterFormat, dstDepth, dstColorOrder );
+
+    texelRowKernel_t stripKernel = NULL;
+
+    if ( !isDirectOutput )
+    {
+        stripKernel = GetTexelRowKernel( RASTER_8888, 32, COLOR_RGBA, dstRasterFormat, dstDepth, dstColorOrder );
+
+        if ( stripKernel == NULL )
+        {
+            return false;
+        }
+    }
+
+    bool isBGRA = ( isDirectOutput && dstColorOrder == COLOR_BGRA );
+
+    bool useNative = ( dxtMethod == DXTRUNTIME_NATIVE || dxtType == 2 || dxtType == 4 );
+
+    // Keep the block order of decompressDXTBlock callers, even for unaligned surfaces.
+    uint32 widthBlocks = ( texWidth + 3 ) / 4;
+    uint32 heightBlocks = ( texHeight + 3 ) / 4;
+
+    uint32 compressedBlockCount = ( texWidth * texHeight ) / 16;
+
+    uint32 stripRowSize = ( widthBlocks * 4 * sizeof( uint32 ) );
+
+    std::vector <uint32> stripTexels;
+
+    if ( !isDirectOutput )
+    {
+        stripTexels.resize( widthBlocks * 4 * 4 );
+    }
+
+    uint32 blockIndex = ( firstBlockRow * widthBlocks );
+
+    uint32 lastBlockRow = std::min( endBlockRow, heightBlocks );
+
+    for ( uint32 y_block = firstBlockRow; y_block < lastBlockRow && blockIndex < compressedBlockCount; y_block++ )
+    {
+        uint32 y = ( y_block * 4 );
+
+        if ( y >= layerHeight )
+            break;
+
+        uint32 rowsInLayer = std::min( 4u, layerHeight - y );
+
+        for ( uint32 x_block = 0; x_block < widthBlocks && blockIndex < compressedBlockCount; x_block++, blockIndex++ )
+        {
+            uint32 x = ( x_block * 4 );
+
+            if ( x >= layerWidth )
+                continue;
+
+            const void *blockData = ( (const uint8*)srcBlocks + blockIndex * blockSize );
+
+            if ( isDirectOutput )
+            {
+                uint32 colsInLayer = std::min( 4u, layerWidth - x );
+
+                void *dstBlockTexels = ( (uint32*)getTexelDataRow( dstTexels, dstRowSize, y ) + x );
+
+                if ( colsInLayer == 4 && rowsInLayer == 4 )
+                {
+                    decodeDXTBlockToRGBA32( useNative, dxtType, blockData, isBGRA, dstBlockTexels, dstRowSize );
+                }
+                else
+                {
+                    // Edge block that is not entirely inside of the layer.
+                    uint32 blockTexels[16];
+
+                    decodeDXTBlockToRGBA32( useNative, dxtType, blockData, isBGRA, blockTexels, sizeof( uint32 ) * 4 );
+
+                    for ( uint32 row = 0; row < rowsInLayer; row++ )
+                    {
+                        memcpy(
+                            getTexelDataRow( dstBlockTexels, dstRowSize, row ),
+                            blockTexels + row * 4,
+                            colsInLayer * sizeof( uint32 )
+                        );
+                    }
+                }
+            }
+            else
+            {
+                decodeDXTBlockToRGBA32( useNative, dxtType, blockData, false, &stripTexels[ x ], stripRowSize );
+            }
+        }
+
+        if ( !isDirectOutput )
+        {
+            // Convert the decoded block row into the destination format.
+            for ( uint32 row = 0; row < rowsInLayer; row++ )
+            {
+                const void *stripRow = getConstTexelDataRow( stripTexels.data(), stripRowSize, row );
+                void *dstRow = getTexelDataRow( dstTexels, dstRowSize, y + row );
+
+                stripKernel( stripRow, dstRow, 0, 0, std::min( layerWidth, widthBlocks * 4 ) );
+            }
+        }
+    }
+
+    return true;
+}
+
+bool decompressDXTLayerFast(
+    eDXTCompressionMethod dxtMethod, uint32 dxtType,
+    const void *srcBlocks, uint32 texWidth, uint32 texHeight,
+    void *dstTexels, uint32 dstRowSize, uint32 layerWidth, uint32 layerHeight,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder
+)
+{
+    return
+        decompressDXTLayerRowsFast(
+            dxtMethod, dxtType,
+            srcBlocks, texWidth, texHeight,
+            dstTexels, dstRowSize, layerWidth, layerHeight,
+            dstRasterFormat, dstDepth, dstColorOrder,
+            0, ( texHeight + 3 ) / 4
+        );
+}
+
+// Parallel DXT compression.
+// The blocks of all layers are split into bands of block rows which go to the worker pool of the engine.
+// Since every band is written to its final place, the output matches the serial encoder bit by bit.
+struct dxtCompressionTask
+{
+    const dxtCompressionLayer *layer;
+    uint32 firstBlockRow, endBlockRow;
+};
+
+struct dxtCompressionJob
+{
+    uint32 dxtType;
+    uint32 rowAlignment;
+    uint32 itemDepth;
+
+    const colorModelDispatcher <const void> *fetchSrcDispatch;
+
+    const dxtCompressionTask *tasks;
+
+    inline void operator () ( size_t taskIndex )
+    {
+        const dxtCompressionTask& task = this->tasks[ taskIndex ];
+
+        compressDXTBlockRows(
+            this->dxtType, *task.layer, this->rowAlignment, this->itemDepth,
+            *this->fetchSrcDispatch,
+            task.firstBlockRow, task.endBlockRow
+        );
+    }
+};
+
+// Runs the tasks in as many contiguous chunks as workers may compress at once.
+struct dxtCompressionChunkJob
+{
+    dxtCompressionJob *job;
+
+    size_t taskCount;
+    size_t chunkCount;
+
+    inline void operator () ( size_t chunkIndex )
+    {
+        size_t firstTask = ( chunkIndex * this->taskCount / this->chunkCount );
+        size_t endTask = ( ( chunkIndex + 1 ) * this->taskCount / this->chunkCount );
+
+        for ( size_t n = firstTask; n < endTask; n++ )
+        {
+            ( *this->job )( n );
+        }
+    }
+};
+
+// Smallest amount of blocks that is worth handing to a worker.
+static const uint32 _dxtMinBlocksPerTask = 256;
+
+static uint32 getDXTCompressionWorkerCount( Interface *engineInterface )
+{
+    uint32 workerCount = engineInterface->GetDXTCompressionWorkerCount();
+
+    if ( workerCount == 0 )
+    {
+        workerCount = std::thread::hardware_concurrency();
+
+        if ( workerCount == 0 )
+        {
+            workerCount = 1;
+        }
+    }
+
+    return workerCount;
+}
+
+void compressDXTLayers(
+    Interface *engineInterface,
+    uint32 dxtType, uint32 rowAlignment,
+    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
+    const dxtCompressionLayer *layers, size_t layerCount
+)
+{
+    colorModelDispatcher <const void> fetchSrcDispatch( rasterFormat, colorOrder, itemDepth, paletteData, maxpalette, paletteType );
+
+    // Split the layers into bands of block rows.
+    std::vector <dxtCompressionTask> tasks;
+
+    for ( size_t n = 0; n < layerCount; n++ )
+    {
+        const dxtCompressionLayer& layer = layers[ n ];
+
+        uint32 widthBlocks = ALIGN_SIZE( layer.mipWidth, 4u ) / 4;
+        uint32 heightBlocks = ALIGN_SIZE( layer.mipHeight, 4u ) / 4;
+
+        if ( widthBlocks == 0 || heightBlocks == 0 )
+            continue;
+
+        uint32 rowsPerTask = std::max( 1u, _dxtMinBlocksPerTask / widthBlocks );
+
+        for ( uint32 firstRow = 0; firstRow < heightBlocks; firstRow += rowsPerTask )
+        {
+            dxtCompressionTask task;
+            task.layer = &layer;
+            task.firstBlockRow = firstRow;
+            task.endBlockRow = std::min( heightBlocks, firstRow + rowsPerTask );
+
+            tasks.push_back( task );
+        }
+    }
+
+    dxtCompressionJob job;
+    job.dxtType = dxtType;
+    job.rowAlignment = rowAlignment;
+    job.itemDepth = itemDepth;
+    job.fetchSrcDispatch = &fetchSrcDispatch;
+    job.tasks = tasks.data();
+
+    size_t taskCount = tasks.size();
+
+    uint32 workerCount = getDXTCompressionWorkerCount( engineInterface );
+
+    if ( workerCount <= 1 || taskCount <= 1 )
+    {
+        for ( size_t n = 0; n < taskCount; n++ )
+        {
+            job( n );
+        }
+    }
+    else if ( taskCount <= workerCount )
+    {
+        ParallelForEach( engineInterface, taskCount, job );
+    }
+    else
+    {
+        // There cannot be more workers busy than there are chunks.
+        dxtCompressionChunkJob chunkJob;
+        chunkJob.job = &job;
+        chunkJob.taskCount = taskCount;
+        chunkJob.chunkCount = workerCount;
+
+        ParallelForEach( engineInterface, chunkJob.chunkCount, chunkJob );
+    }
+}
+
+};
@@ -524,6 +524,28 @@ inline bool decompressDXTBlock(
     return hasDecompressed;
 }
 
+// Decodes an entire DXT layer straight into raw texel rows (see txdread.d3d.dxt.cpp).
+// Returns false if there is no fast path for the destination format; then use decompressDXTBlock.
+bool decompressDXTLayerFast(
+    eDXTCompressionMethod dxtMethod, uint32 dxtType,
+    const void *srcBlocks, uint32 texWidth, uint32 texHeight,
+    void *dstTexels, uint32 dstRowSize, uint32 layerWidth, uint32 layerHeight,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder
+);
+
+// Same as above, but only decodes the block rows [firstBlockRow, endBlockRow).
+// Disjoint block row ranges of one layer can be decoded at the same time.
+bool decompressDXTLayerRowsFast(
+    eDXTCompressionMethod dxtMethod, uint32 dxtType,
+    const void *srcBlocks, uint32 texWidth, uint32 texHeight,
+    void *dstTexels, uint32 dstRowSize, uint32 layerWidth, uint32 layerHeight,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder,
+    uint32 firstBlockRow, uint32 endBlockRow
+);
+
+// Returns whether decompressDXTLayerFast supports the given destination format.
+bool canDecompressDXTLayerFast( uint32 dxtType, eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder );
+
 inline uint32 getDXTBlockSize( uint32 dxtType )
 {
     uint32 blockSize = 0;
@@ -550,36 +572,67 @@ inline uint32 getDXTRasterDataSize(uint32 dxtType, uint32 texUnitCount)
     return ( texBlockCount * blockSize );
 }
 
-inline void compressTexelsUsingDXT(
-    Interface *engineInterface,
-    uint32 dxtType, const void *texelSource, uint32 mipWidth, uint32 mipHeight, uint32 rowAlignment,
-    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
-    void*& texelsOut, uint32& dataSizeOut,
-    uint32& realWidthOut, uint32& realHeightOut
-)
+// A single surface that should be compressed into DXT blocks.
+struct dxtCompressionLayer
 {
-    // Make sure the texture dimensions are aligned by 4.
-    uint32 alignedMipWidth = ALIGN_SIZE( mipWidth, 4u );
-    uint32 alignedMipHeight = ALIGN_SIZE( mipHeight, 4u );
+    const void *texelSource;
+    uint32 mipWidth, mipHeight;
 
-    uint32 dxtDataSize = getDXTRasterDataSize(dxtType, ( alignedMipWidth * alignedMipHeight ) );
+    void *dxtArray;     // has to be big enough for the 4-aligned dimensions.
+};
 
-    void *dxtArray = engineInterface->PixelAllocate( dxtDataSize );
+// Compresses the block rows [firstBlockRow, endBlockRow) of a layer.
+// Every block is written to its final position, so the result does not depend on how the rows are split up.
+inline void compressDXTBlockRows(
+    uint32 dxtType, const dxtCompressionLayer& layer, uint32 rowAlignment, uint32 itemDepth,
+    const colorModelDispatcher <const void>& fetchSrcDispatch,
+    uint32 firstBlockRow, uint32 endBlockRow
+)
+{
+    uint32 mipWidth = layer.mipWidth;
+    uint32 mipHeight = layer.mipHeight;
+
+    const void *texelSource = layer.texelSource;
 
     // Calculate the row size of the source texture.
     uint32 rawRowSize = getRasterDataRowSize( mipWidth, itemDepth, rowAlignment );
 
-    // Loop across the image.
-    uint32 compressedBlockCount = 0;
+    uint32 widthBlocks = ALIGN_SIZE( mipWidth, 4u ) / 4;
 
-    uint32 widthBlocks = alignedMipWidth / 4;
-    uint32 heightBlocks = alignedMipHeight / 4;
+    // Check whether we should premultiply.
+    bool isPremultiplied = ( dxtType == 2 || dxtType == 4 );
 
-    uint32 y = 0;
+    // Decide about the SQUISH compression mode.
+    int squishFlags = 0;
+    bool canCompress = false;
 
-    colorModelDispatcher <const void> fetchSrcDispatch( rasterFormat, colorOrder, itemDepth, paletteData, maxpalette, paletteType );
+    if ( dxtType == 1 )
+    {
+        squishFlags |= squish::kDxt1;
+
+        canCompress = true;
+    }
+    else if ( dxtType == 2 || dxtType == 3 )
+    {
+        squishFlags |= squish::kDxt3;
+
+        canCompress = true;
+    }
+    else if ( dxtType == 4 || dxtType == 5 )
+    {
+        squishFlags |= squish::kDxt5;
+
+        canCompress = true;
+    }
+
+    if ( !canCompress )
+        return;
+
+    uint32 compressBlockSize = getDXTBlockSize( dxtType );
+
+    uint32 y = ( firstBlockRow * 4 );
 
-    for ( uint32 y_block = 0; y_block < heightBlocks; y_block++, y += 4 )
+    for ( uint32 y_block = firstBlockRow; y_block < endBlockRow; y_block++, y += 4 )
     {
         uint32 x = 0;
 
@@ -588,9 +641,6 @@ inline void compressTexelsUsingDXT(
             // Compress a 4x4 color block.
             PixelFormat::pixeldata32bit colors[4][4];
 
-            // Check whether we should premultiply.
-            bool isPremultiplied = ( dxtType == 2 || dxtType == 4 );
-
             for ( uint32 y_iter = 0; y_iter != 4; y_iter++ )
             {
                 for ( uint32 x_iter = 0; x_iter != 4; x_iter++ )
@@ -624,59 +674,59 @@ inline void compressTexelsUsingDXT(
                 }
             }
 
-            // Compress it using SQUISH.
-            int squishFlags = 0;
-            bool canCompress = false;
-
-            size_t compressBlockSize = 0;
-            void *blockPointer = NULL;
-
-            union
-            {
-                dxt1_block _dxt1_block;
-                dxt2_3_block _dxt2_3_block;
-                dxt4_5_block _dxt4_5_block;
-            };
-
-            if ( dxtType == 1 )
-            {
-                squishFlags |= squish::kDxt1;
-
-                canCompress = true;
+            // Compress it using SQUISH, right into the texture.
+            void *blockPointer = (char*)layer.dxtArray + ( y_block * widthBlocks + x_block ) * compressBlockSize;
 
-                compressBlockSize = sizeof( _dxt1_block );
-                blockPointer = &_dxt1_block;
-            }
-            else if ( dxtType == 2 || dxtType == 3 )
-            {
-                squishFlags |= squish::kDxt3;
-
-                canCompress = true;
+            squish::Compress( (const squish::u8*)colors, blockPointer, squishFlags );
+        }
+    }
+}
 
-                compressBlockSize = sizeof( _dxt2_3_block );
-                blockPointer = &_dxt2_3_block;
-            }
-            else if ( dxtType == 4 || dxtType == 5 )
-            {
-                squishFlags |= squish::kDxt5;
+// Compresses multiple layers at once, splitting the work across the amount of threads
+// that is configured by Interface::SetDXTCompressionWorkerCount.
+void compressDXTLayers(
+    Interface *engineInterface,
+    uint32 dxtType, uint32 rowAlignment,
+    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
+    const dxtCompressionLayer *layers, size_t layerCount
+);
 
-                canCompress = true;
+inline void compressTexelsUsingDXT(
+    Interface *engineInterface,
+    uint32 dxtType, const void *texelSource, uint32 mipWidth, uint32 mipHeight, uint32 rowAlignment,
+    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
+    void*& texelsOut, uint32& dataSizeOut,
+    uint32& realWidthOut, uint32& realHeightOut
+)
+{
+    // Make sure the texture dimensions are aligned by 4.
+    uint32 alignedMipWidth = ALIGN_SIZE( mipWidth, 4u );
+    uint32 alignedMipHeight = ALIGN_SIZE( mipHeight, 4u );
 
-                compressBlockSize = sizeof( _dxt4_5_block );
-                blockPointer = &_dxt4_5_block;
-            }
+    uint32 dxtDataSize = getDXTRasterDataSize(dxtType, ( alignedMipWidth * alignedMipHeight ) );
 
-            if ( canCompress )
-            {
-                squish::Compress( (const squish::u8*)colors, blockPointer, squishFlags );
-            }
+    void *dxtArray = engineInterface->PixelAllocate( dxtDataSize );
 
-            // Put the block into the texture.
-            memcpy( (char*)dxtArray + compressedBlockCount * compressBlockSize, blockPointer, compressBlockSize );
+    try
+    {
+        dxtCompressionLayer layer;
+        layer.texelSource = texelSource;
+        layer.mipWidth = mipWidth;
+        layer.mipHeight = mipHeight;
+        layer.dxtArray = dxtArray;
+
+        compressDXTLayers(
+            engineInterface,
+            dxtType, rowAlignment,
+            rasterFormat, paletteData, paletteType, maxpalette, colorOrder, itemDepth,
+            &layer, 1
+        );
+    }
+    catch( ... )
+    {
+        engineInterface->PixelFree( dxtArray );
 
-            // Increment the block count.
-            compressedBlockCount++;
-        }
+        throw;
     }
 
     // Give the new texels to the runtime, along with the data size.
@@ -57,19 +57,136 @@ inline void copyMipmapLayers( Interface *engineInterface, const containerType& s
         newLayer.layerHeight = srcLayer.layerHeight;
 
         // Copy over the texels.
-        void *newtexels = engineInterface->PixelAllocate( dataSize );
-
+        // Layers that are still waiting for lazy loading have no texels yet.
         const void *srctexels = srcLayer.texels;
 
-        memcpy(newtexels, srctexels, dataSize);
+        if ( srctexels != NULL )
+        {
+            void *newtexels = engineInterface->PixelAllocate( dataSize );
+
+            memcpy(newtexels, srctexels, dataSize);
 
-        newLayer.texels = newtexels;
+            newLayer.texels = newtexels;
+        }
 
         // Put the layer.
         dstLayers[ i ] = newLayer;
     }
 }
 
+// Remembers where the texels of mipmap layers are located in a stream, so that
+// they can be read on first access (see Interface::SetLazyTexelLoading).
+// Removing the source (reset, trim) has to be done under the writer lock of the texture.
+// Textures are materialized under their reader lock, so two threads can get at the same texture at once.
+// Hence loading is serialized by the access lock of the source stream, which the textures of one TXD share.
+struct lazyMipmapSource
+{
+    inline lazyMipmapSource( void ) : srcStream( NULL )
+    {
+        return;
+    }
+
+    inline bool isPending( void ) const
+    {
+        return ( this->srcStream.load( std::memory_order_acquire ) != NULL );
+    }
+
+    inline void setSource( Stream *srcStream )
+    {
+        this->srcStream.store( srcStream, std::memory_order_release );
+    }
+
+    inline void reset( void )
+    {
+        this->mipOffsets.clear();
+        this->srcStream.store( NULL, std::memory_order_release );
+    }
+
+    // Forgets about the layers from mipmapCount on, for when they have been removed.
+    inline void trim( size_t mipmapCount )
+    {
+        if ( mipmapCount == 0 )
+        {
+            this->reset();
+        }
+        else if ( this->mipOffsets.size() > mipmapCount )
+        {
+            this->mipOffsets.resize( mipmapCount );
+        }
+    }
+
+    // Reads all texels that have not been loaded yet.
+    // The stream seek is restored afterwards, so this may be called while the stream is being parsed.
+    template <typename containerType>
+    inline void materialize( Interface *engineInterface, containerType& mipmaps )
+    {
+        Stream *srcStream = this->srcStream.load( std::memory_order_acquire );
+
+        if ( srcStream == NULL )
+            return;
+
+        scoped_rwlock_writer <rwlock> loadingLock( GetStreamAccessLock( srcStream ) );
+
+        // Somebody else could have loaded them while we waited.
+        if ( this->srcStream.load( std::memory_order_relaxed ) == NULL )
+            return;
+
+        int64 savedSeek = srcStream->tell();
+
+        try
+        {
+            size_t mipmapCount = std::min( mipmaps.size(), this->mipOffsets.size() );
+
+            for ( size_t n = 0; n < mipmapCount; n++ )
+            {
+                mipmapLayer& mipLayer = mipmaps[ n ];
+
+                if ( mipLayer.texels != NULL )
+                    continue;
+
+                uint32 dataSize = mipLayer.dataSize;
+
+                void *texels = engineInterface->PixelAllocate( dataSize );
+
+                try
+                {
+                    srcStream->seek( this->mipOffsets[ n ], RWSEEK_BEG );
+
+                    size_t readCount = srcStream->read( texels, dataSize );
+
+                    if ( readCount != dataSize )
+                    {
+                        throw RwException( "failed to read lazily loaded mipmap texels" );
+                    }
+                }
+                catch( ... )
+                {
+                    engineInterface->PixelFree( texels );
+
+                    throw;
+                }
+
+                mipLayer.texels = texels;
+            }
+        }
+        catch( ... )
+        {
+            // Leave the layers that are left as pending, so we can retry.
+            srcStream->seek( savedSeek, RWSEEK_BEG );
+
+            throw;
+        }
+
+        srcStream->seek( savedSeek, RWSEEK_BEG );
+
+        // We do not need the stream anymore.
+        this->reset();
+    }
+
+    std::atomic <Stream*> srcStream;
+    std::vector <int64> mipOffsets;     // absolute stream offset for each mipmap layer
+};
+
 template <typename containerType>
 inline void deleteMipmapLayers( Interface *engineInterface, containerType& mipmaps )
 {
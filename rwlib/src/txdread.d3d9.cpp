@@ -407,6 +407,14 @@ void d3d9NativeTextureTypeProvider::DeserializeTexture( TextureBase *theTexture,
 
                 bool hasDamagedMipmaps = false;
 
+                // Maybe we only have to remember where the texels are.
+                Stream *lazySourceStream = NULL;
+
+                if ( engineInterface->GetLazyTexelLoading() )
+                {
+                    lazySourceStream = texNativeImageStruct.getRootStream();
+                }
+
                 for (uint32 i = 0; i < maybeMipmapCount; i++)
                 {
                     bool couldEstablishLevel = true;
@@ -524,18 +532,31 @@ void d3d9NativeTextureTypeProvider::DeserializeTexture( TextureBase *theTexture,
                     // Otherwise we would just flood the memory in case of an error;
                     // that could be abused by exploiters.
                     texNativeImageStruct.check_read_ahead( texDataSize );
-                    
-                    void *texelData = engineInterface->PixelAllocate( texDataSize );
 
-                    try
+                    void *texelData = NULL;
+
+                    if ( lazySourceStream != NULL )
                     {
-	                    texNativeImageStruct.read( texelData, texDataSize );
+                        // The texels are read on first access.
+                        platformTex->lazyTexels.setSource( lazySourceStream );
+                        platformTex->lazyTexels.mipOffsets.push_back( texNativeImageStruct.tell_absolute() );
+
+                        texNativeImageStruct.skip( texDataSize );
                     }
-                    catch( ... )
+                    else
                     {
-                        engineInterface->PixelFree( texelData );
+                        texelData = engineInterface->PixelAllocate( texDataSize );
 
-                        throw;
+                        try
+                        {
+	                        texNativeImageStruct.read( texelData, texDataSize );
+                        }
+                        catch( ... )
+                        {
+                            engineInterface->PixelFree( texelData );
+
+                            throw;
+                        }
                     }
 
                     // Store mipmap properties.
@@ -444,6 +444,9 @@ struct NativeTextureD3D9 : public d3dpublic::d3dNativeTextureInterface
 
         // Copy image texel information.
         {
+            // We must not share the source stream of lazy texels, because we do not control its lifetime.
+            const_cast <NativeTextureD3D9&> ( right ).materializeTexels();
+
             copyMipmapLayers( engineInterface, right.mipmaps, this->mipmaps );
 
             this->rasterFormat = right.rasterFormat;
@@ -472,6 +475,14 @@ struct NativeTextureD3D9 : public d3dpublic::d3dNativeTextureInterface
         }
 
         deleteMipmapLayers( this->engineInterface, this->mipmaps );
+
+        this->lazyTexels.reset();
+    }
+
+    // Has to be called before the texels of mipmap layers are accessed.
+    inline void materializeTexels( void )
+    {
+        this->lazyTexels.materialize( this->engineInterface, this->mipmaps );
     }
 
     inline ~NativeTextureD3D9( void )
@@ -509,6 +520,8 @@ public:
 
 	std::vector <mipmapLayer> mipmaps;
 
+    genmip::lazyMipmapSource lazyTexels;
+
 	void *palette;
 	uint32 paletteSize;
 
@@ -642,6 +655,13 @@ struct d3d9NativeTextureTypeProvider : public texNativeTypeProvider, d3dpublic::
     bool AddMipmapLayer( Interface *engineInterface, void *objMem, const rawMipmapLayer& layerIn, acquireFeedback_t& feedbackOut );
     void ClearMipmaps( Interface *engineInterface, void *objMem );
 
+    void LoadPendingTexels( Interface *engineInterface, void *objMem ) override
+    {
+        NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
+
+        nativeTex->materializeTexels();
+    }
+
     void* GetNativeInterface( void *objMem ) override
     {
         NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
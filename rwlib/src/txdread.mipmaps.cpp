@@ -11,6 +11,10 @@
 
 #include "txdread.rasterplg.hxx"
 
+#include "rwsimd.hxx"
+
+#include "rwparallel.hxx"
+
 namespace rw
 {
 
@@ -74,107 +78,213 @@ inline uint32 pow2( uint32 val )
     return n;
 }
 
-inline bool performMipmapFiltering(
-    eMipmapGenerationMode mipGenMode,
-    Bitmap& srcBitmap, eColorModel model, uint32 srcPosX, uint32 srcPosY, uint32 mipProcessWidth, uint32 mipProcessHeight,
-    abstractColorItem& colorItem
-)
+// Mipmap pyramids are generated in a fixed 32bit RGBA working format.
+// Every level is reduced from the previous one, so the base level is read only once, no matter
+// how many levels we generate (instead of filtering the base level with a box that doubles
+// its size each level).
+struct mipWorkTexel
+{
+    uint8 r, g, b, a;
+};
+
+#ifdef RWLIB_SIMD_SSE2
+
+// Averages the 2x2 blocks of four texels of each source row into two texels (four 16bit lanes each).
+AINLINE __m128i reduceMipWorkTexels2x2SSE2( __m128i srcRow0, __m128i srcRow1 )
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    // Vertical sums of texels 0,1 and 2,3.
+    __m128i sumLo = _mm_add_epi16( _mm_unpacklo_epi8( srcRow0, zero ), _mm_unpacklo_epi8( srcRow1, zero ) );
+    __m128i sumHi = _mm_add_epi16( _mm_unpackhi_epi8( srcRow0, zero ), _mm_unpackhi_epi8( srcRow1, zero ) );
+
+    // Horizontal sums of the texel pairs.
+    __m128i sum = _mm_add_epi16( _mm_unpacklo_epi64( sumLo, sumHi ), _mm_unpackhi_epi64( sumLo, sumHi ) );
+
+    return _mm_srli_epi16( _mm_add_epi16( sum, _mm_set1_epi16( 2 ) ), 2 );
+}
+
+// Returns the amount of destination texels that have been processed.
+static uint32 reduceMipWorkRow2x2SSE2( const mipWorkTexel *srcRow0, const mipWorkTexel *srcRow1, mipWorkTexel *dstRow, uint32 dstWidth )
 {
-    bool success = false;
+    uint32 n = 0;
 
-    if ( mipGenMode == MIPMAPGEN_DEFAULT )
+    for ( ; n + 4 <= dstWidth; n += 4 )
     {
-        if ( model == COLORMODEL_RGBA )
-        {
-            uint32 redSumm = 0;
-            uint32 greenSumm = 0;
-            uint32 blueSumm = 0;
-            uint32 alphaSumm = 0;
+        const __m128i *src0 = (const __m128i*)( srcRow0 + n * 2 );
+        const __m128i *src1 = (const __m128i*)( srcRow1 + n * 2 );
 
-            // Loop through the texels and calculate a blur.
-            uint32 addCount = 0;
+        __m128i left = reduceMipWorkTexels2x2SSE2( _mm_loadu_si128( src0 ), _mm_loadu_si128( src1 ) );
+        __m128i right = reduceMipWorkTexels2x2SSE2( _mm_loadu_si128( src0 + 1 ), _mm_loadu_si128( src1 + 1 ) );
 
-            for ( uint32 y = 0; y < mipProcessHeight; y++ )
-            {
-                for ( uint32 x = 0; x < mipProcessWidth; x++ )
-                {
-                    uint8 r, g, b, a;
+        _mm_storeu_si128( (__m128i*)( dstRow + n ), _mm_packus_epi16( left, right ) );
+    }
 
-                    bool hasColor = srcBitmap.browsecolor(
-                        x + srcPosX, y + srcPosY,
-                        r, g, b, a
-                    );
+    return n;
+}
 
-                    if ( hasColor )
-                    {
-                        // Add colors together.
-                        redSumm += r;
-                        greenSumm += g;
-                        blueSumm += b;
-                        alphaSumm += a;
+#endif //RWLIB_SIMD_SSE2
 
-                        addCount++;
-                    }
-                }
-            }
+// Reduces a working layer into the next mipmap level.
+// A dimension is either halved (two samples are averaged) or kept, if it has reached 1 already.
+static void reduceMipWorkLayer(
+    const mipWorkTexel *srcTexels, uint32 srcWidth,
+    mipWorkTexel *dstTexels, uint32 dstWidth, uint32 dstHeight,
+    bool halveWidth, bool halveHeight
+)
+{
+    for ( uint32 y = 0; y < dstHeight; y++ )
+    {
+        const mipWorkTexel *srcRow0 = ( srcTexels + ( halveHeight ? y * 2 : y ) * srcWidth );
+        const mipWorkTexel *srcRow1 = ( halveHeight ? srcRow0 + srcWidth : srcRow0 );
 
-            if ( addCount != 0 )
-            {
-                // Calculate the real color.
-                colorItem.rgbaColor.r = std::min( redSumm / addCount, 255u );
-                colorItem.rgbaColor.g = std::min( greenSumm / addCount, 255u );
-                colorItem.rgbaColor.b = std::min( blueSumm / addCount, 255u );
-                colorItem.rgbaColor.a = std::min( alphaSumm / addCount, 255u );
+        mipWorkTexel *dstRow = ( dstTexels + y * dstWidth );
+
+        if ( halveWidth )
+        {
+            // If the height is kept, we average the row with itself, which is the same as a 2x1 filter.
+            uint32 x = 0;
 
-                colorItem.model = COLORMODEL_RGBA;
+#ifdef RWLIB_SIMD_SSE2
+            x = reduceMipWorkRow2x2SSE2( srcRow0, srcRow1, dstRow, dstWidth );
+#endif //RWLIB_SIMD_SSE2
 
-                success = true;
+            for ( ; x < dstWidth; x++ )
+            {
+                const mipWorkTexel& t0 = srcRow0[ x * 2 ];
+                const mipWorkTexel& t1 = srcRow0[ x * 2 + 1 ];
+                const mipWorkTexel& t2 = srcRow1[ x * 2 ];
+                const mipWorkTexel& t3 = srcRow1[ x * 2 + 1 ];
+
+                mipWorkTexel& dstTexel = dstRow[ x ];
+                dstTexel.r = (uint8)( ( t0.r + t1.r + t2.r + t3.r + 2 ) >> 2 );
+                dstTexel.g = (uint8)( ( t0.g + t1.g + t2.g + t3.g + 2 ) >> 2 );
+                dstTexel.b = (uint8)( ( t0.b + t1.b + t2.b + t3.b + 2 ) >> 2 );
+                dstTexel.a = (uint8)( ( t0.a + t1.a + t2.a + t3.a + 2 ) >> 2 );
+            }
+        }
+        else
+        {
+            for ( uint32 x = 0; x < dstWidth; x++ )
+            {
+                const mipWorkTexel& t0 = srcRow0[ x ];
+                const mipWorkTexel& t1 = srcRow1[ x ];
+
+                mipWorkTexel& dstTexel = dstRow[ x ];
+                dstTexel.r = (uint8)( ( t0.r + t1.r + 1 ) >> 1 );
+                dstTexel.g = (uint8)( ( t0.g + t1.g + 1 ) >> 1 );
+                dstTexel.b = (uint8)( ( t0.b + t1.b + 1 ) >> 1 );
+                dstTexel.a = (uint8)( ( t0.a + t1.a + 1 ) >> 1 );
             }
         }
-        else if ( model == COLORMODEL_LUMINANCE )
+    }
+}
+
+// Luminance is kept in the red channel (and alpha in alpha).
+static void fetchMipWorkLayer( const Bitmap& srcBitmap, eColorModel colorModel, mipWorkTexel *workTexels )
+{
+    uint32 width, height;
+    srcBitmap.getSize( width, height );
+
+    eRasterFormat rasterFormat = srcBitmap.getFormat();
+    eColorOrdering colorOrder = srcBitmap.getColorOrder();
+    uint32 depth = srcBitmap.getDepth();
+
+    const void *srcTexels = srcBitmap.getTexelsData();
+
+    uint32 srcRowSize = getRasterDataRowSize( width, depth, srcBitmap.getRowAlignment() );
+
+    colorModelDispatcher <const void> fetchDispatch( rasterFormat, colorOrder, depth, NULL, 0, PALETTE_NONE );
+
+    if ( colorModel == COLORMODEL_RGBA )
+    {
+        colorModelDispatcher <void> workDispatch( RASTER_8888, COLOR_RGBA, 32, NULL, 0, PALETTE_NONE );
+
+        copyTexelDataEx(
+            srcTexels, workTexels,
+            fetchDispatch, workDispatch,
+            width, height,
+            0, 0,
+            0, 0,
+            srcRowSize, width * sizeof( mipWorkTexel )
+        );
+    }
+    else
+    {
+        for ( uint32 y = 0; y < height; y++ )
         {
-            uint32 lumSumm = 0;
-            uint32 alphaSumm = 0;
+            const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, y );
 
-            // Loop through the texels and calculate a blur.
-            uint32 addCount = 0;
+            mipWorkTexel *workRow = ( workTexels + y * width );
 
-            for ( uint32 y = 0; y < mipProcessHeight; y++ )
+            for ( uint32 x = 0; x < width; x++ )
             {
-                for ( uint32 x = 0; x < mipProcessWidth; x++ )
+                uint8 lum, a;
+
+                if ( !fetchDispatch.getLuminance( srcRow, x, lum, a ) )
                 {
-                    uint8 lumm, a;
+                    lum = 0;
+                    a = 0;
+                }
 
-                    bool hasColor = srcBitmap.browselum(
-                        x + srcPosX, y + srcPosY,
-                        lumm, a
-                    );
+                mipWorkTexel& workTexel = workRow[ x ];
+                workTexel.r = lum;
+                workTexel.g = lum;
+                workTexel.b = lum;
+                workTexel.a = a;
+            }
+        }
+    }
+}
 
-                    if ( hasColor )
-                    {
-                        // Add colors together.
-                        lumSumm += lumm;
-                        alphaSumm += a;
+// Returns whether the layer has alpha.
+static bool putMipWorkLayer(
+    const mipWorkTexel *workTexels, uint32 width, uint32 height, eColorModel colorModel,
+    colorModelDispatcher <void>& putDispatch, void *dstTexels, uint32 dstRowSize
+)
+{
+    bool hasAlpha = false;
 
-                        addCount++;
-                    }
-                }
-            }
+    if ( colorModel == COLORMODEL_RGBA )
+    {
+        colorModelDispatcher <const void> workDispatch( RASTER_8888, COLOR_RGBA, 32, NULL, 0, PALETTE_NONE );
 
-            if ( addCount != 0 )
+        copyTexelDataEx(
+            workTexels, dstTexels,
+            workDispatch, putDispatch,
+            width, height,
+            0, 0,
+            0, 0,
+            width * sizeof( mipWorkTexel ), dstRowSize
+        );
+
+        size_t texelCount = ( (size_t)width * height );
+
+        for ( size_t n = 0; n < texelCount; n++ )
+        {
+            if ( workTexels[ n ].a != 255 )
             {
-                // Calculate the real color.
-                colorItem.luminance.lum = std::min( lumSumm / addCount, 255u );
-                colorItem.luminance.alpha = std::min( alphaSumm / addCount, 255u );
+                hasAlpha = true;
+                break;
+            }
+        }
+    }
+    else
+    {
+        for ( uint32 y = 0; y < height; y++ )
+        {
+            const mipWorkTexel *workRow = ( workTexels + y * width );
 
-                colorItem.model = COLORMODEL_LUMINANCE;
+            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, y );
 
-                success = true;
+            for ( uint32 x = 0; x < width; x++ )
+            {
+                putDispatch.setLuminance( dstRow, x, workRow[ x ].r, workRow[ x ].a );
             }
         }
     }
 
-    return success;
+    return hasAlpha;
 }
 
 template <typename dataType, typename containerType>
@@ -224,8 +334,6 @@ void Raster::generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGe
     if ( oldMipmapCount == 0 )
         return;
 
-    // Do the generation.
-    // We process the image in 2x2 blocks for the level index 1, 4x4 for level index 2, ...
     uint32 firstLevelWidth, firstLevelHeight;
     textureBitmap.getSize( firstLevelWidth, firstLevelHeight );
 
@@ -242,38 +350,79 @@ void Raster::generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGe
         throw RwException( "invalid raster dimensions in mipmap generation" );
     }
 
-    uint32 curMipProcessWidth = 1;
-    uint32 curMipProcessHeight = 1;
+    // Is there anything to generate at all?
+    if ( oldMipmapCount >= maxMipmapCount )
+        return;
+
+    eColorModel srcColorModel = textureBitmap.getColorModel();
 
-    uint32 curMipIndex = 0;
+    // Only the default (box) filter is implemented; other modes give cleared levels.
+    bool canFilter = ( mipGenMode == MIPMAPGEN_DEFAULT && ( srcColorModel == COLORMODEL_RGBA || srcColorModel == COLORMODEL_LUMINANCE ) );
 
-    uint32 actualNewMipmapCount = oldMipmapCount;
+    // Working layers: the current level and the one we reduce into.
+    // The second buffer never has to be bigger than the first reduced level.
+    mipWorkTexel *curWorkTexels = NULL;
+    mipWorkTexel *nextWorkTexels = NULL;
 
-    while ( true )
+    if ( canFilter )
     {
-        bool canProcess = false;
+        curWorkTexels = (mipWorkTexel*)engineInterface->PixelAllocate( (size_t)firstLevelWidth * firstLevelHeight * sizeof( mipWorkTexel ) );
 
-        if ( !canProcess )
+        try
         {
-            if ( curMipIndex >= oldMipmapCount )
-            {
-                canProcess = true;
-            }
+            size_t nextWorkSize = ( (size_t)std::max( 1u, firstLevelWidth / 2 ) * std::max( 1u, firstLevelHeight / 2 ) * sizeof( mipWorkTexel ) );
+
+            nextWorkTexels = (mipWorkTexel*)engineInterface->PixelAllocate( nextWorkSize );
+
+            fetchMipWorkLayer( textureBitmap, srcColorModel, curWorkTexels );
         }
+        catch( ... )
+        {
+            engineInterface->PixelFree( curWorkTexels );
+            engineInterface->PixelFree( nextWorkTexels );
 
-        if ( canProcess )
+            throw;
+        }
+    }
+
+    try
+    {
+        colorModelDispatcher <void> putDispatch( tmpRasterFormat, tmpColorOrder, firstLevelDepth, NULL, 0, PALETTE_NONE );
+
+        uint32 curMipIndex = 0;
+
+        while ( true )
         {
-            // Check whether the current gen index does not overshoot the max gen count.
+            uint32 prevMipWidth = mipLevelGen.getLevelWidth();
+
+            // Go to the next level.
+            if ( !mipLevelGen.incrementLevel() )
+                break;
+
+            curMipIndex++;
+
             if ( curMipIndex >= maxMipmapCount )
-            {
                 break;
-            }
 
-            // Get the processing dimensions.
             uint32 mipWidth = mipLevelGen.getLevelWidth();
             uint32 mipHeight = mipLevelGen.getLevelHeight();
 
-            // Allocate the new bitmap.
+            if ( canFilter )
+            {
+                reduceMipWorkLayer(
+                    curWorkTexels, prevMipWidth,
+                    nextWorkTexels, mipWidth, mipHeight,
+                    mipLevelGen.didIncrementWidth(), mipLevelGen.didIncrementHeight()
+                );
+
+                std::swap( curWorkTexels, nextWorkTexels );
+            }
+
+            // Levels that exist already are only needed for the reduction.
+            if ( curMipIndex < oldMipmapCount )
+                continue;
+
+            // Allocate the new layer.
             uint32 texRowSize = getRasterDataRowSize( mipWidth, firstLevelDepth, firstLevelRowAlignment );
 
             uint32 texDataSize = getRasterDataSizeByRowSize( texRowSize, mipHeight );
@@ -286,56 +435,25 @@ void Raster::generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGe
 
             try
             {
-                // Process the pixels.
-                bool hasAlpha = false;
-
-                colorModelDispatcher <void> putDispatch( tmpRasterFormat, tmpColorOrder, firstLevelDepth, NULL, 0, PALETTE_NONE );
+                bool hasAlpha;
 
-                eColorModel srcColorModel = textureBitmap.getColorModel();
-                   
-                for ( uint32 mip_y = 0; mip_y < mipHeight; mip_y++ )
+                if ( canFilter )
                 {
-                    void *dstRow = getTexelDataRow( newtexels, texRowSize, mip_y );
-
-                    for ( uint32 mip_x = 0; mip_x < mipWidth; mip_x++ )
+                    hasAlpha = putMipWorkLayer( curWorkTexels, mipWidth, mipHeight, srcColorModel, putDispatch, newtexels, texRowSize );
+                }
+                else
+                {
+                    for ( uint32 mip_y = 0; mip_y < mipHeight; mip_y++ )
                     {
-                        // Get the color for this pixel.
-                        abstractColorItem colorItem;
-
-                        // Perform a filter operation on the currently selected texture block.
-                        uint32 mipProcessWidth = curMipProcessWidth;
-                        uint32 mipProcessHeight = curMipProcessHeight;
-
-                        bool couldPerform = performMipmapFiltering(
-                            mipGenMode,
-                            textureBitmap, srcColorModel,
-                            mip_x * mipProcessWidth, mip_y * mipProcessHeight,
-                            mipProcessWidth, mipProcessHeight,
-                            colorItem
-                        );
-
-                        // Put the color.
-                        if ( couldPerform == true )
-                        {
-                            // Decide if we have alpha.
-                            if ( srcColorModel == COLORMODEL_RGBA )
-                            {
-                                if ( colorItem.rgbaColor.a != 255 )
-                                {
-                                    hasAlpha = true;
-                                }
-                            }
-
-                            putDispatch.setColor( dstRow, mip_x, colorItem );
-                        }
-                        else
-                        {
-                            // We do have alpha.
-                            hasAlpha = true;
+                        void *dstRow = getTexelDataRow( newtexels, texRowSize, mip_y );
 
+                        for ( uint32 mip_x = 0; mip_x < mipWidth; mip_x++ )
+                        {
                             putDispatch.clearColor( dstRow, mip_x );
                         }
                     }
+
+                    hasAlpha = true;
                 }
 
                 // Push the texels into the texture.
@@ -386,34 +504,43 @@ void Raster::generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGe
                 // If we failed to add any mipmap, we abort operation.
                 break;
             }
-
-            // We have a new mipmap.
-            actualNewMipmapCount++;
         }
+    }
+    catch( ... )
+    {
+        engineInterface->PixelFree( curWorkTexels );
+        engineInterface->PixelFree( nextWorkTexels );
 
-        // Increment mip index.
-        curMipIndex++;
+        throw;
+    }
 
-        // Process parameters.
-        bool shouldContinue = mipLevelGen.incrementLevel();
+    engineInterface->PixelFree( curWorkTexels );
+    engineInterface->PixelFree( nextWorkTexels );
+}
 
-        if ( shouldContinue )
-        {
-            if ( mipLevelGen.didIncrementWidth() )
-            {
-                curMipProcessWidth *= 2;
-            }
+// Parallel mipmap generation of multiple rasters.
+// Every raster is a task of its own, because the levels of a pyramid depend on each other.
+struct mipmapGenerationJob
+{
+    Raster *const *rasters;
 
-            if ( mipLevelGen.didIncrementHeight() )
-            {
-                curMipProcessHeight *= 2;
-            }
-        }
-        else
-        {
-            break;
-        }
+    uint32 maxMipmapCount;
+    eMipmapGenerationMode mipGenMode;
+
+    inline void operator () ( size_t rasterIndex )
+    {
+        this->rasters[ rasterIndex ]->generateMipmaps( this->maxMipmapCount, this->mipGenMode );
     }
+};
+
+void GenerateMipmapsParallel( Interface *engineInterface, Raster *const *rasters, size_t rasterCount, uint32 maxMipmapCount, eMipmapGenerationMode mipGenMode )
+{
+    mipmapGenerationJob job;
+    job.rasters = rasters;
+    job.maxMipmapCount = maxMipmapCount;
+    job.mipGenMode = mipGenMode;
+
+    ParallelForEach( engineInterface, rasterCount, job );
 }
 
-}
\ No newline at end of file
+}
@@ -305,6 +305,14 @@ struct texNativeTypeProvider abstract
         return 0;
     }
 
+    // Native textures that load their texels lazily have to read them here, so that they do not
+    // need their deserialization stream anymore (see Interface::SetLazyTexelLoading).
+    virtual void            LoadPendingTexels( Interface *engineInterface, void *objMem )
+    {
+        // Most native textures read all of their texels during deserialization.
+        return;
+    }
+
     struct
     {
         RwTypeSystem::typeInfoBase *rwTexType;
@@ -14,6 +14,8 @@
 
 #include "txdread.rasterplg.hxx"
 
+#include "rwmem.hxx"
+
 #ifdef RWLIB_INCLUDE_LIBIMAGEQUANT
 // Include the libimagequant library headers.
 #include <libimagequant.h>
@@ -22,9 +24,10 @@
 namespace rw
 {
 
+template <typename linkFinderType>
 inline void nativePaletteRemap(
     Interface *engineInterface,
-    palettizer& conv, ePaletteType convPaletteFormat, uint32 convItemDepth,
+    linkFinderType& linkFinder, ePaletteType convPaletteFormat, uint32 convItemDepth,
     const void *texelSource, uint32 mipWidth, uint32 mipHeight,
     ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteCount,
     eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcItemDepth,
@@ -68,7 +71,7 @@ inline void nativePaletteRemap(
                 alpha = 0;
             }
 
-            uint32 paletteIndex = conv.getclosestlink(red, green, blue, alpha);
+            uint32 paletteIndex = linkFinder.find(red, green, blue, alpha);
 
             // Store it in the palette data.
             setpaletteindex(dstRow, col, convItemDepth, convPaletteFormat, paletteIndex);
@@ -133,6 +136,136 @@ static void _fetch_image_data_libquant(liq_color row_out[], int row_index, int w
 }
 #endif //RWLIB_INCLUDE_LIBIMAGEQUANT
 
+// Builds a palette with one of the palettizers that are embedded into rwtools and remaps all mipmap layers to it.
+template <typename palettizerType>
+static void nativePalettizeMipmaps(
+    Interface *engineInterface, palettizerType& conv, pixelDataTraversal& pixelData,
+    ePaletteType convPaletteFormat, eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth, uint32 dstRowAlignment,
+    uint32 maxPaletteEntries
+)
+{
+    uint32 mipmapCount = (uint32)pixelData.mipmaps.size();
+
+    eRasterFormat srcRasterFormat = pixelData.rasterFormat;
+    eColorOrdering srcColorOrder = pixelData.colorOrder;
+    uint32 srcDepth = pixelData.depth;
+    uint32 srcRowAlignment = pixelData.rowAlignment;
+
+    ePaletteType srcPaletteType = pixelData.paletteType;
+    void *srcPaletteData = pixelData.paletteData;
+    uint32 srcPaletteCount = pixelData.paletteSize;
+
+    // Linear eliminate unique texels.
+    // Use only the first texture.
+    if ( mipmapCount > 0 )
+    {
+        pixelDataTraversal::mipmapResource& mainLayer = pixelData.mipmaps[ 0 ];
+
+        uint32 srcWidth = mainLayer.mipWidth;
+        uint32 srcHeight = mainLayer.mipHeight;
+        uint32 srcStride = mainLayer.width;
+        void *texelSource = mainLayer.texels;
+
+        uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, srcRowAlignment );
+
+#if 0
+        // First define properties to use for linear elimination.
+        for (uint32 y = 0; y < srcHeight; y++)
+        {
+            for (uint32 x = 0; x < srcWidth; x++)
+            {
+                uint32 colorIndex = PixelFormat::coord2index(x, y, srcWidth);
+
+                uint8 red, green, blue, alpha;
+                bool hasColor = browsetexelcolor(texelSource, paletteType, paletteData, maxpalette, colorIndex, rasterFormat, red, green, blue, alpha);
+
+                if ( hasColor )
+                {
+                    conv.characterize(red, green, blue, alpha);
+                }
+            }
+        }
+
+        // Prepare the linear elimination.
+        conv.after_characterize();
+#endif
+
+        colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteCount, srcPaletteType );
+
+        // Linear eliminate.
+        for (uint32 y = 0; y < srcHeight; y++)
+        {
+            const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, y );
+
+            for (uint32 x = 0; x < srcWidth; x++)
+            {
+                uint8 red, green, blue, alpha;
+                bool hasColor = fetchDispatch.getRGBA( srcRow, x, red, green, blue, alpha );
+
+                if ( hasColor )
+                {
+                    conv.feedcolor(red, green, blue, alpha);
+                }
+            }
+        }
+    }
+
+    // Construct a palette out of the remaining colors.
+    conv.constructpalette(maxPaletteEntries);
+
+    // Every mipmap layer is remapped against the same palette.
+    typename palettizerType::closestLinkFinder linkFinder( conv.texelElimData );
+
+    // Point each color from the original texture to the palette.
+    for (uint32 n = 0; n < mipmapCount; n++)
+    {
+        // Create palette index memory for each mipmap.
+        pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+
+        uint32 srcWidth = mipLayer.width;
+        uint32 srcHeight = mipLayer.height;
+        void *texelSource = mipLayer.texels;
+
+        uint32 itemCount = ( srcWidth * srcHeight );
+        
+        uint32 dataSize = 0;
+        void *newTexelData = NULL;
+
+        // Remap the texels.
+        nativePaletteRemap(
+            engineInterface,
+            linkFinder, convPaletteFormat, dstDepth,
+            texelSource, srcWidth, srcHeight,
+            srcPaletteType, srcPaletteData, srcPaletteCount, srcRasterFormat, srcColorOrder, srcDepth,
+            srcRowAlignment, dstRowAlignment,
+            newTexelData, dataSize
+        );
+
+        // Replace texture data.
+        if ( newTexelData != texelSource )
+        {
+            if ( texelSource )
+            {
+                engineInterface->PixelFree( texelSource );
+            }
+
+            mipLayer.texels = newTexelData;
+        }
+
+        mipLayer.dataSize = dataSize;
+    }
+
+    // Delete the old palette data (if available).
+    if (srcPaletteData != NULL)
+    {
+        engineInterface->PixelFree( srcPaletteData );
+    }
+
+    // Store the new palette texels.
+    pixelData.paletteData = conv.makepalette(engineInterface, dstRasterFormat, dstColorOrder);
+    pixelData.paletteSize = (uint32)conv.texelElimData.size();
+}
+
 // Custom algorithm for palettizing image data.
 // This routine is called by ConvertPixelData. It should not be called from anywhere else.
 void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelData, const pixelFormat& dstPixelFormat )
@@ -219,112 +352,23 @@ void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelDa
         {
             palettizer conv;
 
-            // Linear eliminate unique texels.
-            // Use only the first texture.
-            if ( mipmapCount > 0 )
-            {
-                pixelDataTraversal::mipmapResource& mainLayer = pixelData.mipmaps[ 0 ];
-
-                uint32 srcWidth = mainLayer.mipWidth;
-                uint32 srcHeight = mainLayer.mipHeight;
-                uint32 srcStride = mainLayer.width;
-                void *texelSource = mainLayer.texels;
-
-                uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, srcRowAlignment );
-
-#if 0
-                // First define properties to use for linear elimination.
-                for (uint32 y = 0; y < srcHeight; y++)
-                {
-                    for (uint32 x = 0; x < srcWidth; x++)
-                    {
-                        uint32 colorIndex = PixelFormat::coord2index(x, y, srcWidth);
-
-                        uint8 red, green, blue, alpha;
-                        bool hasColor = browsetexelcolor(texelSource, paletteType, paletteData, maxpalette, colorIndex, rasterFormat, red, green, blue, alpha);
-
-                        if ( hasColor )
-                        {
-                            conv.characterize(red, green, blue, alpha);
-                        }
-                    }
-                }
-
-                // Prepare the linear elimination.
-                conv.after_characterize();
-#endif
-
-                colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteCount, srcPaletteType );
-
-                // Linear eliminate.
-                for (uint32 y = 0; y < srcHeight; y++)
-                {
-                    const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, y );
-
-                    for (uint32 x = 0; x < srcWidth; x++)
-                    {
-                        uint8 red, green, blue, alpha;
-                        bool hasColor = fetchDispatch.getRGBA( srcRow, x, red, green, blue, alpha );
-
-                        if ( hasColor )
-                        {
-                            conv.feedcolor(red, green, blue, alpha);
-                        }
-                    }
-                }
-            }
-
-            // Construct a palette out of the remaining colors.
-            conv.constructpalette(maxPaletteEntries);
-
-            // Point each color from the original texture to the palette.
-            for (uint32 n = 0; n < mipmapCount; n++)
-            {
-                // Create palette index memory for each mipmap.
-                pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
-
-                uint32 srcWidth = mipLayer.width;
-                uint32 srcHeight = mipLayer.height;
-                void *texelSource = mipLayer.texels;
-
-                uint32 itemCount = ( srcWidth * srcHeight );
-                
-                uint32 dataSize = 0;
-                void *newTexelData = NULL;
-
-                // Remap the texels.
-                nativePaletteRemap(
-                    engineInterface,
-                    conv, convPaletteFormat, dstDepth,
-                    texelSource, srcWidth, srcHeight,
-                    srcPaletteType, srcPaletteData, srcPaletteCount, srcRasterFormat, srcColorOrder, srcDepth,
-                    srcRowAlignment, dstRowAlignment,
-                    newTexelData, dataSize
-                );
-
-                // Replace texture data.
-                if ( newTexelData != texelSource )
-                {
-                    if ( texelSource )
-                    {
-                        engineInterface->PixelFree( texelSource );
-                    }
-
-                    mipLayer.texels = newTexelData;
-                }
-
-                mipLayer.dataSize = dataSize;
-            }
+            nativePalettizeMipmaps(
+                engineInterface, conv, pixelData,
+                convPaletteFormat, dstRasterFormat, dstColorOrder, dstDepth, dstRowAlignment,
+                maxPaletteEntries
+            );
 
-            // Delete the old palette data (if available).
-            if (srcPaletteData != NULL)
-            {
-                engineInterface->PixelFree( srcPaletteData );
-            }
+            palettizeSuccess = true;
+        }
+        else if (useRuntime == PALRUNTIME_MEDIANCUT)
+        {
+            medianCutPalettizer conv;
 
-            // Store the new palette texels.
-            pixelData.paletteData = conv.makepalette(engineInterface, dstRasterFormat, dstColorOrder);
-            pixelData.paletteSize = (uint32)conv.texelElimData.size();
+            nativePalettizeMipmaps(
+                engineInterface, conv, pixelData,
+                convPaletteFormat, dstRasterFormat, dstColorOrder, dstDepth, dstRowAlignment,
+                maxPaletteEntries
+            );
 
             palettizeSuccess = true;
         }
@@ -789,11 +833,8 @@ void RemapMipmapLayer(
 
     paletteSize = std::min( addressiblePaletteSize, paletteSize );
 
-    if ( palRuntimeType == PALRUNTIME_NATIVE )
+    if ( palRuntimeType == PALRUNTIME_NATIVE || palRuntimeType == PALRUNTIME_MEDIANCUT )
     {
-        // Do some complex remapping.
-        palettizer remapper;
-
         // Create an array with all the palette colors.
         palettizer::texelContainer_t paletteContainer;
 
@@ -822,18 +863,34 @@ void RemapMipmapLayer(
             paletteContainer[ n ] = inTexel;
         }
 
-        // Put the palette texels into the remapper.
-        remapper.texelElimData = paletteContainer;
-
-        // Do the remap.
-        nativePaletteRemap(
-            engineInterface,
-            remapper, convPaletteType, convItemDepth,
-            mipTexels, mipWidth, mipHeight, mipPaletteType, mipPaletteData, mipPaletteSize,
-            mipRasterFormat, mipColorOrder, mipDepth,
-            srcRowAlignment, dstRowAlignment,
-            dstTexelsOut, dstTexelDataSizeOut
-        );
+        // Match colors the same way the palettizer of the runtime did.
+        if ( palRuntimeType == PALRUNTIME_MEDIANCUT )
+        {
+            medianCutPalettizer::closestLinkFinder linkFinder( paletteContainer );
+
+            nativePaletteRemap(
+                engineInterface,
+                linkFinder, convPaletteType, convItemDepth,
+                mipTexels, mipWidth, mipHeight, mipPaletteType, mipPaletteData, mipPaletteSize,
+                mipRasterFormat, mipColorOrder, mipDepth,
+                srcRowAlignment, dstRowAlignment,
+                dstTexelsOut, dstTexelDataSizeOut
+            );
+        }
+        else
+        {
+            // Do some complex remapping.
+            palettizer::closestLinkFinder linkFinder( paletteContainer );
+
+            nativePaletteRemap(
+                engineInterface,
+                linkFinder, convPaletteType, convItemDepth,
+                mipTexels, mipWidth, mipHeight, mipPaletteType, mipPaletteData, mipPaletteSize,
+                mipRasterFormat, mipColorOrder, mipDepth,
+                srcRowAlignment, dstRowAlignment,
+                dstTexelsOut, dstTexelDataSizeOut
+            );
+        }
     }
     else if ( palRuntimeType == PALRUNTIME_PNGQUANT )
     {
@@ -903,12 +960,15 @@ void RemapMipmapLayer(
     
         assert( liq_res != NULL );
 
+        // Temporary buffers of the remap are released together when we are done.
+        rwScratchArena scratchMem( engineInterface );
+
         // If convPaletteDepth is 8, basically what libimagequant outputs as, we can directly take those pixels.
         // Otherwise we need a temporary buffer where libimagequant will write into and we transform to correct format afterward.
         if ( convItemDepth == 8 )
         {
             // Split it into rows.
-            void **rowp = (void**)engineInterface->PixelAllocate( sizeof(void*) * mipHeight );
+            void **rowp = (void**)scratchMem.Allocate( sizeof(void*) * mipHeight );
 
             assert( rowp != NULL );
 
@@ -929,7 +989,7 @@ void RemapMipmapLayer(
 
             uint32 liqPackedDataSize = ( liqPackedRowSize * mipHeight );
 
-            void *liqBuf = engineInterface->PixelAllocate( liqPackedDataSize );
+            void *liqBuf = scratchMem.Allocate( liqPackedDataSize );
 
             assert( liqBuf != NULL );
 
@@ -945,9 +1005,6 @@ void RemapMipmapLayer(
                 8, convItemDepth,
                 1, dstRowAlignment
             );
-
-            // Free the temporary buffer.
-            engineInterface->PixelFree( liqBuf );
         }
 
         // Clean up after ourselves.
@@ -1,5 +1,6 @@
 #include <map>
 #include <algorithm>
+#include <iterator>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
@@ -854,6 +855,11 @@ struct palettizer
     }
 
     inline void* makepalette(Interface *engineInterface, eRasterFormat rasterFormat, eColorOrdering colorOrder)
+    {
+        return makepalette(engineInterface, texelElimData, rasterFormat, colorOrder);
+    }
+
+    static inline void* makepalette(Interface *engineInterface, const texelContainer_t& texelElimData, eRasterFormat rasterFormat, eColorOrdering colorOrder)
     {
         uint32 palDepth = Bitmap::getRasterFormatDepth(rasterFormat);
 
@@ -919,6 +925,856 @@ struct palettizer
 
         return closestIndex;
     }
+
+    // Finds the same palette entries as getclosestlink, but fast enough for remapping whole images.
+    // The palette colors are put into colordiffCriteria space only once, the search is pruned along the
+    // axis in which the palette is spread the most (the criterion is never smaller than the distance
+    // along a single axis) and results are cached by packed RGBA, because images repeat colors a lot.
+    struct closestLinkFinder
+    {
+        inline closestLinkFinder( const texelContainer_t& paletteColors )
+        {
+            colordiffCriteria parser;
+
+            size_t paletteCount = paletteColors.size();
+
+            std::vector <paletteEntry> entries( paletteCount );
+
+            for ( size_t n = 0; n < paletteCount; n++ )
+            {
+                const texel_t& palColor = paletteColors[ n ];
+
+                paletteEntry& entry = entries[ n ];
+
+                double hue;
+                parser.getHSVPropertiesOfColor( palColor, hue, entry.vec );
+
+                entry.alpha = color2double( palColor.alpha );
+                entry.index = (uint32)n;
+            }
+
+            // Pick the axis with the biggest spread.
+            double minCoords[4] = { 0, 0, 0, 0 };
+            double maxCoords[4] = { 0, 0, 0, 0 };
+
+            for ( size_t n = 0; n < paletteCount; n++ )
+            {
+                for ( uint32 axis = 0; axis < 4; axis++ )
+                {
+                    double coord = getAxisCoord( entries[ n ].vec, axis );
+
+                    if ( n == 0 || coord < minCoords[ axis ] )
+                    {
+                        minCoords[ axis ] = coord;
+                    }
+
+                    if ( n == 0 || coord > maxCoords[ axis ] )
+                    {
+                        maxCoords[ axis ] = coord;
+                    }
+                }
+            }
+
+            uint32 sortAxis = 0;
+
+            for ( uint32 axis = 1; axis < 4; axis++ )
+            {
+                if ( maxCoords[ axis ] - minCoords[ axis ] > maxCoords[ sortAxis ] - minCoords[ sortAxis ] )
+                {
+                    sortAxis = axis;
+                }
+            }
+
+            for ( paletteEntry& entry : entries )
+            {
+                entry.sortCoord = getAxisCoord( entry.vec, sortAxis );
+            }
+
+            std::stable_sort( entries.begin(), entries.end(), isEntryBelow );
+
+            this->sortAxis = sortAxis;
+            this->sortedEntries = std::move( entries );
+
+            // Empty cache.
+            cacheEntry emptyEntry;
+            emptyEntry.packedColor = 0;
+            emptyEntry.paletteIndex = INVALID_INDEX;
+
+            this->resultCache.resize( CACHE_SIZE, emptyEntry );
+        }
+
+        inline uint32 find( uint8 red, uint8 green, uint8 blue, uint8 alpha )
+        {
+            uint32 packedColor = ( (uint32)red | ( (uint32)green << 8 ) | ( (uint32)blue << 16 ) | ( (uint32)alpha << 24 ) );
+
+            cacheEntry& cached = this->resultCache[ ( packedColor * 2654435761u ) >> ( 32 - CACHE_BITS ) ];
+
+            if ( cached.paletteIndex != INVALID_INDEX && cached.packedColor == packedColor )
+            {
+                return cached.paletteIndex;
+            }
+
+            texel_t theTexel;
+            theTexel.red = red;
+            theTexel.green = green;
+            theTexel.blue = blue;
+            theTexel.alpha = alpha;
+
+            colordiffCriteria parser;
+
+            colordiffCriteria::vec4_t texelVec;
+            double texelHue;
+
+            parser.getHSVPropertiesOfColor( theTexel, texelHue, texelVec );
+
+            double texelAlpha = color2double( alpha );
+            double texelCoord = getAxisCoord( texelVec, this->sortAxis );
+
+            const paletteEntry *entries = this->sortedEntries.data();
+            size_t entryCount = this->sortedEntries.size();
+
+            // Start at the first entry that is not below the texel on the sort axis and walk outwards.
+            size_t upper = 0;
+
+            while ( upper < entryCount && entries[ upper ].sortCoord < texelCoord )
+            {
+                upper++;
+            }
+
+            size_t lower = upper;
+
+            uint32 closestIndex = INVALID_INDEX;
+            double closest = 0;
+
+            bool canGoUp = ( upper < entryCount );
+            bool canGoDown = ( lower > 0 );
+
+            while ( canGoUp || canGoDown )
+            {
+                if ( canGoUp )
+                {
+                    const paletteEntry& entry = entries[ upper ];
+
+                    if ( closestIndex != INVALID_INDEX && isBeyondBound( entry.sortCoord - texelCoord, closest ) )
+                    {
+                        canGoUp = false;
+                    }
+                    else
+                    {
+                        checkEntry( entry, texelVec, texelAlpha, closestIndex, closest );
+
+                        upper++;
+
+                        canGoUp = ( upper < entryCount );
+                    }
+                }
+
+                if ( canGoDown )
+                {
+                    const paletteEntry& entry = entries[ lower - 1 ];
+
+                    if ( closestIndex != INVALID_INDEX && isBeyondBound( texelCoord - entry.sortCoord, closest ) )
+                    {
+                        canGoDown = false;
+                    }
+                    else
+                    {
+                        checkEntry( entry, texelVec, texelAlpha, closestIndex, closest );
+
+                        lower--;
+
+                        canGoDown = ( lower > 0 );
+                    }
+                }
+            }
+
+            assert( closestIndex != INVALID_INDEX );
+
+            cached.packedColor = packedColor;
+            cached.paletteIndex = closestIndex;
+
+            return closestIndex;
+        }
+
+    private:
+        static const uint32 INVALID_INDEX = 0xFFFFFFFF;
+
+        static const uint32 CACHE_BITS = 12;
+        static const uint32 CACHE_SIZE = ( 1 << CACHE_BITS );
+
+        struct paletteEntry
+        {
+            colordiffCriteria::vec4_t vec;
+            double alpha;
+            double sortCoord;
+            uint32 index;
+        };
+
+        struct cacheEntry
+        {
+            uint32 packedColor;
+            uint32 paletteIndex;
+        };
+
+        static inline double getAxisCoord( const colordiffCriteria::vec4_t& vec, uint32 axis )
+        {
+            switch( axis )
+            {
+            case 0: return vec.x;
+            case 1: return vec.y;
+            case 2: return vec.z;
+            }
+
+            return vec.w;
+        }
+
+        static inline bool isEntryBelow( const paletteEntry& left, const paletteEntry& right )
+        {
+            return ( left.sortCoord < right.sortCoord );
+        }
+
+        // Tiny slack, so that rounding of the real criterion cannot make us skip an equal candidate.
+        static inline bool isBeyondBound( double axisDistance, double closest )
+        {
+            return ( axisDistance > closest * ( 1.0 + 1e-9 ) + 1e-12 );
+        }
+
+        static inline void checkEntry(
+            const paletteEntry& entry, const colordiffCriteria::vec4_t& texelVec, double texelAlpha,
+            uint32& closestIndex, double& closest
+        )
+        {
+            // Same math as colordiffCriteria::getCriteria.
+            colordiffCriteria::vec4_t vecDiff;
+            vecDiff.x = ( texelVec.x - entry.vec.x );
+            vecDiff.y = ( texelVec.y - entry.vec.y );
+            vecDiff.z = ( texelVec.z - entry.vec.z );
+            vecDiff.w = ( texelVec.w - entry.vec.w );
+
+            colordiffCriteria::result_t result;
+            result.distance = sqrt( vecDiff.x*vecDiff.x + vecDiff.y*vecDiff.y + vecDiff.z*vecDiff.z + vecDiff.w*vecDiff.w );
+            result.alphaDist = fabs( texelAlpha - entry.alpha );
+
+            double criterion = result.getCriterion();
+
+            // getclosestlink keeps the first of equally close entries, so ties go to the lower index.
+            if ( closestIndex == INVALID_INDEX || criterion < closest || ( criterion == closest && entry.index < closestIndex ) )
+            {
+                closestIndex = entry.index;
+                closest = criterion;
+            }
+        }
+
+        uint32 sortAxis;
+        std::vector <paletteEntry> sortedEntries;
+
+        std::vector <cacheEntry> resultCache;
+    };
+};
+
+// Palettizer that works on a histogram of the image colors instead of comparing the unique texels pairwise.
+// The histogram is split into boxes by median cut and the box means are then refined by a few
+// rounds of k-means, so the cost grows with the texel count instead of the square of the unique colors.
+// Colors are compared by their squared RGBA distance.
+struct medianCutPalettizer
+{
+    typedef palettizer::texel_t texel_t;
+    typedef palettizer::texelContainer_t texelContainer_t;
+
+    static const uint32 refinementIterations = 4;
+
+    texelContainer_t texelElimData;
+
+    inline medianCutPalettizer( void )
+    {
+        this->colorSamples.reserve( maxbufferedsamples );
+    }
+
+    inline void feedcolor(uint8 red, uint8 green, uint8 blue, uint8 alpha)
+    {
+        this->colorSamples.push_back( packcolor( red, green, blue, alpha ) );
+
+        if ( this->colorSamples.size() >= maxbufferedsamples )
+        {
+            flushsamples();
+        }
+    }
+
+    inline void constructpalette(uint32 maxentries)
+    {
+        flushsamples();
+
+        texelElimData.clear();
+
+        size_t histogramCount = this->histogram.size();
+
+        if ( histogramCount == 0 || maxentries == 0 )
+        {
+            if ( maxentries != 0 )
+            {
+                // Keep the palette usable for remapping.
+                texelElimData.push_back( texel_t() );
+            }
+
+            return;
+        }
+
+        // Split the histogram into at most maxentries boxes.
+        // Each time we split the box that has the biggest error, at the weighted median of its widest axis.
+        std::vector <colorBox> boxes;
+        boxes.reserve( maxentries );
+
+        {
+            colorBox rootBox;
+            rootBox.begin = 0;
+            rootBox.end = (uint32)histogramCount;
+
+            calculateboxstats( rootBox );
+
+            boxes.push_back( rootBox );
+        }
+
+        while ( boxes.size() < maxentries )
+        {
+            size_t splitBoxIndex = boxes.size();
+
+            for ( size_t n = 0; n < boxes.size(); n++ )
+            {
+                const colorBox& box = boxes[ n ];
+
+                if ( box.end - box.begin < 2 || box.error <= 0 )
+                    continue;
+
+                if ( splitBoxIndex == boxes.size() || box.error > boxes[ splitBoxIndex ].error )
+                {
+                    splitBoxIndex = n;
+                }
+            }
+
+            if ( splitBoxIndex == boxes.size() )
+            {
+                // Every box is down to one color.
+                break;
+            }
+
+            colorBox& splitBox = boxes[ splitBoxIndex ];
+
+            isComponentBelow sortPred;
+            sortPred.component = splitBox.splitAxis;
+
+            std::sort( this->histogram.begin() + splitBox.begin, this->histogram.begin() + splitBox.end, sortPred );
+
+            // Find the weighted median, but leave at least one color on each side.
+            uint64 halfCount = ( splitBox.count / 2 );
+            uint64 accumCount = 0;
+
+            uint32 splitAt = splitBox.begin + 1;
+
+            for ( uint32 n = splitBox.begin; n < splitBox.end - 1; n++ )
+            {
+                accumCount += this->histogram[ n ].count;
+
+                splitAt = ( n + 1 );
+
+                if ( accumCount >= halfCount )
+                    break;
+            }
+
+            colorBox upperBox;
+            upperBox.begin = splitAt;
+            upperBox.end = splitBox.end;
+
+            splitBox.end = splitAt;
+
+            calculateboxstats( splitBox );
+            calculateboxstats( upperBox );
+
+            boxes.push_back( upperBox );
+        }
+
+        texelElimData.resize( boxes.size() );
+
+        for ( size_t n = 0; n < boxes.size(); n++ )
+        {
+            texel_t& palColor = texelElimData[ n ];
+
+            boxes[ n ].getmeancolor( palColor );
+
+            palColor.usageCount = (uint32)std::min( boxes[ n ].count, (uint64)0xFFFFFFFF );
+        }
+
+        // Refine the palette by moving each color to the mean of the histogram colors that map to it.
+        for ( uint32 iter = 0; iter < refinementIterations; iter++ )
+        {
+            size_t paletteCount = texelElimData.size();
+
+            std::vector <clusterSum> sums( paletteCount );
+
+            {
+                closestLinkFinder linkFinder( texelElimData, false );
+
+                for ( size_t n = 0; n < histogramCount; n++ )
+                {
+                    const histogramEntry& entry = this->histogram[ n ];
+
+                    uint32 paletteIndex = linkFinder.find( entry.comp[0], entry.comp[1], entry.comp[2], entry.comp[3] );
+
+                    clusterSum& sum = sums[ paletteIndex ];
+
+                    for ( uint32 c = 0; c < 4; c++ )
+                    {
+                        sum.comp[ c ] += (uint64)entry.comp[ c ] * entry.count;
+                    }
+
+                    sum.count += entry.count;
+                }
+            }
+
+            bool hasChanged = false;
+
+            for ( size_t n = 0; n < paletteCount; n++ )
+            {
+                const clusterSum& sum = sums[ n ];
+
+                // Colors that lost all their texels keep their place.
+                if ( sum.count == 0 )
+                    continue;
+
+                texel_t newColor;
+                newColor.red = sum.getmean( 0 );
+                newColor.green = sum.getmean( 1 );
+                newColor.blue = sum.getmean( 2 );
+                newColor.alpha = sum.getmean( 3 );
+                newColor.usageCount = (uint32)std::min( sum.count, (uint64)0xFFFFFFFF );
+
+                texel_t& palColor = texelElimData[ n ];
+
+                if ( newColor.red != palColor.red || newColor.green != palColor.green ||
+                     newColor.blue != palColor.blue || newColor.alpha != palColor.alpha )
+                {
+                    hasChanged = true;
+                }
+
+                palColor = newColor;
+            }
+
+            if ( !hasChanged )
+                break;
+        }
+    }
+
+    inline void* makepalette(Interface *engineInterface, eRasterFormat rasterFormat, eColorOrdering colorOrder)
+    {
+        return palettizer::makepalette(engineInterface, texelElimData, rasterFormat, colorOrder);
+    }
+
+    // Finds the palette entry with the smallest squared RGBA distance.
+    // The palette is sorted along its widest axis so the search can stop early, and
+    // results are cached by packed RGBA. Equally close entries resolve to the lower index.
+    struct closestLinkFinder
+    {
+        inline closestLinkFinder( const texelContainer_t& paletteColors, bool useCache = true )
+        {
+            size_t paletteCount = paletteColors.size();
+
+            std::vector <paletteEntry> entries( paletteCount );
+
+            uint32 minCoords[4] = { 255, 255, 255, 255 };
+            uint32 maxCoords[4] = { 0, 0, 0, 0 };
+
+            for ( size_t n = 0; n < paletteCount; n++ )
+            {
+                const texel_t& palColor = paletteColors[ n ];
+
+                paletteEntry& entry = entries[ n ];
+
+                entry.comp[0] = palColor.red;
+                entry.comp[1] = palColor.green;
+                entry.comp[2] = palColor.blue;
+                entry.comp[3] = palColor.alpha;
+                entry.index = (uint32)n;
+
+                for ( uint32 c = 0; c < 4; c++ )
+                {
+                    minCoords[ c ] = std::min( minCoords[ c ], (uint32)entry.comp[ c ] );
+                    maxCoords[ c ] = std::max( maxCoords[ c ], (uint32)entry.comp[ c ] );
+                }
+            }
+
+            uint32 sortAxis = 0;
+
+            for ( uint32 c = 1; c < 4; c++ )
+            {
+                if ( maxCoords[ c ] - minCoords[ c ] > maxCoords[ sortAxis ] - minCoords[ sortAxis ] )
+                {
+                    sortAxis = c;
+                }
+            }
+
+            for ( paletteEntry& entry : entries )
+            {
+                entry.sortCoord = entry.comp[ sortAxis ];
+            }
+
+            std::stable_sort( entries.begin(), entries.end(), isEntryBelow );
+
+            this->sortAxis = sortAxis;
+            this->sortedEntries = std::move( entries );
+
+            if ( useCache )
+            {
+                cacheEntry emptyEntry;
+                emptyEntry.packedColor = 0;
+                emptyEntry.paletteIndex = INVALID_INDEX;
+
+                this->resultCache.resize( CACHE_SIZE, emptyEntry );
+            }
+        }
+
+        inline uint32 find( uint8 red, uint8 green, uint8 blue, uint8 alpha )
+        {
+            uint32 packedColor = packcolor( red, green, blue, alpha );
+
+            cacheEntry *cached = NULL;
+
+            if ( this->resultCache.empty() == false )
+            {
+                cached = &this->resultCache[ ( packedColor * 2654435761u ) >> ( 32 - CACHE_BITS ) ];
+
+                if ( cached->paletteIndex != INVALID_INDEX && cached->packedColor == packedColor )
+                {
+                    return cached->paletteIndex;
+                }
+            }
+
+            int32 texelComp[4] = { red, green, blue, alpha };
+
+            int32 texelCoord = texelComp[ this->sortAxis ];
+
+            const paletteEntry *entries = this->sortedEntries.data();
+            size_t entryCount = this->sortedEntries.size();
+
+            // Start at the first entry that is not below the texel on the sort axis and walk outwards.
+            size_t upper = 0;
+
+            while ( upper < entryCount && entries[ upper ].sortCoord < texelCoord )
+            {
+                upper++;
+            }
+
+            size_t lower = upper;
+
+            uint32 closestIndex = INVALID_INDEX;
+            int32 closest = 0;
+
+            bool canGoUp = ( upper < entryCount );
+            bool canGoDown = ( lower > 0 );
+
+            while ( canGoUp || canGoDown )
+            {
+                if ( canGoUp )
+                {
+                    const paletteEntry& entry = entries[ upper ];
+
+                    int32 axisDist = ( entry.sortCoord - texelCoord );
+
+                    if ( closestIndex != INVALID_INDEX && axisDist * axisDist > closest )
+                    {
+                        canGoUp = false;
+                    }
+                    else
+                    {
+                        checkEntry( entry, texelComp, closestIndex, closest );
+
+                        upper++;
+
+                        canGoUp = ( upper < entryCount );
+                    }
+                }
+
+                if ( canGoDown )
+                {
+                    const paletteEntry& entry = entries[ lower - 1 ];
+
+                    int32 axisDist = ( texelCoord - entry.sortCoord );
+
+                    if ( closestIndex != INVALID_INDEX && axisDist * axisDist > closest )
+                    {
+                        canGoDown = false;
+                    }
+                    else
+                    {
+                        checkEntry( entry, texelComp, closestIndex, closest );
+
+                        lower--;
+
+                        canGoDown = ( lower > 0 );
+                    }
+                }
+            }
+
+            assert( closestIndex != INVALID_INDEX );
+
+            if ( cached )
+            {
+                cached->packedColor = packedColor;
+                cached->paletteIndex = closestIndex;
+            }
+
+            return closestIndex;
+        }
+
+    private:
+        static const uint32 INVALID_INDEX = 0xFFFFFFFF;
+
+        static const uint32 CACHE_BITS = 12;
+        static const uint32 CACHE_SIZE = ( 1 << CACHE_BITS );
+
+        struct paletteEntry
+        {
+            uint8 comp[4];
+            int32 sortCoord;
+            uint32 index;
+        };
+
+        struct cacheEntry
+        {
+            uint32 packedColor;
+            uint32 paletteIndex;
+        };
+
+        static inline bool isEntryBelow( const paletteEntry& left, const paletteEntry& right )
+        {
+            return ( left.sortCoord < right.sortCoord );
+        }
+
+        static inline void checkEntry( const paletteEntry& entry, const int32 texelComp[4], uint32& closestIndex, int32& closest )
+        {
+            int32 distance = 0;
+
+            for ( uint32 c = 0; c < 4; c++ )
+            {
+                int32 compDiff = ( texelComp[ c ] - entry.comp[ c ] );
+
+                distance += compDiff * compDiff;
+            }
+
+            if ( closestIndex == INVALID_INDEX || distance < closest || ( distance == closest && entry.index < closestIndex ) )
+            {
+                closestIndex = entry.index;
+                closest = distance;
+            }
+        }
+
+        uint32 sortAxis;
+        std::vector <paletteEntry> sortedEntries;
+
+        std::vector <cacheEntry> resultCache;
+    };
+
+private:
+    static const size_t maxbufferedsamples = ( 1 << 20 );
+
+    struct histogramEntry
+    {
+        uint32 packedColor;
+        uint8 comp[4];
+        uint32 count;
+    };
+
+    struct colorBox
+    {
+        uint32 begin, end;
+        uint64 count;
+        double sum[4];
+        double error;
+        uint32 splitAxis;
+
+        inline void getmeancolor( texel_t& colorOut ) const
+        {
+            colorOut.red = getmean( 0 );
+            colorOut.green = getmean( 1 );
+            colorOut.blue = getmean( 2 );
+            colorOut.alpha = getmean( 3 );
+        }
+
+        inline uint8 getmean( uint32 c ) const
+        {
+            return (uint8)std::min( 255.0, floor( sum[ c ] / (double)count + 0.5 ) );
+        }
+    };
+
+    struct clusterSum
+    {
+        inline clusterSum( void )
+        {
+            comp[0] = 0;
+            comp[1] = 0;
+            comp[2] = 0;
+            comp[3] = 0;
+            count = 0;
+        }
+
+        uint64 comp[4];
+        uint64 count;
+
+        inline uint8 getmean( uint32 c ) const
+        {
+            return (uint8)( ( comp[ c ] + count / 2 ) / count );
+        }
+    };
+
+    struct isComponentBelow
+    {
+        uint32 component;
+
+        inline bool operator () ( const histogramEntry& left, const histogramEntry& right ) const
+        {
+            uint8 leftComp = left.comp[ component ];
+            uint8 rightComp = right.comp[ component ];
+
+            if ( leftComp != rightComp )
+            {
+                return ( leftComp < rightComp );
+            }
+
+            // Keep the order stable between compilers.
+            return ( left.packedColor < right.packedColor );
+        }
+    };
+
+    static inline uint32 packcolor( uint8 red, uint8 green, uint8 blue, uint8 alpha )
+    {
+        return ( (uint32)red | ( (uint32)green << 8 ) | ( (uint32)blue << 16 ) | ( (uint32)alpha << 24 ) );
+    }
+
+    static inline bool isHistogramEntryBelow( const histogramEntry& left, const histogramEntry& right )
+    {
+        return ( left.packedColor < right.packedColor );
+    }
+
+    // Moves the buffered samples into the histogram, which is kept sorted by packed color.
+    inline void flushsamples( void )
+    {
+        if ( this->colorSamples.empty() )
+            return;
+
+        std::sort( this->colorSamples.begin(), this->colorSamples.end() );
+
+        std::vector <histogramEntry> newEntries;
+
+        size_t sampleCount = this->colorSamples.size();
+
+        for ( size_t n = 0; n < sampleCount; )
+        {
+            uint32 packedColor = this->colorSamples[ n ];
+
+            size_t runEnd = n + 1;
+
+            while ( runEnd < sampleCount && this->colorSamples[ runEnd ] == packedColor )
+            {
+                runEnd++;
+            }
+
+            histogramEntry entry;
+            entry.packedColor = packedColor;
+            entry.comp[0] = (uint8)( packedColor );
+            entry.comp[1] = (uint8)( packedColor >> 8 );
+            entry.comp[2] = (uint8)( packedColor >> 16 );
+            entry.comp[3] = (uint8)( packedColor >> 24 );
+            entry.count = (uint32)( runEnd - n );
+
+            newEntries.push_back( entry );
+
+            n = runEnd;
+        }
+
+        this->colorSamples.clear();
+
+        if ( this->histogram.empty() )
+        {
+            this->histogram = std::move( newEntries );
+            return;
+        }
+
+        // Merge both sorted lists and add up the counts of the colors that are in both.
+        std::vector <histogramEntry> mergedEntries;
+        mergedEntries.reserve( this->histogram.size() + newEntries.size() );
+
+        std::merge(
+            this->histogram.begin(), this->histogram.end(),
+            newEntries.begin(), newEntries.end(),
+            std::back_inserter( mergedEntries ),
+            isHistogramEntryBelow
+        );
+
+        size_t uniqueCount = 0;
+
+        for ( size_t n = 0; n < mergedEntries.size(); n++ )
+        {
+            if ( uniqueCount != 0 && mergedEntries[ uniqueCount - 1 ].packedColor == mergedEntries[ n ].packedColor )
+            {
+                mergedEntries[ uniqueCount - 1 ].count += mergedEntries[ n ].count;
+            }
+            else
+            {
+                mergedEntries[ uniqueCount++ ] = mergedEntries[ n ];
+            }
+        }
+
+        mergedEntries.resize( uniqueCount );
+
+        this->histogram = std::move( mergedEntries );
+    }
+
+    inline void calculateboxstats( colorBox& box ) const
+    {
+        uint64 count = 0;
+        double sum[4] = { 0, 0, 0, 0 };
+        double sqSum[4] = { 0, 0, 0, 0 };
+
+        for ( uint32 n = box.begin; n < box.end; n++ )
+        {
+            const histogramEntry& entry = this->histogram[ n ];
+
+            double weight = (double)entry.count;
+
+            for ( uint32 c = 0; c < 4; c++ )
+            {
+                double comp = (double)entry.comp[ c ];
+
+                sum[ c ] += comp * weight;
+                sqSum[ c ] += comp * comp * weight;
+            }
+
+            count += entry.count;
+        }
+
+        box.count = count;
+        box.error = 0;
+        box.splitAxis = 0;
+
+        double biggestAxisError = -1;
+
+        for ( uint32 c = 0; c < 4; c++ )
+        {
+            box.sum[ c ] = sum[ c ];
+
+            // Sum of squared distances to the mean along this axis.
+            double axisError = std::max( 0.0, sqSum[ c ] - ( sum[ c ] * sum[ c ] ) / (double)count );
+
+            box.error += axisError;
+
+            if ( axisError > biggestAxisError )
+            {
+                biggestAxisError = axisError;
+                box.splitAxis = c;
+            }
+        }
+    }
+
+    std::vector <uint32> colorSamples;
+    std::vector <histogramEntry> histogram;
 };
 
 // Mipmap remapping algorithm.
@@ -8,6 +8,8 @@
 
 #include "txdread.palette.hxx"
 
+#include "rwparallel.hxx"
+
 namespace rw
 {
 
@@ -28,6 +30,23 @@ inline bool decompressTexelsUsingDXT(
 
 	void *newtexels = engineInterface->PixelAllocate( dataSize );
 
+    // Try to decode whole block rows straight into the destination first.
+    bool hasFastDecompressed =
+        decompressDXTLayerFast(
+            dxtMethod, dxtType,
+            srcTexels, texWidth, texHeight,
+            newtexels, rowSize, texLayerWidth, texLayerHeight,
+            rawRasterFormat, rawDepth, rawColorOrder
+        );
+
+    if ( hasFastDecompressed )
+    {
+        dstTexelsOut = newtexels;
+        dstTexelsDataSizeOut = dataSize;
+
+        return true;
+    }
+
     // Get the compressed block count.
     uint32 compressedBlockCount = ( texWidth * texHeight ) / 16;
 
@@ -102,6 +121,113 @@ inline bool decompressTexelsUsingDXT(
     return successfullyDecompressed;
 }
 
+// Decodes bands of block rows of all layers on the worker pool.
+struct parallelDXTLayerDecompressor
+{
+    eDXTCompressionMethod dxtMethod;
+    uint32 dxtType;
+
+    eRasterFormat dstRasterFormat;
+    uint32 dstDepth;
+    eColorOrdering dstColorOrder;
+
+    const pixelDataTraversal *pixelData;
+
+    const void* const *dstLayerTexels;
+    const uint32 *dstLayerRowSizes;
+
+    const parallelTexelBand *bands;
+
+    void operator () ( size_t taskIndex ) const
+    {
+        const parallelTexelBand& band = this->bands[ taskIndex ];
+
+        const pixelDataTraversal::mipmapResource& mipLayer = this->pixelData->mipmaps[ band.mipIndex ];
+
+        decompressDXTLayerRowsFast(
+            this->dxtMethod, this->dxtType,
+            mipLayer.texels, mipLayer.width, mipLayer.height,
+            (void*)this->dstLayerTexels[ band.mipIndex ], this->dstLayerRowSizes[ band.mipIndex ],
+            mipLayer.mipWidth, mipLayer.mipHeight,
+            this->dstRasterFormat, this->dstDepth, this->dstColorOrder,
+            band.firstRow / 4, band.endRow / 4
+        );
+    }
+};
+
+static void decompressDXTLayersParallel(
+    Interface *engineInterface, pixelDataTraversal& pixelData, uint32 dxtType, eDXTCompressionMethod dxtMethod,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder
+)
+{
+    size_t mipmapCount = pixelData.mipmaps.size();
+
+    std::vector <void*> dstLayerTexels( mipmapCount, NULL );
+    std::vector <uint32> dstLayerRowSizes( mipmapCount );
+    std::vector <uint32> dstLayerDataSizes( mipmapCount );
+
+    std::vector <parallelTexelBand> bands;
+
+    try
+    {
+        for ( size_t n = 0; n < mipmapCount; n++ )
+        {
+            const pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+
+            uint32 rowSize = getRasterDataRowSize( mipLayer.mipWidth, dstDepth, dstRowAlignment );
+
+            uint32 dataSize = getRasterDataSizeByRowSize( rowSize, mipLayer.height );
+
+            dstLayerTexels[ n ] = engineInterface->PixelAllocate( dataSize );
+            dstLayerRowSizes[ n ] = rowSize;
+            dstLayerDataSizes[ n ] = dataSize;
+
+            // Bands have to start at block rows.
+            SplitLayerIntoBands( engineInterface, n, mipLayer.width, ALIGN_SIZE( mipLayer.height, 4u ), 4, bands );
+        }
+
+        parallelDXTLayerDecompressor decompressor;
+        decompressor.dxtMethod = dxtMethod;
+        decompressor.dxtType = dxtType;
+        decompressor.dstRasterFormat = dstRasterFormat;
+        decompressor.dstDepth = dstDepth;
+        decompressor.dstColorOrder = dstColorOrder;
+        decompressor.pixelData = &pixelData;
+        decompressor.dstLayerTexels = dstLayerTexels.data();
+        decompressor.dstLayerRowSizes = dstLayerRowSizes.data();
+        decompressor.bands = bands.data();
+
+        ParallelForEach( engineInterface, bands.size(), decompressor );
+    }
+    catch( ... )
+    {
+        for ( void *texels : dstLayerTexels )
+        {
+            if ( texels )
+            {
+                engineInterface->PixelFree( texels );
+            }
+        }
+
+        throw;
+    }
+
+    // Replace the texel data.
+    for ( size_t n = 0; n < mipmapCount; n++ )
+    {
+        pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+
+        engineInterface->PixelFree( mipLayer.texels );
+
+        mipLayer.texels = dstLayerTexels[ n ];
+        mipLayer.dataSize = dstLayerDataSizes[ n ];
+
+        // Normalize the dimensions.
+        mipLayer.width = mipLayer.mipWidth;
+        mipLayer.height = mipLayer.mipHeight;
+    }
+}
+
 bool genericDecompressDXTNative(
     Interface *engineInterface, pixelDataTraversal& pixelData, uint32 dxtType,
     eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder
@@ -118,53 +244,69 @@ bool genericDecompressDXTNative(
 
     size_t mipmapCount = pixelData.mipmaps.size();
 
-	for (size_t i = 0; i < mipmapCount; i++)
+    // Big textures are decoded by all workers at once.
+    // This only works with the fast path, because it never fails halfway.
+    bool decompressInParallel =
+        ( canDecompressDXTLayerFast( dxtType, dstRasterFormat, dstDepth, dstColorOrder ) &&
+          ShouldProcessTexelsInParallel( engineInterface, GetMipmapLayersTexelCount( pixelData.mipmaps ) ) );
+
+    if ( decompressInParallel )
+    {
+        decompressDXTLayersParallel(
+            engineInterface, pixelData, dxtType, dxtMethod,
+            dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder
+        );
+    }
+    else
     {
-        pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ i ];
+        for (size_t i = 0; i < mipmapCount; i++)
+        {
+            pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ i ];
 
-        void *texelData = mipLayer.texels;
+            void *texelData = mipLayer.texels;
 
-		uint32 x = 0, y = 0;
+            uint32 x = 0, y = 0;
 
-        // Allocate the new texel array.
-        uint32 texLayerWidth = mipLayer.mipWidth;
-        uint32 texLayerHeight = mipLayer.mipHeight;
+            // Allocate the new texel array.
+            uint32 texLayerWidth = mipLayer.mipWidth;
+            uint32 texLayerHeight = mipLayer.mipHeight;
 
-		void *newtexels;
-		uint32 dataSize;
+            void *newtexels;
+            uint32 dataSize;
 
-        // Get the compressed block count.
-        uint32 texWidth = mipLayer.width;
-        uint32 texHeight = mipLayer.height;
+            // Get the compressed block count.
+            uint32 texWidth = mipLayer.width;
+            uint32 texHeight = mipLayer.height;
 
-        bool successfullyDecompressed =
-            decompressTexelsUsingDXT(
-                engineInterface, dxtType, dxtMethod,
-                texWidth, texHeight, dstRowAlignment,
-                texLayerWidth, texLayerHeight,
-                texelData, dstRasterFormat, dstColorOrder, dstDepth,
-                newtexels, dataSize
-            );
+            bool successfullyDecompressed =
+                decompressTexelsUsingDXT(
+                    engineInterface, dxtType, dxtMethod,
+                    texWidth, texHeight, dstRowAlignment,
+                    texLayerWidth, texLayerHeight,
+                    texelData, dstRasterFormat, dstColorOrder, dstDepth,
+                    newtexels, dataSize
+                );
 
-        // If even one mipmap fails to decompress, abort.
-        if ( !successfullyDecompressed )
-        {
-            assert( i == 0 );
+            // If even one mipmap fails to decompress, abort.
+            if ( !successfullyDecompressed )
+            {
+                assert( i == 0 );
 
-            conversionSuccessful = false;
-            break;
-        }
+                conversionSuccessful = false;
+                break;
+            }
 
-        // Replace the texel data.
-		engineInterface->PixelFree( texelData );
+            // Replace the texel data.
+            engineInterface->PixelFree( texelData );
 
-		mipLayer.texels = newtexels;
-		mipLayer.dataSize = dataSize;
+            mipLayer.texels = newtexels;
+            mipLayer.dataSize = dataSize;
 
-        // Normalize the dimensions.
-        mipLayer.width = texLayerWidth;
-        mipLayer.height = texLayerHeight;
-	}
+            // Normalize the dimensions.
+            mipLayer.width = texLayerWidth;
+            mipLayer.height = texLayerHeight;
+        }
+    }
 
     if (conversionSuccessful)
     {
@@ -209,47 +351,69 @@ void genericCompressDXTNative( Interface *engineInterface, pixelDataTraversal& p
     uint32 maxpalette = pixelData.paletteSize;
     void *paletteData = pixelData.paletteData;
 
-    for ( size_t n = 0; n < mipmapCount; n++ )
-    {
-        pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+    // Allocate the DXT arrays of all layers first.
+    // This way we can compress all of them in one go, which scales better across threads.
+    std::vector <dxtCompressionLayer> dxtLayers( mipmapCount );
 
-        uint32 mipWidth = mipLayer.width;
-        uint32 mipHeight = mipLayer.height;
+    try
+    {
+        for ( size_t n = 0; n < mipmapCount; n++ )
+        {
+            const pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
 
-        void *texelSource = mipLayer.texels;
+            dxtCompressionLayer& layer = dxtLayers[ n ];
+            layer.texelSource = mipLayer.texels;
+            layer.mipWidth = mipLayer.width;
+            layer.mipHeight = mipLayer.height;
+            layer.dxtArray = NULL;
 
-        void *dxtArray = NULL;
-        uint32 dxtDataSize = 0;
+            // Make sure the texture dimensions are aligned by 4.
+            uint32 alignedMipWidth = ALIGN_SIZE( mipLayer.width, 4u );
+            uint32 alignedMipHeight = ALIGN_SIZE( mipLayer.height, 4u );
 
-        // Create the new DXT array.
-        uint32 realMipWidth, realMipHeight;
+            layer.dxtArray = engineInterface->PixelAllocate( getDXTRasterDataSize( dxtType, alignedMipWidth * alignedMipHeight ) );
+        }
 
-        compressTexelsUsingDXT(
+        compressDXTLayers(
             engineInterface,
-            dxtType, texelSource, mipWidth, mipHeight, rowAlignment,
+            dxtType, rowAlignment,
             rasterFormat, paletteData, paletteType, maxpalette, colorOrder, itemDepth,
-            dxtArray, dxtDataSize,
-            realMipWidth, realMipHeight
+            dxtLayers.data(), mipmapCount
         );
-
-        // Delete the raw texels.
-        engineInterface->PixelFree( texelSource );
-
-        if ( mipWidth != realMipWidth )
+    }
+    catch( ... )
+    {
+        for ( dxtCompressionLayer& layer : dxtLayers )
         {
-            mipLayer.width = realMipWidth;
+            if ( void *dxtArray = layer.dxtArray )
+            {
+                engineInterface->PixelFree( dxtArray );
+            }
         }
 
-        if ( mipHeight != realMipHeight )
-        {
-            mipLayer.height = realMipHeight;
-        }
+        throw;
+    }
+
+    for ( size_t n = 0; n < mipmapCount; n++ )
+    {
+        pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+
+        const dxtCompressionLayer& layer = dxtLayers[ n ];
+
+        uint32 realMipWidth = ALIGN_SIZE( mipLayer.width, 4u );
+        uint32 realMipHeight = ALIGN_SIZE( mipLayer.height, 4u );
+
+        // Delete the raw texels.
+        engineInterface->PixelFree( mipLayer.texels );
+
+        mipLayer.width = realMipWidth;
+        mipLayer.height = realMipHeight;
 
         // Put in the new DXTn texels.
-        mipLayer.texels = dxtArray;
+        mipLayer.texels = layer.dxtArray;
 
         // Update fields.
-        mipLayer.dataSize = dxtDataSize;
+        mipLayer.dataSize = getDXTRasterDataSize( dxtType, realMipWidth * realMipHeight );
     }
 
     // We are finished compressing.
@@ -403,58 +567,21 @@ void ConvertPaletteDepth(
     );
 }
 
-template <typename srcColorDispatcher, typename dstColorDispatcher>
-inline void copyTexelData(
-    const void *srcTexels, void *dstTexels,
-    srcColorDispatcher& fetchDispatch, dstColorDispatcher& putDispatch,
-    uint32 mipWidth, uint32 mipHeight,
-    uint32 srcDepth, uint32 dstDepth,
-    uint32 srcRowAlignment, uint32 dstRowAlignment
-)
-{
-    uint32 srcRowSize = getRasterDataRowSize( mipWidth, srcDepth, srcRowAlignment );
-    uint32 dstRowSize = getRasterDataRowSize( mipWidth, dstDepth, dstRowAlignment );
-
-    copyTexelDataEx(
-        srcTexels, dstTexels,
-        fetchDispatch, putDispatch,
-        mipWidth, mipHeight,
-        0, 0,
-        0, 0,
-        srcRowSize, dstRowSize
-    );
-}
-
-void ConvertMipmapLayer(
-    Interface *engineInterface,
-    const pixelDataTraversal::mipmapResource& mipLayer,
+// Converts the rows [firstRow, endRow) of a mipmap layer into an already allocated destination.
+// Conversion happens row by row, so disjoint row ranges can be converted at the same time, even in-place.
+static void ConvertMipmapLayerRows(
+    const pixelDataTraversal::mipmapResource& mipLayer, void *dstTexels,
     eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
     eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder, ePaletteType dstPaletteType,
-    bool forceAllocation,
-    void*& dstTexelsOut, uint32& dstDataSizeOut
+    uint32 firstRow, uint32 endRow
 )
 {
-    // Grab the source parameters.
-    void *srcTexels = mipLayer.texels;
-
-    uint32 srcTexelsDataSize = mipLayer.dataSize;
+    const void *srcTexels = mipLayer.texels;
 
     uint32 srcWidth = mipLayer.width;               // the dimensions will stay the same.
     uint32 srcHeight = mipLayer.height;
 
-    // Check whether we need to reallocate the texels.
-    void *dstTexels = srcTexels;
-
-    uint32 dstTexelsDataSize = srcTexelsDataSize;
-
-    if ( forceAllocation || shouldAllocateNewRasterBuffer( srcWidth, srcDepth, srcRowAlignment, dstDepth, dstRowAlignment ) )
-    {
-        uint32 rowSize = getRasterDataRowSize( srcWidth, dstDepth, dstRowAlignment );
-
-        dstTexelsDataSize = getRasterDataSizeByRowSize( rowSize, srcHeight );
-
-        dstTexels = engineInterface->PixelAllocate( dstTexelsDataSize );
-    }
+    uint32 processHeight = ( endRow - firstRow );
 
     if ( dstPaletteType != PALETTE_NONE )
     {
@@ -464,9 +591,12 @@ void ConvertMipmapLayer(
         // We only have work to do if the depth changed or the pointers to the arrays changed.
         if ( srcDepth != dstDepth || srcTexels != dstTexels || srcPaletteType != dstPaletteType )
         {
-            ConvertPaletteDepth(
+            ConvertPaletteDepthEx(
                 srcTexels, dstTexels,
+                0, firstRow,
+                0, firstRow,
                 srcWidth, srcHeight,
+                srcWidth, processHeight,
                 srcPaletteType, dstPaletteType, srcPaletteSize,
                 srcDepth, dstDepth,
                 srcRowAlignment, dstRowAlignment
@@ -478,20 +608,189 @@ void ConvertMipmapLayer(
         colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
         colorModelDispatcher <void> putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
 
-        copyTexelData(
+        uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, srcRowAlignment );
+        uint32 dstRowSize = getRasterDataRowSize( srcWidth, dstDepth, dstRowAlignment );
+
+        copyTexelDataEx(
             srcTexels, dstTexels,
             fetchDispatch, putDispatch,
-            srcWidth, srcHeight,
-            srcDepth, dstDepth,
-            srcRowAlignment, dstRowAlignment
+            srcWidth, processHeight,
+            0, firstRow,
+            0, firstRow,
+            srcRowSize, dstRowSize
         );
     }
+}
+
+// Returns the texel buffer that a mipmap layer is converted into; allocates one if required.
+static void* AllocateMipmapLayerDestination(
+    Interface *engineInterface,
+    const pixelDataTraversal::mipmapResource& mipLayer,
+    uint32 srcDepth, uint32 srcRowAlignment,
+    uint32 dstDepth, uint32 dstRowAlignment,
+    bool forceAllocation,
+    uint32& dstDataSizeOut
+)
+{
+    uint32 srcWidth = mipLayer.width;
+    uint32 srcHeight = mipLayer.height;
+
+    if ( forceAllocation || shouldAllocateNewRasterBuffer( srcWidth, srcDepth, srcRowAlignment, dstDepth, dstRowAlignment ) )
+    {
+        uint32 rowSize = getRasterDataRowSize( srcWidth, dstDepth, dstRowAlignment );
+
+        dstDataSizeOut = getRasterDataSizeByRowSize( rowSize, srcHeight );
+
+        return engineInterface->PixelAllocate( dstDataSizeOut );
+    }
+
+    // We can convert in-place.
+    dstDataSizeOut = mipLayer.dataSize;
+
+    return mipLayer.texels;
+}
+
+void ConvertMipmapLayer(
+    Interface *engineInterface,
+    const pixelDataTraversal::mipmapResource& mipLayer,
+    eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder, ePaletteType dstPaletteType,
+    bool forceAllocation,
+    void*& dstTexelsOut, uint32& dstDataSizeOut
+)
+{
+    // Check whether we need to reallocate the texels.
+    uint32 dstTexelsDataSize;
+
+    void *dstTexels =
+        AllocateMipmapLayerDestination(
+            engineInterface, mipLayer,
+            srcDepth, srcRowAlignment,
+            dstDepth, dstRowAlignment,
+            forceAllocation,
+            dstTexelsDataSize
+        );
+
+    ConvertMipmapLayerRows(
+        mipLayer, dstTexels,
+        srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteData, srcPaletteSize,
+        dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder, dstPaletteType,
+        0, mipLayer.height
+    );
     
     // Give data to the runtime.
     dstTexelsOut = dstTexels;
     dstDataSizeOut = dstTexelsDataSize;
 }
 
+// Converts bands of rows of all layers of a texture on the worker pool.
+struct parallelMipmapLayerConverter
+{
+    const pixelDataTraversal *pixelData;
+
+    eRasterFormat srcRasterFormat;
+    uint32 srcDepth;
+    uint32 srcRowAlignment;
+    eColorOrdering srcColorOrder;
+    ePaletteType srcPaletteType;
+    const void *srcPaletteData;
+    uint32 srcPaletteSize;
+
+    eRasterFormat dstRasterFormat;
+    uint32 dstDepth;
+    uint32 dstRowAlignment;
+    eColorOrdering dstColorOrder;
+    ePaletteType dstPaletteType;
+
+    void* const *dstLayerTexels;
+
+    const parallelTexelBand *bands;
+
+    void operator () ( size_t taskIndex ) const
+    {
+        const parallelTexelBand& band = this->bands[ taskIndex ];
+
+        ConvertMipmapLayerRows(
+            this->pixelData->mipmaps[ band.mipIndex ], this->dstLayerTexels[ band.mipIndex ],
+            this->srcRasterFormat, this->srcDepth, this->srcRowAlignment, this->srcColorOrder, this->srcPaletteType, this->srcPaletteData, this->srcPaletteSize,
+            this->dstRasterFormat, this->dstDepth, this->dstRowAlignment, this->dstColorOrder, this->dstPaletteType,
+            band.firstRow, band.endRow
+        );
+    }
+};
+
+// Parallel version of calling ConvertMipmapLayer on every layer.
+static void ConvertMipmapLayersParallel(
+    Interface *engineInterface,
+    const pixelDataTraversal& pixelData,
+    eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder, ePaletteType dstPaletteType,
+    std::vector <void*>& dstLayerTexelsOut, std::vector <uint32>& dstLayerDataSizesOut
+)
+{
+    size_t mipmapCount = pixelData.mipmaps.size();
+
+    std::vector <void*> dstLayerTexels( mipmapCount, NULL );
+    std::vector <uint32> dstLayerDataSizes( mipmapCount );
+
+    std::vector <parallelTexelBand> bands;
+
+    try
+    {
+        for ( size_t n = 0; n < mipmapCount; n++ )
+        {
+            const pixelDataTraversal::mipmapResource& mipLayer = pixelData.mipmaps[ n ];
+
+            dstLayerTexels[ n ] =
+                AllocateMipmapLayerDestination(
+                    engineInterface, mipLayer,
+                    srcDepth, srcRowAlignment,
+                    dstDepth, dstRowAlignment,
+                    false,
+                    dstLayerDataSizes[ n ]
+                );
+
+            SplitLayerIntoBands( engineInterface, n, mipLayer.width, mipLayer.height, 1, bands );
+        }
+
+        parallelMipmapLayerConverter converter;
+        converter.pixelData = &pixelData;
+        converter.srcRasterFormat = srcRasterFormat;
+        converter.srcDepth = srcDepth;
+        converter.srcRowAlignment = srcRowAlignment;
+        converter.srcColorOrder = srcColorOrder;
+        converter.srcPaletteType = srcPaletteType;
+        converter.srcPaletteData = srcPaletteData;
+        converter.srcPaletteSize = srcPaletteSize;
+        converter.dstRasterFormat = dstRasterFormat;
+        converter.dstDepth = dstDepth;
+        converter.dstRowAlignment = dstRowAlignment;
+        converter.dstColorOrder = dstColorOrder;
+        converter.dstPaletteType = dstPaletteType;
+        converter.dstLayerTexels = dstLayerTexels.data();
+        converter.bands = bands.data();
+
+        ParallelForEach( engineInterface, bands.size(), converter );
+    }
+    catch( ... )
+    {
+        for ( size_t n = 0; n < mipmapCount; n++ )
+        {
+            void *texels = dstLayerTexels[ n ];
+
+            if ( texels && texels != pixelData.mipmaps[ n ].texels )
+            {
+                engineInterface->PixelFree( texels );
+            }
+        }
+
+        throw;
+    }
+
+    dstLayerTexelsOut = std::move( dstLayerTexels );
+    dstLayerDataSizesOut = std::move( dstLayerDataSizes );
+}
+
 bool ConvertMipmapLayerNative(
     Interface *engineInterface,
     uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, void *srcTexels, uint32 srcDataSize,
@@ -1046,6 +1345,23 @@ bool ConvertPixelData( Interface *engineInterface, pixelDataTraversal& pixelsToC
                 // Process mipmaps.
                 size_t mipmapCount = pixelsToConvert.mipmaps.size();
 
+                // Big textures are converted by all workers at once.
+                bool convertInParallel = ShouldProcessTexelsInParallel( engineInterface, GetMipmapLayersTexelCount( pixelsToConvert.mipmaps ) );
+
+                std::vector <void*> dstLayerTexels;
+                std::vector <uint32> dstLayerDataSizes;
+
+                if ( convertInParallel )
+                {
+                    ConvertMipmapLayersParallel(
+                        engineInterface,
+                        pixelsToConvert,
+                        srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteTexels, srcPaletteSize,
+                        dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder, dstPaletteType,
+                        dstLayerTexels, dstLayerDataSizes
+                    );
+                }
+
                 // Determine the depth of the items.
                 for ( size_t n = 0; n < mipmapCount; n++ )
                 {
@@ -1054,15 +1370,23 @@ bool ConvertPixelData( Interface *engineInterface, pixelDataTraversal& pixelsToC
                     void *dstTexels;
                     uint32 dstTexelsDataSize;
 
-                    // Convert this mipmap.
-                    ConvertMipmapLayer(
-                        engineInterface,
-                        mipLayer,
-                        srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteTexels, srcPaletteSize,
-                        dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder, dstPaletteType,
-                        false,
-                        dstTexels, dstTexelsDataSize
-                    );
+                    if ( convertInParallel )
+                    {
+                        dstTexels = dstLayerTexels[ n ];
+                        dstTexelsDataSize = dstLayerDataSizes[ n ];
+                    }
+                    else
+                    {
+                        // Convert this mipmap.
+                        ConvertMipmapLayer(
+                            engineInterface,
+                            mipLayer,
+                            srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteTexels, srcPaletteSize,
+                            dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder, dstPaletteType,
+                            false,
+                            dstTexels, dstTexelsDataSize
+                        );
+                    }
 
                     // Update mipmap properties.
                     void *srcTexels = mipLayer.texels;
@@ -0,0 +1,790 @@
+#include "StdInc.h"
+
+#include "pixelformat.hxx"
+
+#include "rwsimd.hxx"
+
+#include <utility>
+
+// Specialized row converters between raw RGBA raster formats.
+// colorModelDispatcher has to decide the raster format, depth and color order for
+// every single texel, which is very slow if we convert big images. Here we generate
+// a converter for each format pair at compile-time instead, so the decision is made
+// once per mipmap layer.
+// Every kernel must produce the exact same texels as the colorModelDispatcher path.
+
+namespace rw
+{
+
+// PS2 alpha remapping tables (see convertPCAlpha2PS2Alpha and convertPS2Alpha2PCAlpha).
+const uint8 ps2AlphaFromPCAlphaTable[256] =
+{
+    0x00, 0x01, 0x01, 0x02, 0x02, 0x03, 0x03, 0x04, 0x04, 0x05, 0x05, 0x06, 0x06, 0x07, 0x07, 0x08,
+    0x08, 0x09, 0x09, 0x0a, 0x0a, 0x0b, 0x0b, 0x0c, 0x0c, 0x0d, 0x0d, 0x0e, 0x0e, 0x0f, 0x0f, 0x10,
+    0x10, 0x11, 0x11, 0x12, 0x12, 0x13, 0x13, 0x14, 0x14, 0x15, 0x15, 0x16, 0x16, 0x17, 0x17, 0x18,
+    0x18, 0x19, 0x19, 0x1a, 0x1a, 0x1b, 0x1b, 0x1c, 0x1c, 0x1d, 0x1d, 0x1e, 0x1e, 0x1f, 0x1f, 0x20,
+    0x20, 0x21, 0x21, 0x22, 0x22, 0x23, 0x23, 0x24, 0x24, 0x25, 0x25, 0x26, 0x26, 0x27, 0x27, 0x28,
+    0x28, 0x29, 0x29, 0x2a, 0x2a, 0x2b, 0x2b, 0x2c, 0x2c, 0x2d, 0x2d, 0x2e, 0x2e, 0x2f, 0x2f, 0x30,
+    0x30, 0x31, 0x31, 0x32, 0x32, 0x33, 0x33, 0x34, 0x34, 0x35, 0x35, 0x36, 0x36, 0x37, 0x37, 0x38,
+    0x38, 0x39, 0x39, 0x3a, 0x3a, 0x3b, 0x3b, 0x3c, 0x3c, 0x3d, 0x3d, 0x3e, 0x3e, 0x3f, 0x3f, 0x40,
+    0x40, 0x41, 0x41, 0x42, 0x42, 0x43, 0x43, 0x44, 0x44, 0x45, 0x45, 0x46, 0x46, 0x47, 0x47, 0x48,
+    0x48, 0x49, 0x49, 0x4a, 0x4a, 0x4b, 0x4b, 0x4c, 0x4c, 0x4d, 0x4d, 0x4e, 0x4e, 0x4f, 0x4f, 0x50,
+    0x50, 0x51, 0x51, 0x52, 0x52, 0x53, 0x53, 0x54, 0x54, 0x55, 0x55, 0x56, 0x56, 0x57, 0x57, 0x58,
+    0x58, 0x59, 0x59, 0x5a, 0x5a, 0x5b, 0x5b, 0x5c, 0x5c, 0x5d, 0x5d, 0x5e, 0x5e, 0x5f, 0x5f, 0x60,
+    0x60, 0x61, 0x61, 0x62, 0x62, 0x63, 0x63, 0x64, 0x64, 0x65, 0x65, 0x66, 0x66, 0x67, 0x67, 0x68,
+    0x68, 0x69, 0x69, 0x6a, 0x6a, 0x6b, 0x6b, 0x6c, 0x6c, 0x6d, 0x6d, 0x6e, 0x6e, 0x6f, 0x6f, 0x70,
+    0x70, 0x71, 0x71, 0x72, 0x72, 0x73, 0x73, 0x74, 0x74, 0x75, 0x75, 0x76, 0x76, 0x77, 0x77, 0x78,
+    0x78, 0x79, 0x79, 0x7a, 0x7a, 0x7b, 0x7b, 0x7c, 0x7c, 0x7d, 0x7d, 0x7e, 0x7e, 0x7f, 0x7f, 0x80
+};
+
+const uint8 pcAlphaFromPS2AlphaTable[256] =
+{
+    0x00, 0x02, 0x04, 0x06, 0x08, 0x0a, 0x0c, 0x0e, 0x10, 0x12, 0x14, 0x16, 0x18, 0x1a, 0x1c, 0x1e,
+    0x20, 0x22, 0x24, 0x26, 0x28, 0x2a, 0x2c, 0x2e, 0x30, 0x32, 0x34, 0x36, 0x38, 0x3a, 0x3c, 0x3e,
+    0x40, 0x42, 0x44, 0x46, 0x48, 0x4a, 0x4c, 0x4e, 0x50, 0x52, 0x54, 0x56, 0x58, 0x5a, 0x5c, 0x5e,
+    0x60, 0x62, 0x64, 0x66, 0x68, 0x6a, 0x6c, 0x6e, 0x70, 0x72, 0x74, 0x76, 0x78, 0x7a, 0x7c, 0x7e,
+    0x7f, 0x81, 0x83, 0x85, 0x87, 0x89, 0x8b, 0x8d, 0x8f, 0x91, 0x93, 0x95, 0x97, 0x99, 0x9b, 0x9d,
+    0x9f, 0xa1, 0xa3, 0xa5, 0xa7, 0xa9, 0xab, 0xad, 0xaf, 0xb1, 0xb3, 0xb5, 0xb7, 0xb9, 0xbb, 0xbd,
+    0xbf, 0xc1, 0xc3, 0xc5, 0xc7, 0xc9, 0xcb, 0xcd, 0xcf, 0xd1, 0xd3, 0xd5, 0xd7, 0xd9, 0xdb, 0xdd,
+    0xdf, 0xe1, 0xe3, 0xe5, 0xe7, 0xe9, 0xeb, 0xed, 0xef, 0xf1, 0xf3, 0xf5, 0xf7, 0xf9, 0xfb, 0xfd,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+template <eTexelAlphaRemap alphaRemap>
+AINLINE uint8 remapTexelAlpha( uint8 alpha )
+{
+    if ( alphaRemap == TEXEL_ALPHA_PC_TO_PS2 )
+    {
+        return ps2AlphaFromPCAlphaTable[ alpha ];
+    }
+    else if ( alphaRemap == TEXEL_ALPHA_PS2_TO_PC )
+    {
+        return pcAlphaFromPS2AlphaTable[ alpha ];
+    }
+
+    return alpha;
+}
+
+// Layout of texels that pack their four channels into 16bit.
+// The channel index is the memory position, not the logical color; a zero bit count
+// means that the channel does not exist (reads as 0xFF, like the generic path does).
+template <uint32 bitsPos0, uint32 bitsPos1, uint32 bitsPos2, uint32 bitsPos3>
+struct packed16TexelLayout
+{
+    static const bool canSIMDFetch = true;
+    static const bool canSIMDStore = true;
+
+    static const uint32 shiftPos0 = 0;
+    static const uint32 shiftPos1 = bitsPos0;
+    static const uint32 shiftPos2 = bitsPos0 + bitsPos1;
+    static const uint32 shiftPos3 = bitsPos0 + bitsPos1 + bitsPos2;
+
+    template <uint32 bits>
+    AINLINE static uint8 expandChannel( uint32 val )
+    {
+        if ( bits == 0 )
+        {
+            return 0xFF;
+        }
+
+        const uint32 maxVal = ( 1 << bits ) - 1;
+
+        return (uint8)( ( val & maxVal ) * 0xFF / maxVal );
+    }
+
+    template <uint32 bits>
+    AINLINE static uint32 reduceChannel( uint8 val )
+    {
+        if ( bits == 0 )
+        {
+            return 0;
+        }
+
+        if ( bits == 1 )
+        {
+            return ( val != 0 ) ? 1 : 0;
+        }
+
+        // Same result as scalecolor( val, 255, maxVal ), but without the floating point math.
+        const uint32 maxVal = ( 1 << bits ) - 1;
+
+        uint32 scaled = ( (uint32)val * maxVal );
+
+        return ( ( scaled + 1 + ( scaled >> 8 ) ) >> 8 );
+    }
+
+    AINLINE static void fetch( const void *texelRow, uint32 index, uint8 posOut[4] )
+    {
+        uint32 texel = *( (const uint16*)texelRow + index );
+
+        posOut[0] = expandChannel <bitsPos0> ( texel >> shiftPos0 );
+        posOut[1] = expandChannel <bitsPos1> ( texel >> shiftPos1 );
+        posOut[2] = expandChannel <bitsPos2> ( texel >> shiftPos2 );
+        posOut[3] = expandChannel <bitsPos3> ( texel >> shiftPos3 );
+    }
+
+    AINLINE static void store( void *texelRow, uint32 index, const uint8 pos[4] )
+    {
+        uint16 *texelPtr = ( (uint16*)texelRow + index );
+
+        uint32 texel =
+            ( reduceChannel <bitsPos0> ( pos[0] ) << shiftPos0 ) |
+            ( reduceChannel <bitsPos1> ( pos[1] ) << shiftPos1 ) |
+            ( reduceChannel <bitsPos2> ( pos[2] ) << shiftPos2 ) |
+            ( reduceChannel <bitsPos3> ( pos[3] ) << shiftPos3 );
+
+        // RASTER_555 does not use the top bit; the generic path leaves it untouched, so do we.
+        const uint32 usedBits = ( bitsPos0 + bitsPos1 + bitsPos2 + bitsPos3 );
+
+        if ( usedBits < 16 )
+        {
+            const uint32 keepMask = ( 0xFFFF << usedBits ) & 0xFFFF;
+
+            texel |= ( *texelPtr & keepMask );
+        }
+
+        *texelPtr = (uint16)texel;
+    }
+};
+
+// Layout of texels that store each channel as a byte.
+template <uint32 bytesPerTexel, bool hasAlpha>
+struct byteTexelLayout
+{
+    static const bool canSIMDFetch = ( bytesPerTexel == 4 );
+    static const bool canSIMDStore = ( bytesPerTexel == 4 && hasAlpha );
+
+    AINLINE static void fetch( const void *texelRow, uint32 index, uint8 posOut[4] )
+    {
+        const uint8 *texelPtr = ( (const uint8*)texelRow + index * bytesPerTexel );
+
+        posOut[0] = texelPtr[0];
+        posOut[1] = texelPtr[1];
+        posOut[2] = texelPtr[2];
+        posOut[3] = ( hasAlpha ? texelPtr[3] : 0xFF );
+    }
+
+    AINLINE static void store( void *texelRow, uint32 index, const uint8 pos[4] )
+    {
+        uint8 *texelPtr = ( (uint8*)texelRow + index * bytesPerTexel );
+
+        texelPtr[0] = pos[0];
+        texelPtr[1] = pos[1];
+        texelPtr[2] = pos[2];
+
+        // The unused byte of 888 32bit is left untouched.
+        if ( hasAlpha )
+        {
+            texelPtr[3] = pos[3];
+        }
+    }
+};
+
+// Memory position of each logical color channel.
+template <eColorOrdering colorOrder>
+struct colorOrderPositions;
+
+template <>
+struct colorOrderPositions <COLOR_RGBA>
+{
+    static const uint32 red = 0, green = 1, blue = 2, alpha = 3;
+};
+
+template <>
+struct colorOrderPositions <COLOR_BGRA>
+{
+    static const uint32 red = 2, green = 1, blue = 0, alpha = 3;
+};
+
+template <>
+struct colorOrderPositions <COLOR_ABGR>
+{
+    static const uint32 red = 3, green = 2, blue = 1, alpha = 0;
+};
+
+// All layouts that have a specialized kernel.
+// Keep this in sync with getRowKernelLayoutIndex.
+template <uint32 layoutIndex>
+struct rowKernelLayout;
+
+template <> struct rowKernelLayout <0> { typedef packed16TexelLayout <5, 5, 5, 1> layout_t; };   // RASTER_1555, 16bit
+template <> struct rowKernelLayout <1> { typedef packed16TexelLayout <5, 5, 5, 0> layout_t; };   // RASTER_555, 16bit
+template <> struct rowKernelLayout <2> { typedef packed16TexelLayout <5, 6, 5, 0> layout_t; };   // RASTER_565, 16bit
+template <> struct rowKernelLayout <3> { typedef packed16TexelLayout <4, 4, 4, 4> layout_t; };   // RASTER_4444, 16bit
+template <> struct rowKernelLayout <4> { typedef byteTexelLayout <4, true> layout_t; };          // RASTER_8888, 32bit
+template <> struct rowKernelLayout <5> { typedef byteTexelLayout <4, false> layout_t; };         // RASTER_888, 32bit
+template <> struct rowKernelLayout <6> { typedef byteTexelLayout <3, false> layout_t; };         // RASTER_888, 24bit
+
+static const uint32 NUM_ROWKERNEL_LAYOUTS = 7;
+static const uint32 NUM_ROWKERNEL_ORDERS = 3;
+static const uint32 NUM_ROWKERNEL_ENDPOINTS = ( NUM_ROWKERNEL_LAYOUTS * NUM_ROWKERNEL_ORDERS );
+
+inline bool getRowKernelLayoutIndex( eRasterFormat rasterFormat, uint32 depth, uint32& indexOut )
+{
+    if ( rasterFormat == RASTER_1555 && depth == 16 )
+    {
+        indexOut = 0;
+    }
+    else if ( rasterFormat == RASTER_555 && depth == 16 )
+    {
+        indexOut = 1;
+    }
+    else if ( rasterFormat == RASTER_565 && depth == 16 )
+    {
+        indexOut = 2;
+    }
+    else if ( rasterFormat == RASTER_4444 && depth == 16 )
+    {
+        indexOut = 3;
+    }
+    else if ( rasterFormat == RASTER_8888 && depth == 32 )
+    {
+        indexOut = 4;
+    }
+    else if ( rasterFormat == RASTER_888 && depth == 32 )
+    {
+        indexOut = 5;
+    }
+    else if ( rasterFormat == RASTER_888 && depth == 24 )
+    {
+        indexOut = 6;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef RWLIB_SIMD_SSE2
+
+// Vectorized conversion works on eight texels at a time (sixteen for AVX2).
+// Every channel is unpacked into 16bit lanes, expanded to the 8bit range, permuted
+// and packed into the destination layout again.
+struct sse2RowOps
+{
+    typedef __m128i vec_t;
+
+    static const uint32 texelsPerIteration = 8;
+
+    AINLINE static vec_t set16( uint16 val )                { return _mm_set1_epi16( (short)val ); }
+    AINLINE static vec_t zero( void )                       { return _mm_setzero_si128(); }
+    AINLINE static vec_t and_( vec_t a, vec_t b )           { return _mm_and_si128( a, b ); }
+    AINLINE static vec_t andnot_( vec_t a, vec_t b )        { return _mm_andnot_si128( a, b ); }
+    AINLINE static vec_t or_( vec_t a, vec_t b )            { return _mm_or_si128( a, b ); }
+    AINLINE static vec_t add16( vec_t a, vec_t b )          { return _mm_add_epi16( a, b ); }
+    AINLINE static vec_t mullo16( vec_t a, vec_t b )        { return _mm_mullo_epi16( a, b ); }
+    AINLINE static vec_t mulhi16( vec_t a, vec_t b )        { return _mm_mulhi_epu16( a, b ); }
+    AINLINE static vec_t cmpeq16( vec_t a, vec_t b )        { return _mm_cmpeq_epi16( a, b ); }
+    AINLINE static vec_t min16( vec_t a, vec_t b )          { return _mm_min_epi16( a, b ); }
+    AINLINE static vec_t srl16( vec_t a, int cnt )          { return _mm_srli_epi16( a, cnt ); }
+    AINLINE static vec_t sll16( vec_t a, int cnt )          { return _mm_slli_epi16( a, cnt ); }
+
+    AINLINE static vec_t load( const void *ptr )            { return _mm_loadu_si128( (const __m128i*)ptr ); }
+    AINLINE static void store( void *ptr, vec_t val )       { _mm_storeu_si128( (__m128i*)ptr, val ); }
+
+    // Splits two vectors of 32bit texels into their low and high halves, as 16bit lanes in texel order.
+    AINLINE static void split32( vec_t first, vec_t second, vec_t& lowOut, vec_t& highOut )
+    {
+        // Sign-extend so that the saturating pack keeps the bit pattern.
+        vec_t firstLow = _mm_srai_epi32( _mm_slli_epi32( first, 16 ), 16 );
+        vec_t secondLow = _mm_srai_epi32( _mm_slli_epi32( second, 16 ), 16 );
+        vec_t firstHigh = _mm_srai_epi32( first, 16 );
+        vec_t secondHigh = _mm_srai_epi32( second, 16 );
+
+        lowOut = _mm_packs_epi32( firstLow, secondLow );
+        highOut = _mm_packs_epi32( firstHigh, secondHigh );
+    }
+
+    // Inverse of split32.
+    AINLINE static void join32( vec_t low, vec_t high, vec_t& firstOut, vec_t& secondOut )
+    {
+        firstOut = _mm_unpacklo_epi16( low, high );
+        secondOut = _mm_unpackhi_epi16( low, high );
+    }
+};
+
+#ifdef RWLIB_SIMD_AVX2
+
+struct avx2RowOps
+{
+    typedef __m256i vec_t;
+
+    static const uint32 texelsPerIteration = 16;
+
+    AINLINE static vec_t set16( uint16 val )                { return _mm256_set1_epi16( (short)val ); }
+    AINLINE static vec_t zero( void )                       { return _mm256_setzero_si256(); }
+    AINLINE static vec_t and_( vec_t a, vec_t b )           { return _mm256_and_si256( a, b ); }
+    AINLINE static vec_t andnot_( vec_t a, vec_t b )        { return _mm256_andnot_si256( a, b ); }
+    AINLINE static vec_t or_( vec_t a, vec_t b )            { return _mm256_or_si256( a, b ); }
+    AINLINE static vec_t add16( vec_t a, vec_t b )          { return _mm256_add_epi16( a, b ); }
+    AINLINE static vec_t mullo16( vec_t a, vec_t b )        { return _mm256_mullo_epi16( a, b ); }
+    AINLINE static vec_t mulhi16( vec_t a, vec_t b )        { return _mm256_mulhi_epu16( a, b ); }
+    AINLINE static vec_t cmpeq16( vec_t a, vec_t b )        { return _mm256_cmpeq_epi16( a, b ); }
+    AINLINE static vec_t min16( vec_t a, vec_t b )          { return _mm256_min_epi16( a, b ); }
+    AINLINE static vec_t srl16( vec_t a, int cnt )          { return _mm256_srli_epi16( a, cnt ); }
+    AINLINE static vec_t sll16( vec_t a, int cnt )          { return _mm256_slli_epi16( a, cnt ); }
+
+    AINLINE static vec_t load( const void *ptr )            { return _mm256_loadu_si256( (const __m256i*)ptr ); }
+    AINLINE static void store( void *ptr, vec_t val )       { _mm256_storeu_si256( (__m256i*)ptr, val ); }
+
+    AINLINE static void split32( vec_t first, vec_t second, vec_t& lowOut, vec_t& highOut )
+    {
+        vec_t firstLow = _mm256_srai_epi32( _mm256_slli_epi32( first, 16 ), 16 );
+        vec_t secondLow = _mm256_srai_epi32( _mm256_slli_epi32( second, 16 ), 16 );
+        vec_t firstHigh = _mm256_srai_epi32( first, 16 );
+        vec_t secondHigh = _mm256_srai_epi32( second, 16 );
+
+        // The pack instructions work per 128bit lane, so restore the texel order.
+        lowOut = _mm256_permute4x64_epi64( _mm256_packs_epi32( firstLow, secondLow ), 0xD8 );
+        highOut = _mm256_permute4x64_epi64( _mm256_packs_epi32( firstHigh, secondHigh ), 0xD8 );
+    }
+
+    AINLINE static void join32( vec_t low, vec_t high, vec_t& firstOut, vec_t& secondOut )
+    {
+        vec_t interleavedLow = _mm256_unpacklo_epi16( low, high );
+        vec_t interleavedHigh = _mm256_unpackhi_epi16( low, high );
+
+        firstOut = _mm256_permute2x128_si256( interleavedLow, interleavedHigh, 0x20 );
+        secondOut = _mm256_permute2x128_si256( interleavedLow, interleavedHigh, 0x31 );
+    }
+};
+
+#endif //RWLIB_SIMD_AVX2
+
+// Expands a channel of 'bits' width (already masked) to the 8bit range.
+// Uses v * 255 / max, which the multiply-high constants reproduce exactly for every v.
+template <typename simdOps, uint32 bits>
+AINLINE typename simdOps::vec_t simdExpandChannel( typename simdOps::vec_t val )
+{
+    typedef typename simdOps::vec_t vec_t;
+
+    if ( bits == 0 )
+    {
+        return simdOps::set16( 0xFF );
+    }
+
+    if ( bits == 8 )
+    {
+        return val;
+    }
+
+    vec_t scaled = simdOps::mullo16( val, simdOps::set16( 0xFF ) );
+
+    if ( bits == 1 )
+    {
+        return scaled;
+    }
+    else if ( bits == 4 )
+    {
+        return simdOps::mulhi16( scaled, simdOps::set16( 4370 ) );
+    }
+    else if ( bits == 5 )
+    {
+        return simdOps::srl16( simdOps::mulhi16( scaled, simdOps::set16( 8457 ) ), 2 );
+    }
+    else if ( bits == 6 )
+    {
+        return simdOps::srl16( simdOps::mulhi16( scaled, simdOps::set16( 8323 ) ), 3 );
+    }
+
+    return val;
+}
+
+// Vector version of packed16TexelLayout::reduceChannel.
+template <typename simdOps, uint32 bits>
+AINLINE typename simdOps::vec_t simdReduceChannel( typename simdOps::vec_t val )
+{
+    typedef typename simdOps::vec_t vec_t;
+
+    if ( bits == 0 )
+    {
+        return simdOps::zero();
+    }
+
+    if ( bits == 1 )
+    {
+        return simdOps::andnot_( simdOps::cmpeq16( val, simdOps::zero() ), simdOps::set16( 1 ) );
+    }
+
+    const uint16 maxVal = (uint16)( ( 1 << bits ) - 1 );
+
+    vec_t scaled = simdOps::mullo16( val, simdOps::set16( maxVal ) );
+
+    vec_t rounded = simdOps::add16( simdOps::add16( scaled, simdOps::set16( 1 ) ), simdOps::srl16( scaled, 8 ) );
+
+    return simdOps::srl16( rounded, 8 );
+}
+
+// Vector version of remapTexelAlpha. There is no table lookup in SSE2, so the tables are
+// computed; both formulas give the table entries for every alpha value.
+template <typename simdOps, eTexelAlphaRemap alphaRemap>
+AINLINE typename simdOps::vec_t simdRemapAlpha( typename simdOps::vec_t alpha )
+{
+    typedef typename simdOps::vec_t vec_t;
+
+    if ( alphaRemap == TEXEL_ALPHA_PC_TO_PS2 )
+    {
+        // ( alpha * 128 + 127 ) / 255, which rounds alpha * 128 / 255 to the nearest.
+        vec_t scaled = simdOps::add16( simdOps::sll16( alpha, 7 ), simdOps::set16( 127 ) );
+
+        return simdOps::srl16( simdOps::add16( simdOps::add16( scaled, simdOps::set16( 1 ) ), simdOps::srl16( scaled, 8 ) ), 8 );
+    }
+    else if ( alphaRemap == TEXEL_ALPHA_PS2_TO_PC )
+    {
+        // alpha * 255 / 128, rounded up from a fraction of 65/128 on, clamped to 255.
+        vec_t scaled = simdOps::add16( simdOps::mullo16( alpha, simdOps::set16( 0xFF ) ), simdOps::set16( 63 ) );
+
+        return simdOps::min16( simdOps::srl16( scaled, 7 ), simdOps::set16( 0xFF ) );
+    }
+
+    return alpha;
+}
+
+template <typename simdOps, typename layout_t>
+struct simdLayoutCodec;
+
+template <typename simdOps, uint32 bitsPos0, uint32 bitsPos1, uint32 bitsPos2, uint32 bitsPos3>
+struct simdLayoutCodec <simdOps, packed16TexelLayout <bitsPos0, bitsPos1, bitsPos2, bitsPos3>>
+{
+    typedef packed16TexelLayout <bitsPos0, bitsPos1, bitsPos2, bitsPos3> layout_t;
+    typedef typename simdOps::vec_t vec_t;
+
+    template <uint32 bits, uint32 shift>
+    AINLINE static vec_t extract( vec_t texels )
+    {
+        if ( bits == 0 )
+        {
+            return simdOps::set16( 0xFF );
+        }
+
+        vec_t val = simdOps::and_( simdOps::srl16( texels, shift ), simdOps::set16( (uint16)( ( 1 << bits ) - 1 ) ) );
+
+        return simdExpandChannel <simdOps, bits> ( val );
+    }
+
+    AINLINE static void fetch( const void *texelRow, uint32 index, vec_t posOut[4] )
+    {
+        vec_t texels = simdOps::load( (const uint16*)texelRow + index );
+
+        posOut[0] = extract <bitsPos0, layout_t::shiftPos0> ( texels );
+        posOut[1] = extract <bitsPos1, layout_t::shiftPos1> ( texels );
+        posOut[2] = extract <bitsPos2, layout_t::shiftPos2> ( texels );
+        posOut[3] = extract <bitsPos3, layout_t::shiftPos3> ( texels );
+    }
+
+    AINLINE static void store( void *texelRow, uint32 index, const vec_t pos[4] )
+    {
+        uint16 *texelPtr = ( (uint16*)texelRow + index );
+
+        vec_t texels =
+            simdOps::or_(
+                simdOps::or_(
+                    simdOps::sll16( simdReduceChannel <simdOps, bitsPos0> ( pos[0] ), layout_t::shiftPos0 ),
+                    simdOps::sll16( simdReduceChannel <simdOps, bitsPos1> ( pos[1] ), layout_t::shiftPos1 )
+                ),
+                simdOps::or_(
+                    simdOps::sll16( simdReduceChannel <simdOps, bitsPos2> ( pos[2] ), layout_t::shiftPos2 ),
+                    simdOps::sll16( simdReduceChannel <simdOps, bitsPos3> ( pos[3] ), layout_t::shiftPos3 )
+                )
+            );
+
+        const uint32 usedBits = ( bitsPos0 + bitsPos1 + bitsPos2 + bitsPos3 );
+
+        if ( usedBits < 16 )
+        {
+            const uint16 keepMask = (uint16)( ( 0xFFFF << usedBits ) & 0xFFFF );
+
+            texels = simdOps::or_( texels, simdOps::and_( simdOps::load( texelPtr ), simdOps::set16( keepMask ) ) );
+        }
+
+        simdOps::store( texelPtr, texels );
+    }
+};
+
+template <typename simdOps, uint32 bytesPerTexel, bool hasAlpha>
+struct simdLayoutCodec <simdOps, byteTexelLayout <bytesPerTexel, hasAlpha>>
+{
+    typedef typename simdOps::vec_t vec_t;
+
+    static const uint32 texelsPerVector = ( simdOps::texelsPerIteration / 2 );
+
+    AINLINE static void fetch( const void *texelRow, uint32 index, vec_t posOut[4] )
+    {
+        const uint32 *texelPtr = ( (const uint32*)texelRow + index );
+
+        vec_t lowHalf, highHalf;
+
+        simdOps::split32( simdOps::load( texelPtr ), simdOps::load( texelPtr + texelsPerVector ), lowHalf, highHalf );
+
+        vec_t byteMask = simdOps::set16( 0xFF );
+
+        posOut[0] = simdOps::and_( lowHalf, byteMask );
+        posOut[1] = simdOps::srl16( lowHalf, 8 );
+        posOut[2] = simdOps::and_( highHalf, byteMask );
+        posOut[3] = ( hasAlpha ? simdOps::srl16( highHalf, 8 ) : byteMask );
+    }
+
+    AINLINE static void store( void *texelRow, uint32 index, const vec_t pos[4] )
+    {
+        // Only used for layouts that have all four channels.
+        uint32 *texelPtr = ( (uint32*)texelRow + index );
+
+        vec_t lowHalf = simdOps::or_( pos[0], simdOps::sll16( pos[1], 8 ) );
+        vec_t highHalf = simdOps::or_( pos[2], simdOps::sll16( pos[3], 8 ) );
+
+        vec_t first, second;
+
+        simdOps::join32( lowHalf, highHalf, first, second );
+
+        simdOps::store( texelPtr, first );
+        simdOps::store( texelPtr + texelsPerVector, second );
+    }
+};
+
+template <typename simdOps, typename srcLayout, eColorOrdering srcOrder, typename dstLayout, eColorOrdering dstOrder, eTexelAlphaRemap alphaRemap>
+AINLINE uint32 convertTexelRowSIMD( const void *srcRow, void *dstRow, uint32 srcOffX, uint32 dstOffX, uint32 texelCount )
+{
+    typedef typename simdOps::vec_t vec_t;
+
+    typedef colorOrderPositions <srcOrder> srcPos;
+    typedef colorOrderPositions <dstOrder> dstPos;
+
+    const uint32 step = simdOps::texelsPerIteration;
+
+    uint32 n = 0;
+
+    while ( n + step <= texelCount )
+    {
+        vec_t srcChannels[4];
+
+        simdLayoutCodec <simdOps, srcLayout>::fetch( srcRow, srcOffX + n, srcChannels );
+
+        vec_t dstChannels[4];
+        dstChannels[ dstPos::red ] = srcChannels[ srcPos::red ];
+        dstChannels[ dstPos::green ] = srcChannels[ srcPos::green ];
+        dstChannels[ dstPos::blue ] = srcChannels[ srcPos::blue ];
+        dstChannels[ dstPos::alpha ] = simdRemapAlpha <simdOps, alphaRemap> ( srcChannels[ srcPos::alpha ] );
+
+        simdLayoutCodec <simdOps, dstLayout>::store( dstRow, dstOffX + n, dstChannels );
+
+        n += step;
+    }
+
+    return n;
+}
+
+#endif //RWLIB_SIMD_SSE2
+
+template <typename srcLayout, eColorOrdering srcOrder, typename dstLayout, eColorOrdering dstOrder, eTexelAlphaRemap alphaRemap = TEXEL_ALPHA_KEEP>
+struct texelRowKernel
+{
+    static void convert( const void *srcRow, void *dstRow, uint32 srcOffX, uint32 dstOffX, uint32 texelCount )
+    {
+        typedef colorOrderPositions <srcOrder> srcPos;
+        typedef colorOrderPositions <dstOrder> dstPos;
+
+        uint32 n = 0;
+
+#ifdef RWLIB_SIMD_SSE2
+        if ( srcLayout::canSIMDFetch && dstLayout::canSIMDStore )
+        {
+#ifdef RWLIB_SIMD_AVX2
+            if ( HasAVX2Support() )
+            {
+                n = convertTexelRowSIMD <avx2RowOps, srcLayout, srcOrder, dstLayout, dstOrder, alphaRemap> ( srcRow, dstRow, srcOffX, dstOffX, texelCount );
+            }
+#endif //RWLIB_SIMD_AVX2
+
+            n += convertTexelRowSIMD <sse2RowOps, srcLayout, srcOrder, dstLayout, dstOrder, alphaRemap> ( srcRow, dstRow, srcOffX + n, dstOffX + n, texelCount - n );
+        }
+#endif //RWLIB_SIMD_SSE2
+
+        // Process the remainder texel by texel.
+        for ( ; n < texelCount; n++ )
+        {
+            uint8 srcChannels[4];
+
+            srcLayout::fetch( srcRow, srcOffX + n, srcChannels );
+
+            uint8 dstChannels[4];
+            dstChannels[ dstPos::red ] = srcChannels[ srcPos::red ];
+            dstChannels[ dstPos::green ] = srcChannels[ srcPos::green ];
+            dstChannels[ dstPos::blue ] = srcChannels[ srcPos::blue ];
+            dstChannels[ dstPos::alpha ] = remapTexelAlpha <alphaRemap> ( srcChannels[ srcPos::alpha ] );
+
+            dstLayout::store( dstRow, dstOffX + n, dstChannels );
+        }
+    }
+};
+
+// Maps a flat table index to the kernel of its (src layout, src order, dst layout, dst order) combination.
+template <uint32 kernelIndex>
+struct texelRowKernelByIndex
+{
+    static const uint32 srcEndpoint = ( kernelIndex / NUM_ROWKERNEL_ENDPOINTS );
+    static const uint32 dstEndpoint = ( kernelIndex % NUM_ROWKERNEL_ENDPOINTS );
+
+    typedef texelRowKernel <
+        typename rowKernelLayout <srcEndpoint / NUM_ROWKERNEL_ORDERS>::layout_t, (eColorOrdering)( srcEndpoint % NUM_ROWKERNEL_ORDERS ),
+        typename rowKernelLayout <dstEndpoint / NUM_ROWKERNEL_ORDERS>::layout_t, (eColorOrdering)( dstEndpoint % NUM_ROWKERNEL_ORDERS )
+    > kernel_t;
+};
+
+template <size_t... kernelIndices>
+inline const texelRowKernel_t* getTexelRowKernelTable( std::index_sequence <kernelIndices...> )
+{
+    static const texelRowKernel_t kernelTable[] =
+    {
+        &texelRowKernelByIndex <kernelIndices>::kernel_t::convert...
+    };
+
+    return kernelTable;
+}
+
+texelRowKernel_t GetTexelRowKernel(
+    eRasterFormat srcRasterFormat, uint32 srcDepth, eColorOrdering srcColorOrder,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder
+)
+{
+    uint32 srcLayoutIndex, dstLayoutIndex;
+
+    if ( !getRowKernelLayoutIndex( srcRasterFormat, srcDepth, srcLayoutIndex ) ||
+         !getRowKernelLayoutIndex( dstRasterFormat, dstDepth, dstLayoutIndex ) )
+    {
+        // Exotic combination; use the generic path.
+        return NULL;
+    }
+
+    if ( (uint32)srcColorOrder >= NUM_ROWKERNEL_ORDERS || (uint32)dstColorOrder >= NUM_ROWKERNEL_ORDERS )
+    {
+        return NULL;
+    }
+
+    static const texelRowKernel_t *kernelTable =
+        getTexelRowKernelTable( std::make_index_sequence <NUM_ROWKERNEL_ENDPOINTS * NUM_ROWKERNEL_ENDPOINTS> () );
+
+    uint32 srcEndpoint = ( srcLayoutIndex * NUM_ROWKERNEL_ORDERS + (uint32)srcColorOrder );
+    uint32 dstEndpoint = ( dstLayoutIndex * NUM_ROWKERNEL_ORDERS + (uint32)dstColorOrder );
+
+    return kernelTable[ srcEndpoint * NUM_ROWKERNEL_ENDPOINTS + dstEndpoint ];
+}
+
+// Alpha remapping kernels only exist for destination layouts that have an alpha channel
+// (RASTER_1555, RASTER_4444 and RASTER_8888). The others drop the alpha anyway, unless
+// the color order puts it in the place of a color channel.
+static const uint32 NUM_ALPHAREMAP_DST_LAYOUTS = 3;
+static const uint32 NUM_ALPHAREMAP_DST_ENDPOINTS = ( NUM_ALPHAREMAP_DST_LAYOUTS * NUM_ROWKERNEL_ORDERS );
+static const uint32 NUM_ALPHAREMAP_KERNELS_PER_MODE = ( NUM_ROWKERNEL_ENDPOINTS * NUM_ALPHAREMAP_DST_ENDPOINTS );
+
+inline bool getAlphaRemapDstLayoutSlot( uint32 layoutIndex, uint32& slotOut )
+{
+    if ( layoutIndex == 0 )
+    {
+        slotOut = 0;
+    }
+    else if ( layoutIndex == 3 )
+    {
+        slotOut = 1;
+    }
+    else if ( layoutIndex == 4 )
+    {
+        slotOut = 2;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+template <uint32 kernelIndex>
+struct alphaRemapRowKernelByIndex
+{
+    static const uint32 remapMode = ( kernelIndex / NUM_ALPHAREMAP_KERNELS_PER_MODE );
+    static const uint32 pairIndex = ( kernelIndex % NUM_ALPHAREMAP_KERNELS_PER_MODE );
+
+    static const uint32 srcEndpoint = ( pairIndex / NUM_ALPHAREMAP_DST_ENDPOINTS );
+    static const uint32 dstEndpoint = ( pairIndex % NUM_ALPHAREMAP_DST_ENDPOINTS );
+
+    // Inverse of getAlphaRemapDstLayoutSlot.
+    static const uint32 dstSlot = ( dstEndpoint / NUM_ROWKERNEL_ORDERS );
+    static const uint32 dstLayoutIndex = ( dstSlot == 0 ? 0 : dstSlot + 2 );
+
+    typedef texelRowKernel <
+        typename rowKernelLayout <srcEndpoint / NUM_ROWKERNEL_ORDERS>::layout_t, (eColorOrdering)( srcEndpoint % NUM_ROWKERNEL_ORDERS ),
+        typename rowKernelLayout <dstLayoutIndex>::layout_t, (eColorOrdering)( dstEndpoint % NUM_ROWKERNEL_ORDERS ),
+        (eTexelAlphaRemap)( TEXEL_ALPHA_PC_TO_PS2 + remapMode )
+    > kernel_t;
+};
+
+template <size_t... kernelIndices>
+inline const texelRowKernel_t* getAlphaRemapTexelRowKernelTable( std::index_sequence <kernelIndices...> )
+{
+    static const texelRowKernel_t kernelTable[] =
+    {
+        &alphaRemapRowKernelByIndex <kernelIndices>::kernel_t::convert...
+    };
+
+    return kernelTable;
+}
+
+texelRowKernel_t GetAlphaRemapTexelRowKernel(
+    eRasterFormat srcRasterFormat, uint32 srcDepth, eColorOrdering srcColorOrder,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, eColorOrdering dstColorOrder,
+    eTexelAlphaRemap alphaRemap
+)
+{
+    uint32 srcLayoutIndex, dstLayoutIndex;
+
+    if ( !getRowKernelLayoutIndex( srcRasterFormat, srcDepth, srcLayoutIndex ) ||
+         !getRowKernelLayoutIndex( dstRasterFormat, dstDepth, dstLayoutIndex ) )
+    {
+        return NULL;
+    }
+
+    if ( (uint32)srcColorOrder >= NUM_ROWKERNEL_ORDERS || (uint32)dstColorOrder >= NUM_ROWKERNEL_ORDERS )
+    {
+        return NULL;
+    }
+
+    if ( alphaRemap == TEXEL_ALPHA_KEEP )
+    {
+        return GetTexelRowKernel( srcRasterFormat, srcDepth, srcColorOrder, dstRasterFormat, dstDepth, dstColorOrder );
+    }
+
+    uint32 dstSlot;
+
+    if ( !getAlphaRemapDstLayoutSlot( dstLayoutIndex, dstSlot ) )
+    {
+        if ( dstColorOrder == COLOR_ABGR )
+        {
+            // Alpha ends up in a color channel; use the generic path.
+            return NULL;
+        }
+
+        // Nothing to remap.
+        return GetTexelRowKernel( srcRasterFormat, srcDepth, srcColorOrder, dstRasterFormat, dstDepth, dstColorOrder );
+    }
+
+    static const texelRowKernel_t *kernelTable =
+        getAlphaRemapTexelRowKernelTable( std::make_index_sequence <2 * NUM_ALPHAREMAP_KERNELS_PER_MODE> () );
+
+    uint32 remapMode = ( (uint32)alphaRemap - (uint32)TEXEL_ALPHA_PC_TO_PS2 );
+
+    uint32 srcEndpoint = ( srcLayoutIndex * NUM_ROWKERNEL_ORDERS + (uint32)srcColorOrder );
+    uint32 dstEndpoint = ( dstSlot * NUM_ROWKERNEL_ORDERS + (uint32)dstColorOrder );
+
+    return kernelTable[ remapMode * NUM_ALPHAREMAP_KERNELS_PER_MODE + srcEndpoint * NUM_ALPHAREMAP_DST_ENDPOINTS + dstEndpoint ];
+}
+
+};
@@ -28,6 +28,8 @@
 
 #include "txdread.ps2shared.enc.hxx"
 
+#include "rwparallel.hxx"
+
 namespace rw
 {
 
@@ -1138,6 +1140,62 @@ inline void GetPS2TextureTranscodedMipmapData(
     dstDataSizeOut = dstDataSize;
 }
 
+// Transcodes the mipmap layers of a PS2 texture into pixel storage, one task per layer.
+struct ps2MipmapLayerTranscoder
+{
+    Interface *engineInterface;
+
+    const NativeTexturePS2 *platformTex;
+
+    eFormatEncodingType mipmapSwizzleEncodingType;
+    eFormatEncodingType mipmapDecodeFormat;
+
+    eRasterFormat rasterFormat;
+    uint32 depth;
+    eColorOrdering ps2ColorOrder;
+    eColorOrdering d3dColorOrder;
+    ePaletteType paletteType;
+    uint32 palSize;
+
+    pixelDataTraversal *pixelsOut;
+
+    void operator () ( size_t j ) const
+    {
+        const NativeTexturePS2::GSMipmap& gsTex = this->platformTex->mipmaps[ j ];
+
+        // We have to create a new texture buffer that is unswizzled to linear format.
+        uint32 layerWidth = gsTex.width;
+        uint32 layerHeight = gsTex.height;
+
+        void *dstTexels = NULL;
+        uint32 dstDataSize = 0;
+
+        GetPS2TextureTranscodedMipmapData(
+            this->engineInterface,
+            layerWidth, layerHeight, gsTex.swizzleWidth, gsTex.swizzleHeight, gsTex.texels, gsTex.dataSize,
+            this->mipmapSwizzleEncodingType, this->mipmapDecodeFormat,
+            this->rasterFormat, this->depth, this->ps2ColorOrder,
+            this->rasterFormat, this->depth, this->d3dColorOrder,
+            this->paletteType, this->palSize,
+            dstTexels, dstDataSize
+        );
+
+        // Move over the texture data to pixel storage.
+        pixelDataTraversal::mipmapResource newLayer;
+
+        newLayer.width = layerWidth;
+        newLayer.height = layerHeight;
+        newLayer.mipWidth = layerWidth;   // layer dimensions.
+        newLayer.mipHeight = layerHeight;
+
+        newLayer.texels = dstTexels;
+        newLayer.dataSize = dstDataSize;
+
+        // Store the layer.
+        this->pixelsOut->mipmaps[ j ] = newLayer;
+    }
+};
+
 void ps2NativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInterface, void *objMem, pixelDataTraversal& pixelsOut )
 {
     // Cast to our native platform texture.
@@ -1198,43 +1256,30 @@ void ps2NativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInt
 
         pixelsOut.mipmaps.resize( mipmapCount );
 
-        for (size_t j = 0; j < mipmapCount; j++)
+        ps2MipmapLayerTranscoder transcoder;
+        transcoder.engineInterface = engineInterface;
+        transcoder.platformTex = platformTex;
+        transcoder.mipmapSwizzleEncodingType = mipmapSwizzleEncodingType;
+        transcoder.mipmapDecodeFormat = mipmapDecodeFormat;
+        transcoder.rasterFormat = rasterFormat;
+        transcoder.depth = depth;
+        transcoder.ps2ColorOrder = ps2ColorOrder;
+        transcoder.d3dColorOrder = d3dColorOrder;
+        transcoder.paletteType = paletteType;
+        transcoder.palSize = palSize;
+        transcoder.pixelsOut = &pixelsOut;
+
+        // The layers are independent from each other, so big textures are unswizzled by all workers at once.
+        if ( mipmapCount > 1 && ShouldProcessTexelsInParallel( engineInterface, GetMipmapLayersTexelCount( platformTex->mipmaps ) ) )
         {
-            NativeTexturePS2::GSMipmap& gsTex = platformTex->mipmaps[ j ];
-
-            // We have to create a new texture buffer that is unswizzled to linear format.
-            uint32 layerWidth = gsTex.width;
-            uint32 layerHeight = gsTex.height;
-
-            const void *srcTexels = gsTex.texels;
-            uint32 texDataSize = gsTex.dataSize;
-
-            void *dstTexels = NULL;
-            uint32 dstDataSize = 0;
-
-            GetPS2TextureTranscodedMipmapData(
-                engineInterface,
-                layerWidth, layerHeight, gsTex.swizzleWidth, gsTex.swizzleHeight, gsTex.texels, gsTex.dataSize,
-                mipmapSwizzleEncodingType, mipmapDecodeFormat,
-                rasterFormat, depth, ps2ColorOrder,
-                rasterFormat, depth, d3dColorOrder,
-                paletteType, palSize,
-                dstTexels, dstDataSize
-            );
-
-            // Move over the texture data to pixel storage.
-            pixelDataTraversal::mipmapResource newLayer;
-
-            newLayer.width = layerWidth;
-            newLayer.height = layerHeight;
-            newLayer.mipWidth = layerWidth;   // layer dimensions.
-            newLayer.mipHeight = layerHeight;
-
-            newLayer.texels = dstTexels;
-            newLayer.dataSize = dstDataSize;
-
-            // Store the layer.
-            pixelsOut.mipmaps[ j ] = newLayer;
+            ParallelForEach( engineInterface, mipmapCount, transcoder );
+        }
+        else
+        {
+            for (size_t j = 0; j < mipmapCount; j++)
+            {
+                transcoder( j );
+            }
         }
     }
 
@@ -10,10 +10,11 @@ inline double clampcolor( double theColor )
     return std::min( 1.0, std::max( 0.0, theColor ) );
 }
 
+// Reference implementations of the PS2 alpha remapping.
+// Texel conversion uses ps2AlphaFromPCAlphaTable and pcAlphaFromPS2AlphaTable instead,
+// which have to give the same results.
 inline uint8 convertPCAlpha2PS2Alpha( uint8 pcAlpha )
 {
-    // TODO: generate a table that maps PC alpha to PS2 alpha.
-
     double pcAlphaDouble = clampcolor( (double)pcAlpha / 255.0 );
 
     double ps2AlphaDouble = pcAlphaDouble * 128.0;
@@ -27,9 +28,6 @@ inline uint8 convertPCAlpha2PS2Alpha( uint8 pcAlpha )
 
 inline uint8 convertPS2Alpha2PCAlpha( uint8 ps2Alpha )
 {
-    // TODO: generate a table that maps PS2 alpha to PC alpha
-    // it has to conform with the table in convertPCAlpha2PS2Alpha
-
     double ps2AlphaDouble = clampcolor( (double)ps2Alpha / 128.0 );
 
     double pcAlphaDouble = ps2AlphaDouble * 255.0;
@@ -81,12 +79,30 @@ inline void convertTexelsFromPS2(
         )
     )
     {
-        colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, NULL, 0, PALETTE_NONE );
-        colorModelDispatcher <void> putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
-
         uint32 srcRowSize = getRasterDataRowSize( mipWidth, srcDepth, srcRowAlignment );
         uint32 dstRowSize = getRasterDataRowSize( mipWidth, dstDepth, dstRowAlignment );
 
+        // Common formats have a specialized kernel.
+        texelRowKernel_t rowKernel =
+            GetAlphaRemapTexelRowKernel(
+                srcRasterFormat, srcDepth, srcColorOrder,
+                dstRasterFormat, dstDepth, dstColorOrder,
+                ( fixAlpha ? TEXEL_ALPHA_PS2_TO_PC : TEXEL_ALPHA_KEEP )
+            );
+
+        if ( rowKernel != NULL )
+        {
+            for ( uint32 row = 0; row < mipHeight; row++ )
+            {
+                rowKernel( getConstTexelDataRow( texelSource, srcRowSize, row ), getTexelDataRow( dstTexels, dstRowSize, row ), 0, 0, mipWidth );
+            }
+
+            return;
+        }
+
+        colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, NULL, 0, PALETTE_NONE );
+        colorModelDispatcher <void> putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
+
         for (uint32 row = 0; row < mipHeight; row++)
         {
             const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, row );
@@ -100,7 +116,7 @@ inline void convertTexelsFromPS2(
 	            // fix alpha
                 if (fixAlpha)
                 {
-                    uint8 newAlpha = convertPS2Alpha2PCAlpha(alpha);
+                    uint8 newAlpha = pcAlphaFromPS2AlphaTable[alpha];
 
 #ifdef DEBUG_ALPHA_LEVELS
                     assert(convertPCAlpha2PS2Alpha(newAlpha) == alpha);
@@ -137,12 +153,30 @@ inline void convertTexelsToPS2(
         )
     )
     {
-        colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcItemDepth, NULL, 0, PALETTE_NONE );
-        colorModelDispatcher <void> putDispatch( dstRasterFormat, ps2ColorOrder, dstItemDepth, NULL, 0, PALETTE_NONE );
-
         uint32 srcRowSize = getRasterDataRowSize( mipWidth, srcItemDepth, srcRowAlignment );
         uint32 dstRowSize = getRasterDataRowSize( mipWidth, dstItemDepth, dstRowAlignment );
 
+        // Common formats have a specialized kernel.
+        texelRowKernel_t rowKernel =
+            GetAlphaRemapTexelRowKernel(
+                srcRasterFormat, srcItemDepth, srcColorOrder,
+                dstRasterFormat, dstItemDepth, ps2ColorOrder,
+                ( fixAlpha ? TEXEL_ALPHA_PC_TO_PS2 : TEXEL_ALPHA_KEEP )
+            );
+
+        if ( rowKernel != NULL )
+        {
+            for ( uint32 row = 0; row < mipHeight; row++ )
+            {
+                rowKernel( getConstTexelDataRow( srcTexelData, srcRowSize, row ), getTexelDataRow( dstTexelData, dstRowSize, row ), 0, 0, mipWidth );
+            }
+
+            return;
+        }
+
+        colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcItemDepth, NULL, 0, PALETTE_NONE );
+        colorModelDispatcher <void> putDispatch( dstRasterFormat, ps2ColorOrder, dstItemDepth, NULL, 0, PALETTE_NONE );
+
 		for ( uint32 row = 0; row < mipHeight; row++ )
         {
             const void *srcRow = getConstTexelDataRow( srcTexelData, srcRowSize, row );
@@ -156,7 +190,7 @@ inline void convertTexelsToPS2(
 		        // fix alpha
                 if (fixAlpha)
                 {
-                    uint8 newAlpha = convertPCAlpha2PS2Alpha(alpha);
+                    uint8 newAlpha = ps2AlphaFromPCAlphaTable[alpha];
 
 #ifdef DEBUG_ALPHA_LEVELS
                     assert(convertPS2Alpha2PCAlpha(newAlpha) == alpha);
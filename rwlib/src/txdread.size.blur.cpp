@@ -13,6 +13,7 @@ struct resizeFilterBlurPlugin : public rasterResizeFilterInterface
         capsOut.supportsMinification = true;
         capsOut.magnify2D = false;
         capsOut.minify2D = true;
+        capsOut.separable = false;
     }
 
     void MagnifyFiltering(
@@ -117,6 +118,11 @@ struct resizeFilterBlurPlugin : public rasterResizeFilterInterface
         }
     }
 
+    void GetSeparableKernel( separableResizeKernel& kernelOut ) const override
+    {
+        throw RwException( "blur filter plugin does not support separable filtering" );
+    }
+
     inline void Initialize( EngineInterface *engineInterface )
     {
         RegisterResizeFiltering( engineInterface, "blur", this );
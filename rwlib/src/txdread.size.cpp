@@ -396,6 +396,7 @@ void Raster::getSize(uint32& width, uint32& height) const
 // Filtering plugins.
 extern void registerRasterSizeBlurPlugin( void );
 extern void registerRasterResizeLinearPlugin( void );
+extern void registerRasterResizeSeparablePlugins( void );
 
 void registerResizeFilteringEnvironment( void )
 {
@@ -404,6 +405,7 @@ void registerResizeFilteringEnvironment( void )
     // TODO: register all filtering plugins.
     registerRasterSizeBlurPlugin();
     registerRasterResizeLinearPlugin();
+    registerRasterResizeSeparablePlugins();
 }
 
 };
\ No newline at end of file
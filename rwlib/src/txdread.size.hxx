@@ -24,6 +24,17 @@ struct resizeFilteringCaps
 
     bool magnify2D;
     bool minify2D;
+
+    bool separable;     // provides a kernel for whole-row filtering in both directions
+};
+
+// Filter kernel of a separable resize filter.
+// The weight function is evaluated at the distance to the sample center, measured in
+// destination texels when minifying and in source texels when magnifying.
+struct separableResizeKernel
+{
+    double support;                     // weights are zero beyond this distance
+    double (*evaluate)( double dist );
 };
 
 struct resizeColorPipeline abstract
@@ -46,6 +57,9 @@ struct rasterResizeFilterInterface abstract
         const resizeColorPipeline& srcBmp, uint32 minX, uint32 minY, uint32 minScaleX, uint32 minScaleY,
         abstractColorItem& reducedColor
     ) const = 0;
+
+    // Only called if the separable capability is set.
+    virtual void GetSeparableKernel( separableResizeKernel& kernelOut ) const = 0;
 };
 
 // Resize filtering plugin, used to store filtering plugions.
@@ -762,6 +776,18 @@ AINLINE void performMagnifyFiltering2D(
     );
 }
 
+// Resizes by filtering whole rows with separable kernels (see txdread.size.separable.cpp).
+// Pass NULL as kernel for an axis that keeps its size.
+void PerformSeparableResizeFiltering(
+    EngineInterface *engineInterface,
+    uint32 srcWidth, uint32 srcHeight, const void *srcTexels,
+    eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder,
+    ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    uint32 dstWidth, uint32 dstHeight, void *dstTexels,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder,
+    const separableResizeKernel *horiKernel, const separableResizeKernel *vertKernel
+);
+
 AINLINE void PerformRawBitmapResizeFiltering(
     EngineInterface *engineInterface,
     uint32 rawOrigLayerWidth, uint32 rawOrigLayerHeight, void *rawOrigTexels,
@@ -798,7 +824,112 @@ AINLINE void PerformRawBitmapResizeFiltering(
 
         bool hasDoneOptimizedFiltering = false;
 
-        if ( horiSampling == eSamplingType::DOWNSAMPLING && vertSampling == eSamplingType::DOWNSAMPLING )
+        // If every axis that changes size is handled by a separable filter, we do not have to go through
+        // the color pipelines texel by texel.
+        bool isHoriSeparable = false;
+        bool isVertSeparable = false;
+
+        separableResizeKernel horiKernel, vertKernel;
+
+        if ( horiSampling != eSamplingType::SAME )
+        {
+            bool isUpscaling = ( horiSampling == eSamplingType::UPSCALING );
+
+            if ( ( isUpscaling ? upscaleCaps : downsamplingCaps ).separable )
+            {
+                ( isUpscaling ? upscaleFilter : downsamplingFilter )->GetSeparableKernel( horiKernel );
+
+                isHoriSeparable = true;
+            }
+        }
+
+        if ( vertSampling != eSamplingType::SAME )
+        {
+            bool isUpscaling = ( vertSampling == eSamplingType::UPSCALING );
+
+            if ( ( isUpscaling ? upscaleCaps : downsamplingCaps ).separable )
+            {
+                ( isUpscaling ? upscaleFilter : downsamplingFilter )->GetSeparableKernel( vertKernel );
+
+                isVertSeparable = true;
+            }
+        }
+
+        bool canFilterSeparable =
+            ( horiSampling == eSamplingType::SAME || isHoriSeparable ) &&
+            ( vertSampling == eSamplingType::SAME || isVertSeparable );
+
+        if ( canFilterSeparable )
+        {
+            PerformSeparableResizeFiltering(
+                engineInterface,
+                rawOrigLayerWidth, rawOrigLayerHeight, rawOrigTexels,
+                rasterFormat, itemDepth, rowAlignment, colorOrder,
+                paletteType, paletteData, paletteSize,
+                targetLayerWidth, targetLayerHeight, transMipData,
+                rasterFormat, sampleDepth, rowAlignment, colorOrder,
+                ( horiSampling != eSamplingType::SAME ) ? &horiKernel : NULL,
+                ( vertSampling != eSamplingType::SAME ) ? &vertKernel : NULL
+            );
+
+            hasDoneOptimizedFiltering = true;
+        }
+        else if ( isHoriSeparable || isVertSeparable )
+        {
+            // One axis is upscaled and the other one is downsampled, and only one of the two filters is separable.
+            // Separable filters cannot filter texel by texel, so we resize their axis first and leave the
+            // other axis to the texel filter.
+            uint32 sepLayerWidth = ( isHoriSeparable ? targetLayerWidth : rawOrigLayerWidth );
+            uint32 sepLayerHeight = ( isVertSeparable ? targetLayerHeight : rawOrigLayerHeight );
+
+            uint32 sepRowSize = getRasterDataRowSize( sepLayerWidth, sampleDepth, rowAlignment );
+
+            uint32 sepDataSize = getRasterDataSizeByRowSize( sepRowSize, sepLayerHeight );
+
+            void *sepTexels = engineInterface->PixelAllocate( sepDataSize );
+
+            if ( !sepTexels )
+            {
+                throw RwException( "failed to allocate temporary filtering transformation buffer for resizing" );
+            }
+
+            try
+            {
+                PerformSeparableResizeFiltering(
+                    engineInterface,
+                    rawOrigLayerWidth, rawOrigLayerHeight, rawOrigTexels,
+                    rasterFormat, itemDepth, rowAlignment, colorOrder,
+                    paletteType, paletteData, paletteSize,
+                    sepLayerWidth, sepLayerHeight, sepTexels,
+                    rasterFormat, sampleDepth, rowAlignment, colorOrder,
+                    ( isHoriSeparable ? &horiKernel : NULL ),
+                    ( isVertSeparable ? &vertKernel : NULL )
+                );
+
+                performFiltering1D(
+                    engineInterface, dstColorPipe,
+                    transMipData, sampleDepth,
+                    targetLayerWidth, targetLayerHeight,
+                    sepLayerWidth, sepLayerHeight, sepTexels,
+                    rasterFormat, colorOrder, sampleDepth, rowAlignment,
+                    PALETTE_NONE, NULL, 0,
+                    ( isHoriSeparable ? eSamplingType::SAME : horiSampling ),
+                    ( isVertSeparable ? eSamplingType::SAME : vertSampling ),
+                    upscaleFilter, downsamplingFilter
+                );
+            }
+            catch( ... )
+            {
+                engineInterface->PixelFree( sepTexels );
+
+                throw;
+            }
+
+            engineInterface->PixelFree( sepTexels );
+
+            hasDoneOptimizedFiltering = true;
+        }
+        else if ( horiSampling == eSamplingType::DOWNSAMPLING && vertSampling == eSamplingType::DOWNSAMPLING )
         {
             // Check for support first.
             if ( downsamplingCaps.minify2D )
@@ -111,6 +111,7 @@ struct resizeFilterLinearPlugin : public rasterResizeFilterInterface
         capsOut.supportsMinification = false;
         capsOut.magnify2D = false;
         capsOut.minify2D = false;
+        capsOut.separable = false;
     }
 
     AINLINE static void linearFilterBetweenPixels(
@@ -222,6 +223,11 @@ struct resizeFilterLinearPlugin : public rasterResizeFilterInterface
         throw RwException( "linear filter plugin does not support minification" );
     }
 
+    void GetSeparableKernel( separableResizeKernel& kernelOut ) const override
+    {
+        throw RwException( "linear filter plugin does not support separable filtering" );
+    }
+
     inline void Initialize( EngineInterface *engineInterface )
     {
         RegisterResizeFiltering( engineInterface, "linear", this );
@@ -0,0 +1,517 @@
+#include "StdInc.h"
+
+#include "txdread.size.hxx"
+
+#include "rwsimd.hxx"
+
+#include "rwmem.hxx"
+
+namespace rw
+{
+
+// Separable resize filters.
+// Instead of asking the filter plugin for every destination texel, the texels are resampled row by row:
+// every source row is filtered horizontally into a float RGBA working row and the destination rows are
+// weighted sums of those. Only as many working rows are kept as the vertical filter has taps.
+
+static double filterKernelBox( double dist )
+{
+    return ( dist >= -0.5 && dist < 0.5 ) ? 1.0 : 0.0;
+}
+
+static double filterKernelBilinear( double dist )
+{
+    dist = fabs( dist );
+
+    return ( dist < 1.0 ) ? ( 1.0 - dist ) : 0.0;
+}
+
+static inline double sinc( double x )
+{
+    if ( x == 0.0 )
+        return 1.0;
+
+    x *= 3.14159265358979323846;
+
+    return ( sin( x ) / x );
+}
+
+static double filterKernelLanczos3( double dist )
+{
+    dist = fabs( dist );
+
+    return ( dist < 3.0 ) ? ( sinc( dist ) * sinc( dist / 3.0 ) ) : 0.0;
+}
+
+static double filterKernelMitchell( double dist )
+{
+    // Mitchell-Netravali with B = C = 1/3.
+    const double B = ( 1.0 / 3.0 );
+    const double C = ( 1.0 / 3.0 );
+
+    dist = fabs( dist );
+
+    double dist2 = ( dist * dist );
+    double dist3 = ( dist2 * dist );
+
+    if ( dist < 1.0 )
+    {
+        return ( ( 12 - 9 * B - 6 * C ) * dist3 + ( -18 + 12 * B + 6 * C ) * dist2 + ( 6 - 2 * B ) ) / 6.0;
+    }
+    else if ( dist < 2.0 )
+    {
+        return ( ( -B - 6 * C ) * dist3 + ( 6 * B + 30 * C ) * dist2 + ( -12 * B - 48 * C ) * dist + ( 8 * B + 24 * C ) ) / 6.0;
+    }
+
+    return 0.0;
+}
+
+// Weights of the source texels for every destination texel along one axis.
+struct resizeContributions
+{
+    inline resizeContributions( uint32 srcCount, uint32 dstCount, const separableResizeKernel *kernel )
+    {
+        this->firstTap.resize( dstCount );
+        this->tapCount.resize( dstCount );
+
+        if ( kernel == NULL )
+        {
+            // Keeps the size, so every texel maps onto itself.
+            assert( srcCount == dstCount );
+
+            this->maxTaps = 1;
+            this->weights.resize( dstCount, 1.0f );
+
+            for ( uint32 n = 0; n < dstCount; n++ )
+            {
+                this->firstTap[ n ] = n;
+                this->tapCount[ n ] = 1;
+            }
+
+            return;
+        }
+
+        double scale = ( (double)srcCount / (double)dstCount );
+
+        // When minifying, the kernel is stretched over the source texels.
+        double filterScale = std::max( scale, 1.0 );
+        double radius = ( kernel->support * filterScale );
+
+        // The window of a texel spans at most this many source texels.
+        this->maxTaps = std::min( (uint32)ceil( radius * 2.0 ) + 2, srcCount );
+
+        this->weights.resize( (size_t)dstCount * this->maxTaps, 0.0f );
+
+        std::vector <double> tapWeights( this->maxTaps );
+
+        for ( uint32 n = 0; n < dstCount; n++ )
+        {
+            double center = ( ( (double)n + 0.5 ) * scale );
+
+            int32 lowest = (int32)floor( center - radius );
+            int32 highest = (int32)ceil( center + radius );
+
+            // Texels outside of the surface repeat the border texels.
+            int32 first = (int32)srcCount;
+            int32 last = -1;
+
+            for ( int32 srcIter = lowest; srcIter <= highest; srcIter++ )
+            {
+                double weight = kernel->evaluate( ( (double)srcIter + 0.5 - center ) / filterScale );
+
+                if ( weight == 0 )
+                    continue;
+
+                int32 clampedIter = std::min( std::max( srcIter, 0 ), (int32)srcCount - 1 );
+
+                first = std::min( first, clampedIter );
+                last = std::max( last, clampedIter );
+            }
+
+            std::fill( tapWeights.begin(), tapWeights.end(), 0.0 );
+
+            double weightSum = 0;
+
+            uint32 count = 0;
+
+            if ( last >= first )
+            {
+                count = (uint32)( last - first + 1 );
+
+                assert( count <= this->maxTaps );
+
+                for ( int32 srcIter = lowest; srcIter <= highest; srcIter++ )
+                {
+                    double weight = kernel->evaluate( ( (double)srcIter + 0.5 - center ) / filterScale );
+
+                    if ( weight == 0 )
+                        continue;
+
+                    int32 clampedIter = std::min( std::max( srcIter, 0 ), (int32)srcCount - 1 );
+
+                    tapWeights[ clampedIter - first ] += weight;
+
+                    weightSum += weight;
+                }
+            }
+
+            if ( weightSum == 0 )
+            {
+                // Kernel fell between the texels; take the nearest one.
+                uint32 nearest = std::min( (uint32)center, srcCount - 1 );
+
+                first = (int32)nearest;
+                count = 1;
+
+                tapWeights[ 0 ] = 1.0;
+                weightSum = 1.0;
+            }
+
+            float *outWeights = &this->weights[ (size_t)n * this->maxTaps ];
+
+            for ( uint32 tap = 0; tap < count; tap++ )
+            {
+                outWeights[ tap ] = (float)( tapWeights[ tap ] / weightSum );
+            }
+
+            this->firstTap[ n ] = (uint32)first;
+            this->tapCount[ n ] = count;
+        }
+    }
+
+    uint32 maxTaps;
+
+    std::vector <uint32> firstTap;
+    std::vector <uint32> tapCount;
+    std::vector <float> weights;        // maxTaps entries for every destination texel
+};
+
+// Working rows are float RGBA.
+static void unpackRowToWorking( const uint8 *srcColors, float *workRow, uint32 texelCount )
+{
+    uint32 n = 0;
+
+#ifdef RWLIB_SIMD_SSE2
+    __m128i zero = _mm_setzero_si128();
+
+    for ( ; n < texelCount; n++ )
+    {
+        int32 packedColor;
+        memcpy( &packedColor, srcColors + n * 4, sizeof( packedColor ) );
+
+        __m128i comps = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( packedColor ), zero ), zero );
+
+        _mm_storeu_ps( workRow + n * 4, _mm_cvtepi32_ps( comps ) );
+    }
+
+    n *= 4;
+#endif //RWLIB_SIMD_SSE2
+
+    for ( ; n < texelCount * 4; n++ )
+    {
+        workRow[ n ] = (float)srcColors[ n ];
+    }
+}
+
+static void packWorkingToRow( const float *workRow, uint8 *dstColors, uint32 texelCount )
+{
+    uint32 n = 0;
+
+#ifdef RWLIB_SIMD_SSE2
+    // The saturating packs clamp to the color range for us.
+    for ( ; n + 4 <= texelCount; n += 4 )
+    {
+        __m128i texel0 = _mm_cvtps_epi32( _mm_loadu_ps( workRow + n * 4 ) );
+        __m128i texel1 = _mm_cvtps_epi32( _mm_loadu_ps( workRow + n * 4 + 4 ) );
+        __m128i texel2 = _mm_cvtps_epi32( _mm_loadu_ps( workRow + n * 4 + 8 ) );
+        __m128i texel3 = _mm_cvtps_epi32( _mm_loadu_ps( workRow + n * 4 + 12 ) );
+
+        __m128i packed = _mm_packus_epi16( _mm_packs_epi32( texel0, texel1 ), _mm_packs_epi32( texel2, texel3 ) );
+
+        _mm_storeu_si128( (__m128i*)( dstColors + n * 4 ), packed );
+    }
+
+    n *= 4;
+#endif //RWLIB_SIMD_SSE2
+
+    for ( ; n < texelCount * 4; n++ )
+    {
+        float val = workRow[ n ];
+
+        dstColors[ n ] = (uint8)std::min( std::max( val + 0.5f, 0.0f ), 255.0f );
+    }
+}
+
+static void filterWorkingRowHorizontal( const float *srcRow, float *dstRow, const resizeContributions& contrib, uint32 dstWidth )
+{
+    uint32 maxTaps = contrib.maxTaps;
+
+    for ( uint32 x = 0; x < dstWidth; x++ )
+    {
+        const float *weights = &contrib.weights[ (size_t)x * maxTaps ];
+        const float *srcTexels = ( srcRow + contrib.firstTap[ x ] * 4 );
+
+        uint32 tapCount = contrib.tapCount[ x ];
+
+#ifdef RWLIB_SIMD_SSE2
+        __m128 accum = _mm_setzero_ps();
+
+        for ( uint32 tap = 0; tap < tapCount; tap++ )
+        {
+            accum = _mm_add_ps( accum, _mm_mul_ps( _mm_set1_ps( weights[ tap ] ), _mm_loadu_ps( srcTexels + tap * 4 ) ) );
+        }
+
+        _mm_storeu_ps( dstRow + x * 4, accum );
+#else
+        float accum[4] = { 0, 0, 0, 0 };
+
+        for ( uint32 tap = 0; tap < tapCount; tap++ )
+        {
+            float weight = weights[ tap ];
+
+            accum[0] += weight * srcTexels[ tap * 4 + 0 ];
+            accum[1] += weight * srcTexels[ tap * 4 + 1 ];
+            accum[2] += weight * srcTexels[ tap * 4 + 2 ];
+            accum[3] += weight * srcTexels[ tap * 4 + 3 ];
+        }
+
+        dstRow[ x * 4 + 0 ] = accum[0];
+        dstRow[ x * 4 + 1 ] = accum[1];
+        dstRow[ x * 4 + 2 ] = accum[2];
+        dstRow[ x * 4 + 3 ] = accum[3];
+#endif //RWLIB_SIMD_SSE2
+    }
+}
+
+static void accumulateWorkingRow( float *accumRow, const float *srcRow, float weight, uint32 compCount )
+{
+    uint32 n = 0;
+
+#ifdef RWLIB_SIMD_SSE2
+    __m128 weightVec = _mm_set1_ps( weight );
+
+    for ( ; n + 8 <= compCount; n += 8 )
+    {
+        __m128 accum0 = _mm_add_ps( _mm_loadu_ps( accumRow + n ), _mm_mul_ps( weightVec, _mm_loadu_ps( srcRow + n ) ) );
+        __m128 accum1 = _mm_add_ps( _mm_loadu_ps( accumRow + n + 4 ), _mm_mul_ps( weightVec, _mm_loadu_ps( srcRow + n + 4 ) ) );
+
+        _mm_storeu_ps( accumRow + n, accum0 );
+        _mm_storeu_ps( accumRow + n + 4, accum1 );
+    }
+#endif //RWLIB_SIMD_SSE2
+
+    for ( ; n < compCount; n++ )
+    {
+        accumRow[ n ] += weight * srcRow[ n ];
+    }
+}
+
+void PerformSeparableResizeFiltering(
+    EngineInterface *engineInterface,
+    uint32 srcWidth, uint32 srcHeight, const void *srcTexels,
+    eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder,
+    ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    uint32 dstWidth, uint32 dstHeight, void *dstTexels,
+    eRasterFormat dstRasterFormat, uint32 dstDepth, uint32 dstRowAlignment, eColorOrdering dstColorOrder,
+    const separableResizeKernel *horiKernel, const separableResizeKernel *vertKernel
+)
+{
+    if ( srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0 )
+    {
+        throw RwException( "invalid surface dimensions for separable resize filtering" );
+    }
+
+    resizeContributions horiContrib( srcWidth, dstWidth, horiKernel );
+    resizeContributions vertContrib( srcHeight, dstHeight, vertKernel );
+
+    uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, srcRowAlignment );
+    uint32 dstRowSize = getRasterDataRowSize( dstWidth, dstDepth, dstRowAlignment );
+
+    // Colors travel as RGBA8888 between the surfaces and the working rows.
+    // Use the specialized row kernels if possible.
+    texelRowKernel_t fetchKernel = NULL;
+
+    if ( srcPaletteType == PALETTE_NONE )
+    {
+        fetchKernel = GetTexelRowKernel( srcRasterFormat, srcDepth, srcColorOrder, RASTER_8888, 32, COLOR_RGBA );
+    }
+
+    texelRowKernel_t putKernel = GetTexelRowKernel( RASTER_8888, 32, COLOR_RGBA, dstRasterFormat, dstDepth, dstColorOrder );
+
+    colorModelDispatcher <const void> fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
+    colorModelDispatcher <void> putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
+
+    rwScratchArena scratch( engineInterface );
+
+    uint32 maxRowTexels = std::max( srcWidth, dstWidth );
+
+    uint8 *colorRow = (uint8*)scratch.Allocate( maxRowTexels * 4 );
+    float *srcWorkRow = (float*)scratch.Allocate( srcWidth * 4 * sizeof( float ) );
+    float *accumRow = (float*)scratch.Allocate( dstWidth * 4 * sizeof( float ) );
+
+    // Ring of horizontally filtered source rows.
+    uint32 ringSize = vertContrib.maxTaps;
+
+    float *ringRows = (float*)scratch.Allocate( (size_t)ringSize * dstWidth * 4 * sizeof( float ) );
+
+    std::vector <uint32> ringRowIndex( ringSize, 0xFFFFFFFF );
+
+    for ( uint32 dstY = 0; dstY < dstHeight; dstY++ )
+    {
+        uint32 firstRow = vertContrib.firstTap[ dstY ];
+        uint32 rowCount = vertContrib.tapCount[ dstY ];
+
+        const float *rowWeights = &vertContrib.weights[ (size_t)dstY * ringSize ];
+
+        memset( accumRow, 0, dstWidth * 4 * sizeof( float ) );
+
+        for ( uint32 tap = 0; tap < rowCount; tap++ )
+        {
+            uint32 srcY = ( firstRow + tap );
+
+            uint32 ringSlot = ( srcY % ringSize );
+
+            float *workRow = ( ringRows + (size_t)ringSlot * dstWidth * 4 );
+
+            if ( ringRowIndex[ ringSlot ] != srcY )
+            {
+                // Fetch and filter this source row.
+                const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, srcY );
+
+                if ( fetchKernel )
+                {
+                    fetchKernel( srcRow, colorRow, 0, 0, srcWidth );
+                }
+                else
+                {
+                    for ( uint32 x = 0; x < srcWidth; x++ )
+                    {
+                        uint8 *color = ( colorRow + x * 4 );
+
+                        if ( !fetchDispatch.getRGBA( srcRow, x, color[0], color[1], color[2], color[3] ) )
+                        {
+                            color[0] = 0;
+                            color[1] = 0;
+                            color[2] = 0;
+                            color[3] = 0;
+                        }
+                    }
+                }
+
+                unpackRowToWorking( colorRow, srcWorkRow, srcWidth );
+
+                filterWorkingRowHorizontal( srcWorkRow, workRow, horiContrib, dstWidth );
+
+                ringRowIndex[ ringSlot ] = srcY;
+            }
+
+            accumulateWorkingRow( accumRow, workRow, rowWeights[ tap ], dstWidth * 4 );
+        }
+
+        // Store the destination row.
+        packWorkingToRow( accumRow, colorRow, dstWidth );
+
+        void *dstRow = getTexelDataRow( dstTexels, dstRowSize, dstY );
+
+        if ( putKernel )
+        {
+            putKernel( colorRow, dstRow, 0, 0, dstWidth );
+        }
+        else
+        {
+            for ( uint32 x = 0; x < dstWidth; x++ )
+            {
+                const uint8 *color = ( colorRow + x * 4 );
+
+                putDispatch.setRGBA( dstRow, x, color[0], color[1], color[2], color[3] );
+            }
+        }
+    }
+}
+
+// Filter plugin that hands out a kernel for the separable filtering path.
+struct resizeFilterSeparablePlugin : public rasterResizeFilterInterface
+{
+    inline resizeFilterSeparablePlugin( const char *filterName, double support, double (*evaluate)( double dist ) )
+    {
+        this->filterName = filterName;
+
+        this->kernel.support = support;
+        this->kernel.evaluate = evaluate;
+    }
+
+    void GetSupportedFiltering( resizeFilteringCaps& capsOut ) const override
+    {
+        capsOut.supportsMagnification = true;
+        capsOut.supportsMinification = true;
+        capsOut.magnify2D = false;
+        capsOut.minify2D = false;
+        capsOut.separable = true;
+    }
+
+    void MagnifyFiltering(
+        const resizeColorPipeline& srcBmp, uint32 magX, uint32 magY, uint32 magScaleX, uint32 magScaleY,
+        resizeColorPipeline& dstBmp, uint32 dstX, uint32 dstY
+    ) const override
+    {
+        throw RwException( "separable filter plugins do not support per-texel magnification" );
+    }
+
+    void MinifyFiltering(
+        const resizeColorPipeline& srcBmp, uint32 minX, uint32 minY, uint32 minScaleX, uint32 minScaleY,
+        abstractColorItem& reducedColor
+    ) const override
+    {
+        throw RwException( "separable filter plugins do not support per-texel minification" );
+    }
+
+    void GetSeparableKernel( separableResizeKernel& kernelOut ) const override
+    {
+        kernelOut = this->kernel;
+    }
+
+    const char *filterName;
+    separableResizeKernel kernel;
+};
+
+struct resizeFilterSeparablePluginEnv
+{
+    inline resizeFilterSeparablePluginEnv( void )
+        : boxFilter( "box", 0.5, filterKernelBox ),
+          bilinearFilter( "bilinear", 1.0, filterKernelBilinear ),
+          lanczos3Filter( "lanczos3", 3.0, filterKernelLanczos3 ),
+          mitchellFilter( "mitchell", 2.0, filterKernelMitchell )
+    {
+        return;
+    }
+
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        RegisterResizeFiltering( engineInterface, boxFilter.filterName, &boxFilter );
+        RegisterResizeFiltering( engineInterface, bilinearFilter.filterName, &bilinearFilter );
+        RegisterResizeFiltering( engineInterface, lanczos3Filter.filterName, &lanczos3Filter );
+        RegisterResizeFiltering( engineInterface, mitchellFilter.filterName, &mitchellFilter );
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        UnregisterResizeFiltering( engineInterface, &mitchellFilter );
+        UnregisterResizeFiltering( engineInterface, &lanczos3Filter );
+        UnregisterResizeFiltering( engineInterface, &bilinearFilter );
+        UnregisterResizeFiltering( engineInterface, &boxFilter );
+    }
+
+    resizeFilterSeparablePlugin boxFilter;
+    resizeFilterSeparablePlugin bilinearFilter;
+    resizeFilterSeparablePlugin lanczos3Filter;
+    resizeFilterSeparablePlugin mitchellFilter;
+};
+
+static PluginDependantStructRegister <resizeFilterSeparablePluginEnv, RwInterfaceFactory_t> resizeFilterSeparablePluginRegister;
+
+void registerRasterResizeSeparablePlugins( void )
+{
+    resizeFilterSeparablePluginRegister.RegisterPlugin( engineFactory );
+}
+
+};
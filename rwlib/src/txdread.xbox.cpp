@@ -16,6 +16,8 @@
 
 #include "txdread.miputil.hxx"
 
+#include "rwparallel.hxx"
+
 namespace rw
 {
 
@@ -452,58 +454,21 @@ inline bool isXBOXTextureSwizzled( const NativeTextureXBOX *nativeTex )
     return ( nativeTex->dxtCompression == 0 );
 }
 
-void xboxNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInterface, void *objMem, pixelDataTraversal& pixelsOut )
+// Puts the mipmap layers of a XBOX texture into pixel storage, one task per layer.
+struct xboxMipmapLayerFetcher
 {
-    // Cast to our native format.
-    NativeTextureXBOX *platformTex = (NativeTextureXBOX*)objMem;
-
-    // We need to find out how to store the texels into the traversal containers.
-    // If we store compressed image data, we can give the data directly to the runtime.
-    eCompressionType rwCompressionType = getDXTCompressionTypeFromXBOX( platformTex->dxtCompression );
+    Interface *engineInterface;
 
-    uint32 srcDepth = platformTex->depth;
+    const NativeTextureXBOX *platformTex;
 
-    eRasterFormat dstRasterFormat = platformTex->rasterFormat;
-    uint32 dstDepth = platformTex->depth;
+    bool isSwizzledFormat;
+    uint32 srcDepth;
 
-    bool hasAlpha = platformTex->hasAlpha;
-
-    bool isSwizzledFormat = isXBOXTextureSwizzled( platformTex );
+    pixelDataTraversal *pixelsOut;
 
-    bool canHavePalette = false;
-
-    if ( rwCompressionType == RWCOMPRESS_DXT1 ||
-         rwCompressionType == RWCOMPRESS_DXT2 ||
-         rwCompressionType == RWCOMPRESS_DXT3 ||
-         rwCompressionType == RWCOMPRESS_DXT4 ||
-         rwCompressionType == RWCOMPRESS_DXT5 )
+    void operator () ( size_t n ) const
     {
-        dstRasterFormat = getVirtualRasterFormat( hasAlpha, rwCompressionType );
-
-        dstDepth = Bitmap::getRasterFormatDepth( dstRasterFormat );
-    }
-    else if ( rwCompressionType == RWCOMPRESS_NONE )
-    {
-        // We can have a palette.
-        canHavePalette = true;
-    }
-    else
-    {
-        throw RwException( "invalid compression type in XBOX texture native pixel fetch" );
-    }
-
-    // If we are swizzled, then we have to create a new copy of the texels which is in linear format.
-    // Otherwise we can optimize.
-    bool isNewlyAllocated = ( isSwizzledFormat == true );
-
-    size_t mipmapCount = platformTex->mipmaps.size();
-
-    // Allocate virtual mipmaps.
-    pixelsOut.mipmaps.resize( mipmapCount );
-
-    for ( size_t n = 0; n < mipmapCount; n++ )
-    {
-        const NativeTextureXBOX::mipmapLayer& mipLayer = platformTex->mipmaps[ n ];
+        const NativeTextureXBOX::mipmapLayer& mipLayer = this->platformTex->mipmaps[ n ];
 
         // Fetch all mipmap data onto the stack.
         uint32 mipWidth = mipLayer.width;
@@ -515,7 +480,7 @@ void xboxNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineIn
         void *dstTexels = NULL;
         uint32 dstDataSize = 0;
 
-        if ( isSwizzledFormat == false )
+        if ( this->isSwizzledFormat == false )
         {
             // We can simply move things over.
             dstTexels = mipLayer.texels;
@@ -528,12 +493,12 @@ void xboxNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineIn
 
             swizzleTrav.mipWidth = mipWidth;
             swizzleTrav.mipHeight = mipHeight;
-            swizzleTrav.depth = srcDepth;
+            swizzleTrav.depth = this->srcDepth;
             swizzleTrav.rowAlignment = getXBOXTextureDataRowAlignment();
             swizzleTrav.texels = mipLayer.texels;
             swizzleTrav.dataSize = mipLayer.dataSize;
 
-            NativeTextureXBOX::unswizzleMipmap( engineInterface, swizzleTrav );
+            NativeTextureXBOX::unswizzleMipmap( this->engineInterface, swizzleTrav );
 
             assert( swizzleTrav.newtexels != swizzleTrav.texels );
 
@@ -556,7 +521,77 @@ void xboxNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineIn
         newLayer.dataSize = dstDataSize;
 
         // Store this layer.
-        pixelsOut.mipmaps[ n ] = newLayer;
+        this->pixelsOut->mipmaps[ n ] = newLayer;
+    }
+};
+
+void xboxNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInterface, void *objMem, pixelDataTraversal& pixelsOut )
+{
+    // Cast to our native format.
+    NativeTextureXBOX *platformTex = (NativeTextureXBOX*)objMem;
+
+    // We need to find out how to store the texels into the traversal containers.
+    // If we store compressed image data, we can give the data directly to the runtime.
+    eCompressionType rwCompressionType = getDXTCompressionTypeFromXBOX( platformTex->dxtCompression );
+
+    uint32 srcDepth = platformTex->depth;
+
+    eRasterFormat dstRasterFormat = platformTex->rasterFormat;
+    uint32 dstDepth = platformTex->depth;
+
+    bool hasAlpha = platformTex->hasAlpha;
+
+    bool isSwizzledFormat = isXBOXTextureSwizzled( platformTex );
+
+    bool canHavePalette = false;
+
+    if ( rwCompressionType == RWCOMPRESS_DXT1 ||
+         rwCompressionType == RWCOMPRESS_DXT2 ||
+         rwCompressionType == RWCOMPRESS_DXT3 ||
+         rwCompressionType == RWCOMPRESS_DXT4 ||
+         rwCompressionType == RWCOMPRESS_DXT5 )
+    {
+        dstRasterFormat = getVirtualRasterFormat( hasAlpha, rwCompressionType );
+
+        dstDepth = Bitmap::getRasterFormatDepth( dstRasterFormat );
+    }
+    else if ( rwCompressionType == RWCOMPRESS_NONE )
+    {
+        // We can have a palette.
+        canHavePalette = true;
+    }
+    else
+    {
+        throw RwException( "invalid compression type in XBOX texture native pixel fetch" );
+    }
+
+    // If we are swizzled, then we have to create a new copy of the texels which is in linear format.
+    // Otherwise we can optimize.
+    bool isNewlyAllocated = ( isSwizzledFormat == true );
+
+    size_t mipmapCount = platformTex->mipmaps.size();
+
+    // Allocate virtual mipmaps.
+    pixelsOut.mipmaps.resize( mipmapCount );
+
+    xboxMipmapLayerFetcher fetcher;
+    fetcher.engineInterface = engineInterface;
+    fetcher.platformTex = platformTex;
+    fetcher.isSwizzledFormat = isSwizzledFormat;
+    fetcher.srcDepth = srcDepth;
+    fetcher.pixelsOut = &pixelsOut;
+
+    // Unswizzling is worth spreading across the workers, if the texture is big.
+    if ( isSwizzledFormat && mipmapCount > 1 && ShouldProcessTexelsInParallel( engineInterface, GetMipmapLayersTexelCount( platformTex->mipmaps ) ) )
+    {
+        ParallelForEach( engineInterface, mipmapCount, fetcher );
+    }
+    else
+    {
+        for ( size_t n = 0; n < mipmapCount; n++ )
+        {
+            fetcher( n );
+        }
     }
 
     // If we can have a palette, copy it over.
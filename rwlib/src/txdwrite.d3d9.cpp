@@ -56,6 +56,8 @@ void d3d9NativeTextureTypeProvider::SerializeTexture( TextureBase *theTexture, P
 
     NativeTextureD3D9 *platformTex = (NativeTextureD3D9*)nativeTex;
 
+    platformTex->materializeTexels();
+
     // Make sure the texture has some qualities before it can even be written.
     ePaletteType paletteType = platformTex->paletteType;
 
@@ -160,6 +162,8 @@ void d3d9NativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineIn
     // Cast to our native texture type.
     NativeTextureD3D9 *platformTex = (NativeTextureD3D9*)objMem;
 
+    platformTex->materializeTexels();
+
     // The pixel capabilities system has been mainly designed around PC texture optimization.
     // This means that we should be able to directly copy the Direct3D surface data into pixelsOut.
     // If not, we need to adjust, make a new library version.
@@ -587,6 +591,7 @@ void d3d9NativeTextureTypeProvider::UnsetPixelDataFromTexture( Interface *engine
 
     // Unset the pixels.
     nativeTex->mipmaps.clear();
+    nativeTex->lazyTexels.reset();
 
     nativeTex->palette = NULL;
     nativeTex->paletteType = PALETTE_NONE;
@@ -833,6 +838,8 @@ bool d3d9NativeTextureTypeProvider::GetMipmapLayer( Interface *engineInterface,
 {
     NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
 
+    nativeTex->materializeTexels();
+
     d3d9MipmapManager mipMan( nativeTex );
 
     return
@@ -847,6 +854,8 @@ bool d3d9NativeTextureTypeProvider::AddMipmapLayer( Interface *engineInterface,
 {
     NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
 
+    nativeTex->materializeTexels();
+
     d3d9MipmapManager mipMan( nativeTex );
 
     return
@@ -862,6 +871,9 @@ void d3d9NativeTextureTypeProvider::ClearMipmaps( Interface *engineInterface, vo
     NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
 
     virtualClearMipmaps <NativeTextureD3D9::mipmapLayer> ( engineInterface, nativeTex->mipmaps );
+
+    // The base layer may still be waiting to be loaded.
+    nativeTex->lazyTexels.trim( nativeTex->mipmaps.size() );
 }
 
 void d3d9NativeTextureTypeProvider::GetTextureInfo( Interface *engineInterface, void *objMem, nativeTextureBatchedInfo& infoOut )
@@ -798,7 +798,9 @@ inline bool getDDSMappingFromD3DFormat(
 void d3d9NativeTextureTypeProvider::SerializeNativeImage( Interface *engineInterface, Stream *inputStream, void *objMem ) const
 {
     // Simply write out this native texture's content.
-    const NativeTextureD3D9 *nativeTex = (const NativeTextureD3D9*)objMem;
+    NativeTextureD3D9 *nativeTex = (NativeTextureD3D9*)objMem;
+
+    nativeTex->materializeTexels();
 
     size_t mipmapCount = nativeTex->mipmaps.size();
 
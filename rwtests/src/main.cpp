@@ -0,0 +1,54 @@
+#include <StdInc.h>
+
+#include "main.h"
+
+#include <stdio.h>
+
+struct selfCheck
+{
+    const char *name;
+    void (*run)( void );
+};
+
+static const selfCheck selfChecks[] =
+{
+    { "PS2 GS memory allocator", CheckPS2GSMemoryAllocator },
+    { "PS2 alpha conversion", CheckPS2AlphaConversion }
+};
+
+int main( int argc, char *argv[] )
+{
+    int failedCount = 0;
+
+    for ( const selfCheck& check : selfChecks )
+    {
+        try
+        {
+            check.run();
+
+            printf( "passed: %s\n", check.name );
+        }
+        catch( rw::RwException& except )
+        {
+            printf( "FAILED: %s (%s)\n", check.name, except.message.c_str() );
+
+            failedCount++;
+        }
+    }
+
+    return ( failedCount == 0 ) ? 0 : 1;
+}
+
+// Stubs.
+namespace rw
+{
+    LibraryVersion app_version( void )
+    {
+        return rw::KnownVersions::getGameVersion( rw::KnownVersions::SA );
+    }
+
+    int32 rwmain( Interface *engineInterface )
+    {
+        return -1;
+    }
+};
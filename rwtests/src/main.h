@@ -0,0 +1,5 @@
+// Self-checks of rwlib internals that loading sample files does not cover.
+// Every check throws a rw::RwException if it finds a mismatch.
+
+void CheckPS2GSMemoryAllocator( void );
+void CheckPS2AlphaConversion( void );
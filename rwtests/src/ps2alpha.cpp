@@ -0,0 +1,159 @@
+#include <StdInc.h>
+
+#include "main.h"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+#include "pixelformat.hxx"
+
+#include "txdread.ps2shared.hxx"
+
+#include "txdread.memcodec.hxx"
+
+#include "txdread.ps2shared.enc.hxx"
+
+using namespace rw;
+
+// PS2 texels are converted through lookup tables and SSE2/AVX2 row kernels, but
+// convertPCAlpha2PS2Alpha and convertPS2Alpha2PCAlpha stay the reference. Every alpha value
+// has to come out the same on every path.
+
+typedef uint8 (*alphaConvFunc_t)( uint8 alpha );
+
+struct checkedAlphaRemap
+{
+    const char *name;
+    eTexelAlphaRemap alphaRemap;
+    const uint8 *table;
+    alphaConvFunc_t reference;
+};
+
+static const checkedAlphaRemap checkedRemaps[] =
+{
+    { "PC to PS2", TEXEL_ALPHA_PC_TO_PS2, ps2AlphaFromPCAlphaTable, convertPCAlpha2PS2Alpha },
+    { "PS2 to PC", TEXEL_ALPHA_PS2_TO_PC, pcAlphaFromPS2AlphaTable, convertPS2Alpha2PCAlpha }
+};
+
+static const eColorOrdering checkedColorOrders[] =
+{
+    COLOR_RGBA,
+    COLOR_BGRA,
+    COLOR_ABGR
+};
+
+// Byte positions of the channels of RASTER_8888 texels, same as the row kernels use.
+static void getColorOrderPositions( eColorOrdering colorOrder, uint32& redPos, uint32& greenPos, uint32& bluePos, uint32& alphaPos )
+{
+    if ( colorOrder == COLOR_RGBA )
+    {
+        redPos = 0; greenPos = 1; bluePos = 2; alphaPos = 3;
+    }
+    else if ( colorOrder == COLOR_BGRA )
+    {
+        redPos = 2; greenPos = 1; bluePos = 0; alphaPos = 3;
+    }
+    else
+    {
+        redPos = 3; greenPos = 2; bluePos = 1; alphaPos = 0;
+    }
+}
+
+static void checkAlphaTable( const checkedAlphaRemap& remap )
+{
+    for ( uint32 alpha = 0; alpha < 256; alpha++ )
+    {
+        if ( remap.table[ alpha ] != remap.reference( (uint8)alpha ) )
+        {
+            throw RwException(
+                std::string( remap.name ) + " table differs from the reference at alpha " + std::to_string( alpha )
+            );
+        }
+    }
+}
+
+// Converts a row that holds every alpha value once. The row is fed to the kernel in pieces, so
+// that the scalar loop, SSE2 (8 texels) and AVX2 (16 texels, if the CPU has it) all see every value.
+static void checkAlphaRowKernel( const checkedAlphaRemap& remap, eColorOrdering srcColorOrder, eColorOrdering dstColorOrder )
+{
+    texelRowKernel_t rowKernel =
+        GetAlphaRemapTexelRowKernel(
+            RASTER_8888, 32, srcColorOrder,
+            RASTER_8888, 32, dstColorOrder,
+            remap.alphaRemap
+        );
+
+    if ( rowKernel == NULL )
+    {
+        throw RwException( std::string( remap.name ) + " row kernel is missing" );
+    }
+
+    uint32 srcRed, srcGreen, srcBlue, srcAlpha;
+    uint32 dstRed, dstGreen, dstBlue, dstAlpha;
+
+    getColorOrderPositions( srcColorOrder, srcRed, srcGreen, srcBlue, srcAlpha );
+    getColorOrderPositions( dstColorOrder, dstRed, dstGreen, dstBlue, dstAlpha );
+
+    uint8 srcRow[ 256 * 4 ];
+
+    for ( uint32 n = 0; n < 256; n++ )
+    {
+        uint8 *srcTexel = ( srcRow + n * 4 );
+
+        srcTexel[ srcRed ] = (uint8)( n ^ 0x5A );
+        srcTexel[ srcGreen ] = (uint8)( n * 3 );
+        srcTexel[ srcBlue ] = (uint8)( 255 - n );
+        srcTexel[ srcAlpha ] = (uint8)n;
+    }
+
+    static const uint32 pieceSizes[] = { 1, 7, 8, 16, 256 };
+
+    for ( uint32 pieceSize : pieceSizes )
+    {
+        uint8 dstRow[ 256 * 4 ];
+
+        memset( dstRow, 0, sizeof( dstRow ) );
+
+        for ( uint32 offX = 0; offX < 256; offX += pieceSize )
+        {
+            rowKernel( srcRow, dstRow, offX, offX, std::min( pieceSize, 256 - offX ) );
+        }
+
+        for ( uint32 n = 0; n < 256; n++ )
+        {
+            const uint8 *srcTexel = ( srcRow + n * 4 );
+            const uint8 *dstTexel = ( dstRow + n * 4 );
+
+            bool isSameTexel =
+                ( dstTexel[ dstRed ] == srcTexel[ srcRed ] &&
+                  dstTexel[ dstGreen ] == srcTexel[ srcGreen ] &&
+                  dstTexel[ dstBlue ] == srcTexel[ srcBlue ] &&
+                  dstTexel[ dstAlpha ] == remap.reference( (uint8)n ) );
+
+            if ( !isSameTexel )
+            {
+                throw RwException(
+                    std::string( remap.name ) + " row kernel differs from the reference at alpha " + std::to_string( n ) +
+                    " (piece size " + std::to_string( pieceSize ) + ")"
+                );
+            }
+        }
+    }
+}
+
+void CheckPS2AlphaConversion( void )
+{
+    for ( const checkedAlphaRemap& remap : checkedRemaps )
+    {
+        checkAlphaTable( remap );
+
+        for ( eColorOrdering srcColorOrder : checkedColorOrders )
+        {
+            for ( eColorOrdering dstColorOrder : checkedColorOrders )
+            {
+                checkAlphaRowKernel( remap, srcColorOrder, dstColorOrder );
+            }
+        }
+    }
+}
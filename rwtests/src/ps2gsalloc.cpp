@@ -0,0 +1,192 @@
+#include <StdInc.h>
+
+#include "main.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_PLAYSTATION2
+
+#include "txdread.ps2.hxx"
+
+#include "txdread.ps2gsman.hxx"
+
+#include "txdread.ps2mem.hxx"
+
+#include <string>
+
+using namespace rw;
+
+// The occupancy bitmaps of ps2GSMemoryLayoutManager replaced the rectangle lists of the pages.
+// Both collision tests are still there, so we place random mipmap chains of every memory layout
+// with both and make sure that they agree on every placement.
+
+struct checkedLayout
+{
+    eFormatEncodingType encodingType;
+    eMemoryLayoutType memLayoutType;
+
+    // The CLUT is placed after the mipmaps if this is not zero.
+    uint32 clutWidth, clutHeight;
+};
+
+static const checkedLayout checkedLayouts[] =
+{
+    { FORMAT_TEX32, PSMCT32, 0, 0 },
+    { FORMAT_TEX16, PSMCT16, 0, 0 },
+    { FORMAT_TEX16, PSMCT16S, 0, 0 },
+    { FORMAT_TEX32, PSMZ32, 0, 0 },
+    { FORMAT_TEX16, PSMZ16, 0, 0 },
+    { FORMAT_IDTEX8, PSMT8, 16, 16 },
+    { FORMAT_IDTEX4, PSMT4, 8, 2 }
+};
+
+static const uint32 chainsPerLayout = 200;
+
+struct gsPlacement
+{
+    bool hasAllocated;
+    uint32 basePointer;
+    uint32 memSize;
+    uint32 offX, offY;
+    uint32 bufferWidth;
+};
+
+static void verifySamePlacement( const gsPlacement& placement, const gsPlacement& refPlacement, size_t layoutIndex, uint32 chainIndex )
+{
+    bool isSamePlacement = ( placement.hasAllocated == refPlacement.hasAllocated );
+
+    if ( isSamePlacement && placement.hasAllocated )
+    {
+        isSamePlacement =
+            ( placement.basePointer == refPlacement.basePointer && placement.memSize == refPlacement.memSize &&
+              placement.offX == refPlacement.offX && placement.offY == refPlacement.offY &&
+              placement.bufferWidth == refPlacement.bufferWidth );
+    }
+
+    if ( !isSamePlacement )
+    {
+        throw RwException(
+            "allocator disagrees with the reference allocator (layout " + std::to_string( layoutIndex ) +
+            ", chain " + std::to_string( chainIndex ) + ")"
+        );
+    }
+}
+
+static void checkMipmapChain( const checkedLayout& layout, size_t layoutIndex, uint32 chainIndex, const uint32 mipWidths[], const uint32 mipHeights[], uint32 mipmapCount )
+{
+    ps2GSMemoryLayoutManager::memoryLayoutProperties_t layoutProps;
+
+    ps2GSMemoryLayoutManager::getMemoryLayoutProperties( layout.memLayoutType, layout.encodingType, layoutProps );
+
+    ps2GSMemoryLayoutManager gsMem;
+    ps2GSMemoryLayoutManager refMem;
+
+    refMem.useReferenceCollision = true;
+
+    uint32 maxBufferPageWidth = 0;
+
+    for ( uint32 n = 0; n < mipmapCount; n++ )
+    {
+        uint32 thisPageWidth = ps2GSMemoryLayoutManager::calculateTextureBufferPageWidth( layoutProps, mipWidths[ n ], mipHeights[ n ] );
+
+        if ( maxBufferPageWidth < thisPageWidth )
+        {
+            maxBufferPageWidth = thisPageWidth;
+        }
+    }
+
+    gsMem.SetBufferPageWidth( maxBufferPageWidth );
+    refMem.SetBufferPageWidth( maxBufferPageWidth );
+
+    for ( uint32 n = 0; n < mipmapCount; n++ )
+    {
+        gsPlacement placement, refPlacement;
+
+        placement.hasAllocated = gsMem.allocateTexture(
+            layout.memLayoutType, layoutProps, mipWidths[ n ], mipHeights[ n ],
+            placement.basePointer, placement.memSize, placement.offX, placement.offY, placement.bufferWidth
+        );
+        refPlacement.hasAllocated = refMem.allocateTexture(
+            layout.memLayoutType, layoutProps, mipWidths[ n ], mipHeights[ n ],
+            refPlacement.basePointer, refPlacement.memSize, refPlacement.offX, refPlacement.offY, refPlacement.bufferWidth
+        );
+
+        verifySamePlacement( placement, refPlacement, layoutIndex, chainIndex );
+
+        if ( !placement.hasAllocated )
+            return;
+    }
+
+    if ( layout.clutWidth != 0 )
+    {
+        gsPlacement placement, refPlacement;
+
+        placement.hasAllocated = gsMem.allocateCLUT(
+            layout.memLayoutType, layoutProps, layout.clutWidth, layout.clutHeight,
+            placement.basePointer, placement.memSize, placement.offX, placement.offY, placement.bufferWidth,
+            mipmapCount
+        );
+        refPlacement.hasAllocated = refMem.allocateCLUT(
+            layout.memLayoutType, layoutProps, layout.clutWidth, layout.clutHeight,
+            refPlacement.basePointer, refPlacement.memSize, refPlacement.offX, refPlacement.offY, refPlacement.bufferWidth,
+            mipmapCount
+        );
+
+        verifySamePlacement( placement, refPlacement, layoutIndex, chainIndex );
+    }
+}
+
+void CheckPS2GSMemoryAllocator( void )
+{
+    // The sequence must be the same every time, so that failures can be reproduced.
+    uint32 randomState = 0x2545F491;
+
+    const size_t numLayouts = ( sizeof( checkedLayouts ) / sizeof( *checkedLayouts ) );
+
+    for ( size_t layoutIndex = 0; layoutIndex < numLayouts; layoutIndex++ )
+    {
+        const checkedLayout& layout = checkedLayouts[ layoutIndex ];
+
+        for ( uint32 chainIndex = 0; chainIndex < chainsPerLayout; chainIndex++ )
+        {
+            uint32 mipWidths[ 9 ];
+            uint32 mipHeights[ 9 ];
+
+            randomState = ( randomState * 1664525 + 1013904223 );
+
+            // Take power-of-two as well as odd sizes.
+            uint32 width = ( chainIndex % 2 ) ? ( 1u << ( ( randomState >> 8 ) % 11 ) ) : ( 1 + ( randomState >> 8 ) % 1024 );
+
+            randomState = ( randomState * 1664525 + 1013904223 );
+
+            uint32 height = ( chainIndex % 3 ) ? ( 1u << ( ( randomState >> 8 ) % 11 ) ) : ( 1 + ( randomState >> 8 ) % 1024 );
+
+            randomState = ( randomState * 1664525 + 1013904223 );
+
+            uint32 maxMipmapCount = ( 1 + ( randomState >> 8 ) % 9 );
+
+            uint32 mipmapCount = 0;
+
+            while ( mipmapCount < maxMipmapCount && width != 0 && height != 0 )
+            {
+                mipWidths[ mipmapCount ] = width;
+                mipHeights[ mipmapCount ] = height;
+
+                mipmapCount++;
+
+                width /= 2;
+                height /= 2;
+            }
+
+            checkMipmapChain( layout, layoutIndex, chainIndex, mipWidths, mipHeights, mipmapCount );
+        }
+    }
+}
+
+#else
+
+void CheckPS2GSMemoryAllocator( void )
+{
+    // The PS2 native texture is not compiled into rwlib.
+    return;
+}
+
+#endif //RWLIB_INCLUDE_NATIVETEX_PLAYSTATION2
@@ -0,0 +1,588 @@
+#include "mainwindow.h"
+#include "asyncloader.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <thread>
+
+#include "qtrwutils.hxx"
+
+// We keep one core free for the GUI.
+static unsigned int GetPreviewWorkerCount( void )
+{
+    unsigned int hwThreads = std::thread::hardware_concurrency();
+
+    if ( hwThreads <= 2 )
+        return 1;
+
+    return std::min( hwThreads - 1, 4u );
+}
+
+AsyncTxdLoader::AsyncTxdLoader( MainWindow *mainWnd, size_t previewCacheBudget )
+{
+    this->mainWnd = mainWnd;
+    this->txdLoadGeneration = 0;
+    this->isTerminating = false;
+    this->previewGeneration = 0;
+    this->hasWantedPreview = false;
+    this->wantedRaster = NULL;
+    this->wantedDrawMipmaps = false;
+    this->previewCacheSize = 0;
+    this->previewCacheBudget = previewCacheBudget;
+
+    rw::Interface *rwEngine = mainWnd->GetEngine();
+
+    unsigned int workerCount = GetPreviewWorkerCount();
+
+    for ( unsigned int n = 0; n < workerCount; n++ )
+    {
+        rw::thread_t workerThread = rw::MakeThread( rwEngine, _previewWorkerEntryPoint, this );
+
+        if ( workerThread == NULL )
+            break;
+
+        this->previewWorkers.push_back( workerThread );
+
+        rw::ResumeThread( rwEngine, workerThread );
+    }
+}
+
+AsyncTxdLoader::~AsyncTxdLoader( void )
+{
+    rw::Interface *rwEngine = this->mainWnd->GetEngine();
+
+    {
+        std::unique_lock <std::mutex> lock( this->previewLock );
+
+        this->isTerminating = true;
+
+        this->ClearWaitingPreviews();
+    }
+
+    this->previewJobAvailableCond.notify_all();
+
+    // Workers finish the preview they are on before they quit.
+    for ( rw::thread_t workerThread : this->previewWorkers )
+    {
+        rw::JoinThread( rwEngine, workerThread );
+
+        rw::CloseThread( rwEngine, workerThread );
+    }
+
+    this->previewWorkers.clear();
+
+    // TXD loads cannot be interrupted, so we have to wait for them.
+    // Their results are still in our event queue and get deleted with us.
+    for ( txdLoadTask *task : this->txdLoadTasks )
+    {
+        rw::JoinThread( rwEngine, task->threadHandle );
+
+        rw::CloseThread( rwEngine, task->threadHandle );
+
+        delete task;
+    }
+
+    this->txdLoadTasks.clear();
+
+    this->ClearPreviewCache();
+}
+
+static CFile* OpenGlobalFile( MainWindow *mainWnd, const filePath& path, const filePath& mode )
+{
+    CFile *theFile = NULL;
+
+    CFileTranslator *accessPoint = mainWnd->fileSystem->CreateSystemMinimumAccessPoint( path );
+
+    if ( accessPoint )
+    {
+        theFile = accessPoint->Open( path, mode );
+
+        if ( theFile )
+        {
+            theFile = CreateDecompressedStream( mainWnd, theFile );
+        }
+
+        delete accessPoint;
+    }
+
+    return theFile;
+}
+
+void __cdecl AsyncTxdLoader::_txdLoadEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud )
+{
+    txdLoadTask *task = (txdLoadTask*)ud;
+
+    AsyncTxdLoader *loader = task->loader;
+
+    txd_loaded_event *resultEvt = new txd_loaded_event( rwEngine, task );
+
+    try
+    {
+        // We got a file name, try to load that TXD file into our editor.
+        std::wstring unicodeFileName = task->fileName.toStdWString();
+
+        CFile *fileStream = OpenGlobalFile( loader->mainWnd, unicodeFileName.c_str(), L"rb" );
+
+        if ( fileStream )
+        {
+            try
+            {
+                rw::Stream *txdFileStream = RwStreamCreateTranslated( rwEngine, fileStream );
+
+                // If the opening succeeded, process things.
+                if ( txdFileStream )
+                {
+                    loader->PostLogMessage( QString( "loading TXD: " ) + task->fileName, LOGMSG_INFO );
+
+                    // Parse the input file.
+                    rw::RwObject *parsedObject = NULL;
+
+                    try
+                    {
+                        parsedObject = rwEngine->Deserialize( txdFileStream );
+                    }
+                    catch( rw::RwException& except )
+                    {
+                        loader->PostLogMessage( QString( "failed to load the TXD archive: %1" ).arg( ansi_to_qt( except.message ) ), LOGMSG_ERROR );
+                    }
+
+                    if ( parsedObject )
+                    {
+                        // Try to cast it to a TXD. If it fails we did not get a TXD.
+                        rw::TexDictionary *newTXD = rw::ToTexDictionary( rwEngine, parsedObject );
+
+                        if ( newTXD )
+                        {
+                            resultEvt->loadedTXD = newTXD;
+                        }
+                        else
+                        {
+                            const char *objTypeName = rwEngine->GetObjectTypeName( parsedObject );
+
+                            loader->PostLogMessage( QString( "found %1 but expected a texture dictionary" ).arg( objTypeName ), LOGMSG_WARNING );
+
+                            // Get rid of the object that is not a TXD.
+                            rwEngine->DeleteRwObject( parsedObject );
+                        }
+                    }
+                    // if parsedObject is NULL, the RenderWare implementation should have error'ed us already.
+
+                    // Remember to close the stream again.
+                    rwEngine->DeleteStream( txdFileStream );
+                }
+            }
+            catch( ... )
+            {
+                delete fileStream;
+
+                throw;
+            }
+
+            delete fileStream;
+        }
+    }
+    catch( ... )
+    {
+        // Nobody above us could handle it.
+        loader->PostLogMessage( QString( "failed to load the TXD archive: " ) + task->fileName, LOGMSG_ERROR );
+    }
+
+    QCoreApplication::postEvent( loader, resultEvt );
+}
+
+void AsyncTxdLoader::BeginTxdLoad( QString fileName )
+{
+    rw::Interface *rwEngine = this->mainWnd->GetEngine();
+
+    txdLoadTask *task = new txdLoadTask();
+    task->loader = this;
+    task->threadHandle = NULL;
+    task->fileName = std::move( fileName );
+    task->generation = ++this->txdLoadGeneration;
+
+    rw::thread_t loadThread = rw::MakeThread( rwEngine, _txdLoadEntryPoint, task );
+
+    if ( loadThread == NULL )
+    {
+        delete task;
+
+        this->mainWnd->txdLog->showError( "failed to create the TXD loading thread" );
+        return;
+    }
+
+    task->threadHandle = loadThread;
+
+    this->txdLoadTasks.push_back( task );
+
+    rw::ResumeThread( rwEngine, loadThread );
+}
+
+void AsyncTxdLoader::CancelTxdLoad( void )
+{
+    // The log has been told that a load began, so it has to hear that it ended.
+    for ( txdLoadTask *task : this->txdLoadTasks )
+    {
+        if ( task->generation == this->txdLoadGeneration )
+        {
+            this->mainWnd->txdLog->afterTxdLoading();
+            break;
+        }
+    }
+
+    // Running loads finish but nobody will care about their result.
+    this->txdLoadGeneration++;
+}
+
+void AsyncTxdLoader::DecodePreview( rw::Interface *rwEngine, preview_decoded_event *resultEvt )
+{
+    rw::Raster *rasterData = resultEvt->job.texRaster;
+
+    try
+    {
+        // Get a bitmap to the raster.
+        // This is a 2D color component surface.
+        rw::Bitmap rasterBitmap( 32, rw::RASTER_8888, rw::COLOR_BGRA );
+
+        if ( resultEvt->job.drawMipmaps )
+        {
+            rasterBitmap.setBgColor( 1.0, 1.0, 1.0, 0.0 );
+
+            rw::DebugDrawMipmaps( rwEngine, rasterData, rasterBitmap );
+        }
+        else
+        {
+            rasterBitmap = rasterData->getBitmap();
+        }
+
+        // QImage may be created outside of the GUI thread.
+        resultEvt->image = convertRWBitmapToQImage( rasterBitmap );
+        resultEvt->hasImage = true;
+    }
+    catch( rw::RwException& except )
+    {
+        resultEvt->errorMsg = ansi_to_qt( except.message );
+    }
+    catch( ... )
+    {
+        // Exceptions must not leave the worker thread.
+        resultEvt->errorMsg = "unknown error";
+    }
+}
+
+void __cdecl AsyncTxdLoader::_previewWorkerEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud )
+{
+    AsyncTxdLoader *loader = (AsyncTxdLoader*)ud;
+
+    while ( true )
+    {
+        previewJob job;
+        {
+            std::unique_lock <std::mutex> lock( loader->previewLock );
+
+            while ( !loader->isTerminating && loader->waitingPreviews.empty() )
+            {
+                loader->previewJobAvailableCond.wait( lock );
+            }
+
+            if ( loader->isTerminating )
+                break;
+
+            job = loader->waitingPreviews.front();
+
+            loader->waitingPreviews.pop_front();
+
+            loader->decodingPreviews.push_back( job );
+        }
+
+        // The event takes over the raster reference of the job.
+        preview_decoded_event *resultEvt = new preview_decoded_event( job );
+
+        loader->DecodePreview( rwEngine, resultEvt );
+
+        QCoreApplication::postEvent( loader, resultEvt );
+    }
+}
+
+bool AsyncTxdLoader::IsPreviewPending( rw::Raster *texRaster, bool drawMipmaps ) const
+{
+    unsigned int curGeneration = this->previewGeneration;
+
+    for ( const previewJob& job : this->waitingPreviews )
+    {
+        if ( job.texRaster == texRaster && job.drawMipmaps == drawMipmaps && job.generation == curGeneration )
+            return true;
+    }
+
+    for ( const previewJob& job : this->decodingPreviews )
+    {
+        if ( job.texRaster == texRaster && job.drawMipmaps == drawMipmaps && job.generation == curGeneration )
+            return true;
+    }
+
+    return false;
+}
+
+void AsyncTxdLoader::ClearWaitingPreviews( void )
+{
+    // Must be called with the preview lock held.
+    for ( const previewJob& job : this->waitingPreviews )
+    {
+        rw::DeleteRaster( job.texRaster );
+    }
+
+    this->waitingPreviews.clear();
+}
+
+bool AsyncTxdLoader::GetCachedPreview( rw::Raster *texRaster, bool drawMipmaps, QImage& imageOut )
+{
+    for ( auto iter = this->previewCache.begin(); iter != this->previewCache.end(); iter++ )
+    {
+        previewCacheEntry& entry = *iter;
+
+        if ( entry.texRaster == texRaster && entry.drawMipmaps == drawMipmaps )
+        {
+            imageOut = entry.image;
+
+            // Mark it as most recently used.
+            this->previewCache.splice( this->previewCache.begin(), this->previewCache, iter );
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AsyncTxdLoader::RequestPreview( rw::Raster *texRaster, bool drawMipmaps )
+{
+    {
+        std::unique_lock <std::mutex> lock( this->previewLock );
+
+        // The user is not interested in anything that was requested before.
+        this->ClearWaitingPreviews();
+
+        this->hasWantedPreview = true;
+        this->wantedRaster = texRaster;
+        this->wantedDrawMipmaps = drawMipmaps;
+
+        // If a worker is already at it, we just wait for it.
+        if ( this->IsPreviewPending( texRaster, drawMipmaps ) )
+            return;
+
+        previewJob job;
+        job.texRaster = rw::AcquireRaster( texRaster );
+        job.drawMipmaps = drawMipmaps;
+        job.generation = this->previewGeneration;
+
+        this->waitingPreviews.push_front( job );
+    }
+
+    this->previewJobAvailableCond.notify_one();
+}
+
+void AsyncTxdLoader::PrefetchPreview( rw::Raster *texRaster, bool drawMipmaps )
+{
+    for ( const previewCacheEntry& entry : this->previewCache )
+    {
+        if ( entry.texRaster == texRaster && entry.drawMipmaps == drawMipmaps )
+            return;
+    }
+
+    {
+        std::unique_lock <std::mutex> lock( this->previewLock );
+
+        if ( this->IsPreviewPending( texRaster, drawMipmaps ) )
+            return;
+
+        previewJob job;
+        job.texRaster = rw::AcquireRaster( texRaster );
+        job.drawMipmaps = drawMipmaps;
+        job.generation = this->previewGeneration;
+
+        this->waitingPreviews.push_back( job );
+    }
+
+    this->previewJobAvailableCond.notify_one();
+}
+
+void AsyncTxdLoader::CancelPreviews( void )
+{
+    std::unique_lock <std::mutex> lock( this->previewLock );
+
+    this->ClearWaitingPreviews();
+
+    this->hasWantedPreview = false;
+    this->wantedRaster = NULL;
+}
+
+void AsyncTxdLoader::InvalidatePreviews( void )
+{
+    {
+        std::unique_lock <std::mutex> lock( this->previewLock );
+
+        this->ClearWaitingPreviews();
+
+        // Previews that are still being decoded are thrown away on delivery.
+        this->previewGeneration++;
+
+        this->hasWantedPreview = false;
+        this->wantedRaster = NULL;
+    }
+
+    this->ClearPreviewCache();
+}
+
+void AsyncTxdLoader::PutIntoPreviewCache( rw::Raster *texRaster, bool drawMipmaps, const QImage& image )
+{
+    size_t imageSize = (size_t)image.byteCount();
+
+    // Huge previews would just flush everything else.
+    if ( imageSize > this->previewCacheBudget )
+        return;
+
+    while ( this->previewCacheSize + imageSize > this->previewCacheBudget && !this->previewCache.empty() )
+    {
+        previewCacheEntry& lruEntry = this->previewCache.back();
+
+        this->previewCacheSize -= lruEntry.imageSize;
+
+        rw::DeleteRaster( lruEntry.texRaster );
+
+        this->previewCache.pop_back();
+    }
+
+    previewCacheEntry entry;
+    entry.texRaster = rw::AcquireRaster( texRaster );
+    entry.drawMipmaps = drawMipmaps;
+    entry.image = image;
+    entry.imageSize = imageSize;
+
+    this->previewCache.push_front( std::move( entry ) );
+
+    this->previewCacheSize += imageSize;
+}
+
+void AsyncTxdLoader::ClearPreviewCache( void )
+{
+    // Holding the rasters prevents their memory from being reused by other rasters while cached.
+    for ( const previewCacheEntry& entry : this->previewCache )
+    {
+        rw::DeleteRaster( entry.texRaster );
+    }
+
+    this->previewCache.clear();
+    this->previewCacheSize = 0;
+}
+
+void AsyncTxdLoader::PostLogMessage( QString msg, eLogMessageType msgType )
+{
+    log_message_event *evt = new log_message_event( std::move( msg ), msgType );
+
+    QCoreApplication::postEvent( this, evt );
+}
+
+void AsyncTxdLoader::customEvent( QEvent *evt )
+{
+    MainWindow *mainWnd = this->mainWnd;
+
+    if ( log_message_event *msgEvt = dynamic_cast <log_message_event*> ( evt ) )
+    {
+        if ( msgEvt->msgType == LOGMSG_ERROR )
+        {
+            mainWnd->txdLog->showError( msgEvt->msg );
+        }
+        else
+        {
+            mainWnd->txdLog->addLogMessage( msgEvt->msg, msgEvt->msgType );
+        }
+
+        return;
+    }
+
+    if ( txd_loaded_event *loadEvt = dynamic_cast <txd_loaded_event*> ( evt ) )
+    {
+        rw::Interface *rwEngine = mainWnd->GetEngine();
+
+        txdLoadTask *task = loadEvt->task;
+
+        // The thread has posted us its last words.
+        rw::JoinThread( rwEngine, task->threadHandle );
+        rw::CloseThread( rwEngine, task->threadHandle );
+
+        this->txdLoadTasks.remove( task );
+
+        // Only the most recent load counts.
+        if ( task->generation == this->txdLoadGeneration )
+        {
+            if ( rw::TexDictionary *newTXD = loadEvt->loadedTXD )
+            {
+                loadEvt->loadedTXD = NULL;
+
+                // Okay, we got a new TXD.
+                // Set it as our current object in the editor.
+                mainWnd->setCurrentTXD( newTXD );
+
+                mainWnd->setCurrentFilePath( task->fileName );
+            }
+
+            mainWnd->txdLog->afterTxdLoading();
+        }
+
+        delete task;
+
+        return;
+    }
+
+    if ( preview_decoded_event *previewEvt = dynamic_cast <preview_decoded_event*> ( evt ) )
+    {
+        const previewJob& job = previewEvt->job;
+
+        bool isWanted = false;
+        {
+            std::unique_lock <std::mutex> lock( this->previewLock );
+
+            for ( auto iter = this->decodingPreviews.begin(); iter != this->decodingPreviews.end(); iter++ )
+            {
+                if ( iter->texRaster == job.texRaster && iter->drawMipmaps == job.drawMipmaps && iter->generation == job.generation )
+                {
+                    this->decodingPreviews.erase( iter );
+                    break;
+                }
+            }
+
+            // Stale previews are of no use to anybody.
+            if ( job.generation != this->previewGeneration )
+                return;
+
+            if ( this->hasWantedPreview && this->wantedRaster == job.texRaster && this->wantedDrawMipmaps == job.drawMipmaps )
+            {
+                isWanted = true;
+
+                this->hasWantedPreview = false;
+                this->wantedRaster = NULL;
+            }
+        }
+
+        if ( previewEvt->hasImage )
+        {
+            this->PutIntoPreviewCache( job.texRaster, job.drawMipmaps, previewEvt->image );
+
+            if ( isWanted )
+            {
+                mainWnd->showTexturePreview( previewEvt->image );
+            }
+        }
+        else if ( isWanted )
+        {
+            mainWnd->txdLog->addLogMessage( QString( "failed to get bitmap from texture: " ) + previewEvt->errorMsg, LOGMSG_WARNING );
+
+            // We hide the image widget.
+            mainWnd->clearViewImage();
+        }
+
+        return;
+    }
+
+    QObject::customEvent( evt );
+}
@@ -37,6 +37,8 @@
 #define MAIN_MIN_HEIGHT 300
 #define MAIN_HEIGHT 560
 
+#define PREVIEW_CACHE_BUDGET ( 128 * 1024 * 1024 )
+
 MainWindow::MainWindow(QString appPath, rw::Interface *engineInterface, CFileSystem *fsHandle, QWidget *parent) :
     QMainWindow(parent),
     rwWarnMan( this )
@@ -48,6 +50,7 @@ MainWindow::MainWindow(QString appPath, rw::Interface *engineInterface, CFileSys
     this->currentTXD = NULL;
     this->txdNameLabel = NULL;
     this->currentSelectedTexture = NULL;
+    this->asyncLoader = NULL;
     this->txdLog = NULL;
     this->verDlg = NULL;
     this->texNameDlg = NULL;
@@ -105,6 +108,9 @@ MainWindow::MainWindow(QString appPath, rw::Interface *engineInterface, CFileSys
 	    /* --- Log --- */
 	    this->txdLog = new TxdLog(this, this->m_appPath, this);
 
+        /* --- Background work --- */
+        this->asyncLoader = new AsyncTxdLoader(this, PREVIEW_CACHE_BUDGET);
+
 	    /* --- List --- */
 	    QListWidget *listWidget = new QListWidget();
 	    listWidget->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
@@ -629,6 +635,14 @@ MainWindow::MainWindow(QString appPath, rw::Interface *engineInterface, CFileSys
     }
     catch( ... )
     {
+        // The workers must not outlive us.
+        if ( AsyncTxdLoader *asyncLoader = this->asyncLoader )
+        {
+            this->asyncLoader = NULL;
+
+            delete asyncLoader;
+        }
+
         rwEngine->SetWarningManager( NULL );
 
         throw;
@@ -637,6 +651,15 @@ MainWindow::MainWindow(QString appPath, rw::Interface *engineInterface, CFileSys
 
 MainWindow::~MainWindow()
 {
+    // Wait for any background work to finish.
+    // This has to happen first because the workers use our TXD and engine.
+    if ( AsyncTxdLoader *asyncLoader = this->asyncLoader )
+    {
+        delete asyncLoader;
+
+        this->asyncLoader = NULL;
+    }
+
     // If we have a loaded TXD, get rid of it.
     if ( this->currentTXD )
     {
@@ -786,6 +809,9 @@ void MainWindow::setCurrentTXD( rw::TexDictionary *txdObj )
     if ( this->currentTXD == txdObj )
         return;
 
+    // Previews of the old TXD are of no use anymore.
+    this->asyncLoader->InvalidatePreviews();
+
     if ( this->currentTXD != NULL )
     {
         // Make sure we have no more texture in our viewport.
@@ -961,6 +987,9 @@ void MainWindow::onCreateNewTXD( bool checked )
     // Just create an empty TXD.
     rw::TexDictionary *newTXD = NULL;
 
+    // We do not want a TXD that is still loading to replace this one.
+    this->asyncLoader->CancelTxdLoad();
+
     try
     {
         newTXD = rw::CreateTexDictionary( this->rwEngine );
@@ -985,103 +1014,15 @@ void MainWindow::onCreateNewTXD( bool checked )
     this->clearCurrentFilePath();
 }
 
-#include "tools/dirtools.h"
-
-static CFile* OpenGlobalFile( MainWindow *mainWnd, const filePath& path, const filePath& mode )
-{
-    CFile *theFile = NULL;
-
-    CFileTranslator *accessPoint = mainWnd->fileSystem->CreateSystemMinimumAccessPoint( path );
-
-    if ( accessPoint )
-    {
-        theFile = accessPoint->Open( path, mode );
-
-        if ( theFile )
-        {
-            theFile = CreateDecompressedStream( mainWnd, theFile );
-        }
-
-        delete accessPoint;
-    }
-
-    return theFile;
-}
-
 void MainWindow::openTxdFile(QString fileName) {
-    this->txdLog->beforeTxdLoading();
-
     if (fileName.length() != 0)
     {
-        // We got a file name, try to load that TXD file into our editor.
-        std::wstring unicodeFileName = fileName.toStdWString();
-
-        CFile *fileStream = OpenGlobalFile( this, unicodeFileName.c_str(), L"rb" );
-
-        if ( fileStream )
-        {
-            try
-            {
-                rw::Stream *txdFileStream = RwStreamCreateTranslated( this->rwEngine, fileStream );
-
-                // If the opening succeeded, process things.
-                if (txdFileStream)
-                {
-                    this->txdLog->addLogMessage(QString("loading TXD: ") + fileName);
-
-                    // Parse the input file.
-                    rw::RwObject *parsedObject = NULL;
-
-                    try
-                    {
-                        parsedObject = this->rwEngine->Deserialize(txdFileStream);
-                    }
-                    catch (rw::RwException& except)
-                    {
-                        this->txdLog->showError(QString("failed to load the TXD archive: %1").arg(ansi_to_qt(except.message)));
-                    }
-
-                    if (parsedObject)
-                    {
-                        // Try to cast it to a TXD. If it fails we did not get a TXD.
-                        rw::TexDictionary *newTXD = rw::ToTexDictionary(this->rwEngine, parsedObject);
-
-                        if (newTXD)
-                        {
-                            // Okay, we got a new TXD.
-                            // Set it as our current object in the editor.
-                            this->setCurrentTXD(newTXD);
-
-                            this->setCurrentFilePath(fileName);
-                        }
-                        else
-                        {
-                            const char *objTypeName = this->rwEngine->GetObjectTypeName(parsedObject);
-
-                            this->txdLog->addLogMessage(QString("found %1 but expected a texture dictionary").arg(objTypeName), LOGMSG_WARNING);
-
-                            // Get rid of the object that is not a TXD.
-                            this->rwEngine->DeleteRwObject(parsedObject);
-                        }
-                    }
-                    // if parsedObject is NULL, the RenderWare implementation should have error'ed us already.
-
-                    // Remember to close the stream again.
-                    this->rwEngine->DeleteStream(txdFileStream); //Open TXD file...
-                }
-            }
-            catch( ... )
-            {
-                delete fileStream;
-                
-                throw;
-            }
+        this->txdLog->beforeTxdLoading();
 
-            delete fileStream;
-        }
+        // The TXD is parsed on a loader thread so the editor does not freeze.
+        // It becomes our current TXD once it is ready.
+        this->asyncLoader->BeginTxdLoad(fileName);
     }
-
-    this->txdLog->afterTxdLoading();
 }
 
 void MainWindow::onOpenFile( bool checked )
@@ -1102,6 +1043,9 @@ void MainWindow::onCloseCurrent( bool checked )
     this->currentSelectedTexture = NULL;
     this->hasOpenedTXDFileInfo = false;
 
+    // Forget about any TXD that is still loading.
+    this->asyncLoader->CancelTxdLoad();
+
 	clearViewImage();
 
     // Make sure we got no TXD active.
@@ -1131,7 +1075,8 @@ void MainWindow::onTextureItemChanged(QListWidgetItem *listItem, QListWidgetItem
 
     this->updateFriendlyIcons();
 
-    this->updateTextureView();
+    // Since the texture contents did not change, we can reuse a cached preview.
+    this->requestTexturePreview();
 
     // Change what textures we can export to.
     this->UpdateExportAccessibility();
@@ -1139,49 +1084,81 @@ void MainWindow::onTextureItemChanged(QListWidgetItem *listItem, QListWidgetItem
 
 void MainWindow::updateTextureView( void )
 {
+    // Called if texture contents have changed, so cached previews could be stale.
+    this->asyncLoader->InvalidatePreviews();
+
+    this->requestTexturePreview();
+}
+
+void MainWindow::requestTexturePreview( void )
+{
+    AsyncTxdLoader *asyncLoader = this->asyncLoader;
+
     TexInfoWidget *texItem = this->currentSelectedTexture;
 
-    if ( texItem != NULL )
+    if ( texItem == NULL )
     {
-		// Get the actual texture we are associated with and present it on the output pane.
-		rw::TextureBase *theTexture = texItem->GetTextureHandle();
-		rw::Raster *rasterData = theTexture->GetRaster();
-		if (rasterData)
-		{
-            try
-            {
-			    // Get a bitmap to the raster.
-			    // This is a 2D color component surface.
-			    rw::Bitmap rasterBitmap( 32, rw::RASTER_8888, rw::COLOR_BGRA );
+        asyncLoader->CancelPreviews();
+        return;
+    }
 
-                if ( this->drawMipmapLayers && rasterData->getMipmapCount() > 1 )
-                {
-                    rasterBitmap.setBgColor( 1.0, 1.0, 1.0, 0.0 );
+    // Get the actual texture we are associated with and present it on the output pane.
+    rw::TextureBase *theTexture = texItem->GetTextureHandle();
+    rw::Raster *rasterData = theTexture->GetRaster();
 
-                    rw::DebugDrawMipmaps( this->rwEngine, rasterData, rasterBitmap );
-                }
-                else
-                {
-                    rasterBitmap = rasterData->getBitmap();
-                }
+    if ( rasterData == NULL )
+    {
+        asyncLoader->CancelPreviews();
+        return;
+    }
 
-			    QImage texImage = convertRWBitmapToQImage( rasterBitmap );
+    bool drawMipmaps = ( this->drawMipmapLayers && rasterData->getMipmapCount() > 1 );
 
-			    imageWidget->setPixmap(QPixmap::fromImage(texImage));
-                this->updateTextureViewport();
-			    imageWidget->show();
-            }
-            catch( rw::RwException& except )
-            {
-				this->txdLog->addLogMessage(QString("failed to get bitmap from texture: ") + except.message.c_str(), LOGMSG_WARNING);
+    QImage texImage;
 
-                // We hide the image widget.
-                this->clearViewImage();
-            }
-		}
+    if ( asyncLoader->GetCachedPreview( rasterData, drawMipmaps, texImage ) )
+    {
+        asyncLoader->CancelPreviews();
+
+        this->showTexturePreview( texImage );
+    }
+    else
+    {
+        // The image is shown once a worker has decoded it.
+        asyncLoader->RequestPreview( rasterData, drawMipmaps );
+    }
+
+    // Decode the neighbours in the list too, so that stepping through it is instant.
+    QListWidget *texListWidget = this->textureListWidget;
+
+    int curRow = texListWidget->row( texItem->listItem );
+
+    for ( int neighbourRow : { curRow + 1, curRow - 1 } )
+    {
+        if ( neighbourRow < 0 || neighbourRow >= texListWidget->count() )
+            continue;
+
+        TexInfoWidget *neighbourItem = dynamic_cast <TexInfoWidget*> ( texListWidget->itemWidget( texListWidget->item( neighbourRow ) ) );
+
+        if ( neighbourItem == NULL )
+            continue;
+
+        if ( rw::Raster *neighbourRaster = neighbourItem->GetTextureHandle()->GetRaster() )
+        {
+            bool neighbourDrawMipmaps = ( this->drawMipmapLayers && neighbourRaster->getMipmapCount() > 1 );
+
+            asyncLoader->PrefetchPreview( neighbourRaster, neighbourDrawMipmaps );
+        }
     }
 }
 
+void MainWindow::showTexturePreview( const QImage& texImage )
+{
+    imageWidget->setPixmap(QPixmap::fromImage(texImage));
+    this->updateTextureViewport();
+    imageWidget->show();
+}
+
 void MainWindow::updateTextureViewport() {
     if (this->imageWidget->pixmap()){
         if (this->showFullImage) {
@@ -1215,7 +1192,8 @@ void MainWindow::onToggleShowMipmapLayers( bool checked )
     this->drawMipmapLayers = !( this->drawMipmapLayers );
 
     // Update the texture view.
-    this->updateTextureView();
+    // Both kinds of preview are cached separately, so this is cheap when switching back.
+    this->requestTexturePreview();
 }
 
 void MainWindow::onToggleShowBackground(bool checked)
@@ -1901,24 +1879,16 @@ const char* MainWindow::GetTXDPlatformString( rw::TexDictionary *txd )
 void MainWindow::SetTXDPlatformString( rw::TexDictionary *txd, const char *platform )
 {
     // To change the platform of a TXD we have to set all of it's textures platforms.
-    for ( rw::TexDictionary::texIter_t iter( txd->GetTextureIterator() ); !iter.IsEnd(); iter.Increment() )
-    {
-        rw::TextureBase *texHandle = iter.Resolve();
+    // The textures are converted at the same time; failing ones do not stop the others.
+    rw::rasterConversionResults_t results;
 
-        rw::Raster *texRaster = texHandle->GetRaster();
+    rw::ConvertTexDictionaryRastersTo( txd, platform, &results );
 
-        if ( texRaster )
+    for ( const rw::rasterConversionResult& result : results )
+    {
+        if ( result.errorMessage.empty() == false )
         {
-            try
-            {
-                rw::ConvertRasterTo( texRaster, platform );
-            }
-            catch( rw::RwException& except )
-            {
-                this->txdLog->showError( ansi_to_qt( std::string( "failed to change platform of texture '" ) + texHandle->GetName() + "': " + except.message ) );
-
-                // Continue changing platform.
-            }
+            this->txdLog->showError( ansi_to_qt( std::string( "failed to change platform of texture '" ) + result.texHandle->GetName() + "': " + result.errorMessage ) );
         }
     }
 }
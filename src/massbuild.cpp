@@ -46,6 +46,11 @@ struct massbuildEnv : public magicSerializationProvider
         endian::little_endian <std::int32_t> genMipMaxLevel;
     };
 
+    struct massbuild_cache_cfg_struct
+    {
+        endian::little_endian <rw::uint32> cacheMaxSize;
+    };
+
     void Load( MainWindow *mainWnd, rw::BlockProvider& cfgBlock ) override
     {
         // Load our state.
@@ -59,6 +64,21 @@ struct massbuildEnv : public magicSerializationProvider
         this->config.targetPlatform = cfgStruct.targetPlatform;
         this->config.generateMipmaps = cfgStruct.generateMipmaps;
         this->config.curMipMaxLevel = cfgStruct.genMipMaxLevel;
+
+        // Older configurations do not have the cache settings.
+        try
+        {
+            RwReadUnicodeString( cfgBlock, this->config.cacheRoot );
+
+            massbuild_cache_cfg_struct cacheCfgStruct;
+            cfgBlock.readStruct( cacheCfgStruct );
+
+            this->config.cacheMaxSize = cacheCfgStruct.cacheMaxSize;
+        }
+        catch( rw::RwException& )
+        {
+            // Keep the defaults.
+        }
     }
 
     void Save( const MainWindow *mainWnd, rw::BlockProvider& cfgBlock ) const override
@@ -74,6 +94,13 @@ struct massbuildEnv : public magicSerializationProvider
         cfgStruct.genMipMaxLevel = this->config.curMipMaxLevel;
         
         cfgBlock.writeStruct( cfgStruct );
+
+        RwWriteUnicodeString( cfgBlock, this->config.cacheRoot );
+
+        massbuild_cache_cfg_struct cacheCfgStruct;
+        cacheCfgStruct.cacheMaxSize = this->config.cacheMaxSize;
+
+        cfgBlock.writeStruct( cacheCfgStruct );
     }
 
     TxdBuildModule::run_config config;
@@ -133,6 +160,33 @@ MassBuildWindow::MassBuildWindow( MainWindow *mainWnd ) : QDialog( mainWnd )
         )
     );
 
+    layout.top->addSpacing( 10 );
+
+    // Directories that did not change since an earlier build can be taken from the conversion cache.
+    // The cache is not used if no directory is given.
+    {
+        QFormLayout *cacheForm = new QFormLayout();
+
+        cacheForm->addRow(
+            CreateLabelL( "Tools.MassBld.CacheRt" ),
+            qtshared::createPathSelectGroup( QString::fromStdWString( env->config.cacheRoot ), this->editCacheRoot )
+        );
+
+        QLineEdit *cacheMaxSizeEdit = new QLineEdit( QString( "%1" ).arg( env->config.cacheMaxSize ) );
+
+        QIntValidator *cacheMaxSizeVal = new QIntValidator( 1, 1024 * 1024, this );
+
+        cacheMaxSizeEdit->setValidator( cacheMaxSizeVal );
+
+        cacheMaxSizeEdit->setMaximumWidth( 80 );
+
+        this->editCacheMaxSize = cacheMaxSizeEdit;
+
+        cacheForm->addRow( CreateLabelL( "Tools.MassBld.CacheMx" ), cacheMaxSizeEdit );
+
+        layout.top->addLayout( cacheForm );
+    }
+
     layout.top->addSpacing( 15 );
 
     // Last thing is the typical button row.
@@ -181,6 +235,15 @@ void MassBuildWindow::serialize( void )
 
     env->config.generateMipmaps = this->propGenMipmaps->isChecked();
     env->config.curMipMaxLevel = this->propGenMipmapsMax->text().toInt();
+
+    env->config.cacheRoot = this->editCacheRoot->text().toStdWString();
+
+    rw::uint32 cacheMaxSize = this->editCacheMaxSize->text().toUInt();
+
+    if ( cacheMaxSize != 0 )
+    {
+        env->config.cacheMaxSize = cacheMaxSize;
+    }
 }
 
 struct MassBuildModule : public TxdBuildModule
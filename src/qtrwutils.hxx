@@ -13,6 +13,13 @@ inline QImage convertRWBitmapToQImage( const rw::Bitmap& rasterBitmap )
 	{
 		uchar *scanLineContent = texImage.scanLine(y);
 
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+		// QRgb is 0xAARRGGBB, so the texels of a scanline are BGRA in memory.
+		// Let rwlib convert the whole row at once.
+		if (rasterBitmap.fetchrow(0, y, width, scanLineContent, rw::COLOR_BGRA))
+			continue;
+#endif
+
 		QRgb *colorItems = (QRgb*)scanLineContent;
 
 		for (int x = 0; x < width; x++)
@@ -0,0 +1,625 @@
+#include "mainwindow.h"
+
+#include "convcache.h"
+
+#include "dirtools.h"
+
+#include <sstream>
+#include <algorithm>
+
+static const char *const _cacheIndexFileName = "index.txt";
+static const char *const _cacheIndexHeader = "conversion-cache-index";
+static const int _cacheIndexVersion = 1;
+
+// Multiply-rotate hash over words of eight bytes, in two lanes with different constants.
+static const rw::uint64 _hashLanePrimes[2] = { 0x87C37B91114253D5ull, 0x4CF5AD432745937Full };
+static const rw::uint64 _hashLaneSeeds[2] = { 0x243F6A8885A308D3ull, 0x13198A2E03707344ull };
+
+static inline rw::uint64 mixHashWord( rw::uint64 hash, rw::uint64 word, rw::uint64 prime )
+{
+    hash ^= ( word * prime );
+    hash = ( hash << 31 ) | ( hash >> 33 );
+
+    return ( hash * 0x9E3779B97F4A7C15ull );
+}
+
+static inline rw::uint64 finalizeHash( rw::uint64 hash )
+{
+    hash ^= ( hash >> 33 );
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= ( hash >> 33 );
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= ( hash >> 33 );
+
+    return hash;
+}
+
+ConversionResultCache::contentKey::contentKey( const std::string& configDesc )
+{
+    this->hashLanes[0] = _hashLaneSeeds[0];
+    this->hashLanes[1] = _hashLaneSeeds[1];
+
+    AppendString( configDesc );
+}
+
+void ConversionResultCache::contentKey::AppendData( const void *data, size_t dataSize )
+{
+    const unsigned char *bytes = (const unsigned char*)data;
+
+    rw::uint64 laneA = this->hashLanes[0];
+    rw::uint64 laneB = this->hashLanes[1];
+
+    size_t n = 0;
+
+    for ( ; n + sizeof( rw::uint64 ) <= dataSize; n += sizeof( rw::uint64 ) )
+    {
+        rw::uint64 word;
+        memcpy( &word, bytes + n, sizeof( word ) );
+
+        laneA = mixHashWord( laneA, word, _hashLanePrimes[0] );
+        laneB = mixHashWord( laneB, word, _hashLanePrimes[1] );
+    }
+
+    rw::uint64 tailWord = 0;
+
+    for ( size_t k = 0; n + k < dataSize; k++ )
+    {
+        tailWord |= ( (rw::uint64)bytes[ n + k ] << ( k * 8 ) );
+    }
+
+    laneA = mixHashWord( laneA, tailWord, _hashLanePrimes[0] );
+    laneB = mixHashWord( laneB, tailWord, _hashLanePrimes[1] );
+
+    // The size goes in too, so that it matters where one piece of data ends and the next begins.
+    laneA = mixHashWord( laneA, (rw::uint64)dataSize, _hashLanePrimes[0] );
+    laneB = mixHashWord( laneB, (rw::uint64)dataSize, _hashLanePrimes[1] );
+
+    this->hashLanes[0] = finalizeHash( laneA );
+    this->hashLanes[1] = finalizeHash( laneB );
+}
+
+void ConversionResultCache::contentKey::AppendString( const std::string& str )
+{
+    AppendData( str.c_str(), str.size() );
+}
+
+std::string ConversionResultCache::contentKey::GetEntryName( void ) const
+{
+    char nameBuf[ 33 ];
+
+    snprintf( nameBuf, sizeof( nameBuf ), "%016llx%016llx", this->hashLanes[0], this->hashLanes[1] );
+
+    return nameBuf;
+}
+
+void ConversionResultCache::AppendEngineSettingsDescription( rw::Interface *rwEngine, std::string& desc )
+{
+    desc += "; version " + rwEngine->GetVersion().toString();
+
+    desc += "; palRuntime " + std::to_string( (int)rwEngine->GetPaletteRuntime() );
+    desc += "; dxtRuntime " + std::to_string( (int)rwEngine->GetDXTRuntime() );
+    desc += "; dxtPackedDecompression " + std::to_string( (int)rwEngine->GetDXTPackedDecompression() );
+    desc += "; fixIncompatibleRasters " + std::to_string( (int)rwEngine->GetFixIncompatibleRasters() );
+    desc += "; ignoreSerializationRegions " + std::to_string( (int)rwEngine->GetIgnoreSerializationBlockRegions() );
+    desc += "; compatTransformNativeImaging " + std::to_string( (int)rwEngine->GetCompatTransformNativeImaging() );
+    desc += "; preferPackedSampleExport " + std::to_string( (int)rwEngine->GetPreferPackedSampleExport() );
+    desc += "; metaDataTagging " + std::to_string( (int)rwEngine->GetMetaDataTagging() );
+
+    // The warnings are cached with the result.
+    desc += "; warnings " + std::to_string( rwEngine->GetWarningLevel() ) + " " + std::to_string( (int)rwEngine->GetIgnoreSecureWarnings() );
+}
+
+// The size of the warning text is stored as four little-endian bytes.
+void ConversionResultCache::PackResultEntry( const std::string& warnings, const std::vector <char>& resultData, std::vector <char>& entryOut )
+{
+    rw::uint32 warningsSize = (rw::uint32)warnings.size();
+
+    entryOut.clear();
+    entryOut.reserve( 4 + warnings.size() + resultData.size() );
+
+    for ( unsigned int n = 0; n < 4; n++ )
+    {
+        entryOut.push_back( (char)( ( warningsSize >> ( n * 8 ) ) & 0xFF ) );
+    }
+
+    entryOut.insert( entryOut.end(), warnings.begin(), warnings.end() );
+    entryOut.insert( entryOut.end(), resultData.begin(), resultData.end() );
+}
+
+bool ConversionResultCache::UnpackResultEntry( const std::vector <char>& entryData, std::string& warningsOut, std::vector <char>& resultDataOut )
+{
+    if ( entryData.size() < 4 )
+        return false;
+
+    rw::uint32 warningsSize = 0;
+
+    for ( unsigned int n = 0; n < 4; n++ )
+    {
+        warningsSize |= ( (rw::uint32)(unsigned char)entryData[ n ] << ( n * 8 ) );
+    }
+
+    if ( warningsSize > entryData.size() - 4 )
+        return false;
+
+    std::vector <char>::const_iterator warningsBegin = entryData.begin() + 4;
+    std::vector <char>::const_iterator resultBegin = warningsBegin + warningsSize;
+
+    warningsOut.assign( warningsBegin, resultBegin );
+    resultDataOut.assign( resultBegin, entryData.end() );
+    return true;
+}
+
+static inline std::string getEntryFileName( const std::string& entryName )
+{
+    return ( entryName + ".bin" );
+}
+
+// Entry files are written under this name first and renamed once they are complete.
+static inline std::string getEntryTempFileName( const std::string& entryName )
+{
+    return ( entryName + ".tmp" );
+}
+
+static inline bool isValidEntryName( const std::string& entryName )
+{
+    if ( entryName.size() != 32 )
+        return false;
+
+    for ( char c : entryName )
+    {
+        if ( !( c >= '0' && c <= '9' ) && !( c >= 'a' && c <= 'f' ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ConversionResultCache::ConversionResultCache( CFileTranslator *cacheRoot, rw::uint64 maxCacheSize )
+{
+    this->cacheRoot = cacheRoot;
+    this->maxCacheSize = maxCacheSize;
+    this->totalSize = 0;
+    this->useCounter = 0;
+    this->isIndexDirty = false;
+
+    this->hitCount = 0;
+    this->missCount = 0;
+    this->storeCount = 0;
+    this->evictCount = 0;
+    this->hitByteCount = 0;
+
+    LoadIndex();
+
+    // The size limit could have been lowered since the last run.
+    std::vector <std::string> deleteFileNames;
+
+    EvictEntries( 0, deleteFileNames );
+
+    DeleteEntryFiles( deleteFileNames );
+}
+
+ConversionResultCache::~ConversionResultCache( void )
+{
+    try
+    {
+        SaveIndex();
+    }
+    catch( ... )
+    {
+        // The index is rebuilt from the entry files next time.
+    }
+}
+
+struct loadedCacheEntry
+{
+    std::string entryName;
+    rw::uint64 dataSize;
+    rw::uint64 lastUse;
+
+    inline bool operator < ( const loadedCacheEntry& right ) const
+    {
+        if ( this->lastUse != right.lastUse )
+        {
+            return ( this->lastUse < right.lastUse );
+        }
+
+        return ( this->entryName < right.entryName );
+    }
+};
+
+void ConversionResultCache::LoadIndex( void )
+{
+    // The index only remembers when each entry was used. The entries themselves are the files
+    // in the cache directory, so that files which the index does not know about (because a run
+    // was aborted or an entry could not be deleted) still count against the size limit.
+    std::map <std::string, rw::uint64> indexedUses;
+
+    if ( CFile *indexStream = this->cacheRoot->Open( _cacheIndexFileName, "rb" ) )
+    {
+        std::vector <char> indexData;
+
+        try
+        {
+            ReadStreamIntoMemory( indexStream, indexData );
+        }
+        catch( ... )
+        {
+            delete indexStream;
+
+            throw;
+        }
+
+        delete indexStream;
+
+        std::istringstream indexReader( std::string( indexData.begin(), indexData.end() ) );
+
+        std::string header;
+        int version = 0;
+        rw::uint64 useCounter = 0;
+
+        indexReader >> header >> version >> useCounter;
+
+        // If we do not understand the index then every entry counts as least recently used.
+        if ( indexReader && header == _cacheIndexHeader && version == _cacheIndexVersion )
+        {
+            std::string entryName;
+            rw::uint64 dataSize, lastUse;
+
+            while ( indexReader >> entryName >> dataSize >> lastUse )
+            {
+                indexedUses[ entryName ] = lastUse;
+            }
+        }
+    }
+
+    // Files of entries that were never completed are of no use.
+    std::vector <filePath> tempFiles;
+
+    this->cacheRoot->GetFiles( "@", "*.tmp", false, tempFiles );
+
+    for ( const filePath& tempFilePath : tempFiles )
+    {
+        this->cacheRoot->Delete( tempFilePath );
+    }
+
+    std::vector <filePath> entryFiles;
+
+    this->cacheRoot->GetFiles( "@", "*.bin", false, entryFiles );
+
+    std::vector <loadedCacheEntry> loadedEntries;
+
+    for ( const filePath& entryFilePath : entryFiles )
+    {
+        loadedCacheEntry entry;
+        entry.entryName = FileSystem::GetFileNameItem( entryFilePath, false ).convert_ansi();
+
+        if ( !isValidEntryName( entry.entryName ) )
+            continue;
+
+        entry.dataSize = this->cacheRoot->Size( entryFilePath );
+
+        std::map <std::string, rw::uint64>::const_iterator indexIter = indexedUses.find( entry.entryName );
+
+        entry.lastUse = ( indexIter != indexedUses.end() ) ? indexIter->second : 0;
+
+        loadedEntries.push_back( entry );
+    }
+
+    // Number the uses again, so that every entry has its own place in the use order.
+    std::sort( loadedEntries.begin(), loadedEntries.end() );
+
+    bool isSameAsIndex = ( loadedEntries.size() == indexedUses.size() );
+
+    for ( const loadedCacheEntry& entry : loadedEntries )
+    {
+        InsertEntry( entry.entryName, entry.dataSize );
+
+        if ( this->useCounter != entry.lastUse )
+        {
+            isSameAsIndex = false;
+        }
+    }
+
+    this->isIndexDirty = !isSameAsIndex;
+}
+
+void ConversionResultCache::SaveIndex( void )
+{
+    std::string indexData;
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        if ( !this->isIndexDirty )
+            return;
+
+        indexData =
+            std::string( _cacheIndexHeader ) + " " + std::to_string( _cacheIndexVersion ) + " " + std::to_string( this->useCounter ) + "\n";
+
+        for ( const std::pair <const std::string, cacheEntry>& entryPair : this->entries )
+        {
+            indexData += entryPair.first + " " + std::to_string( entryPair.second.dataSize ) + " " + std::to_string( entryPair.second.lastUse ) + "\n";
+        }
+
+        // Changes from now on have to be saved again.
+        this->isIndexDirty = false;
+    }
+
+    bool hasSaved = false;
+
+    if ( CFile *indexStream = this->cacheRoot->Open( _cacheIndexFileName, "wb" ) )
+    {
+        size_t writeCount = indexStream->Write( indexData.c_str(), 1, indexData.size() );
+
+        delete indexStream;
+
+        hasSaved = ( writeCount == indexData.size() );
+    }
+
+    if ( !hasSaved )
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        this->isIndexDirty = true;
+    }
+}
+
+void ConversionResultCache::InsertEntry( const std::string& entryName, rw::uint64 dataSize )
+{
+    cacheEntry newEntry;
+    newEntry.dataSize = dataSize;
+    newEntry.lastUse = ++this->useCounter;
+
+    this->entries[ entryName ] = newEntry;
+    this->useOrder[ newEntry.lastUse ] = entryName;
+
+    this->totalSize += dataSize;
+
+    this->isIndexDirty = true;
+}
+
+void ConversionResultCache::TouchEntry( entryMap_t::iterator entryIter )
+{
+    this->useOrder.erase( entryIter->second.lastUse );
+
+    entryIter->second.lastUse = ++this->useCounter;
+
+    this->useOrder[ entryIter->second.lastUse ] = entryIter->first;
+
+    this->isIndexDirty = true;
+}
+
+void ConversionResultCache::RemoveEntry( entryMap_t::iterator entryIter, std::vector <std::string>& deleteFileNames )
+{
+    // The file is deleted by the caller once it has left the lock.
+    deleteFileNames.push_back( getEntryFileName( entryIter->first ) );
+
+    this->totalSize -= entryIter->second.dataSize;
+
+    this->useOrder.erase( entryIter->second.lastUse );
+
+    this->entries.erase( entryIter );
+
+    this->isIndexDirty = true;
+}
+
+void ConversionResultCache::EvictEntries( rw::uint64 requiredSize, std::vector <std::string>& deleteFileNames )
+{
+    // Stores in progress cannot be evicted, so the limit can stay exceeded until they are done.
+    while ( !this->useOrder.empty() && this->totalSize + requiredSize > this->maxCacheSize )
+    {
+        // Get rid of the entry that has not been used for the longest time.
+        entryMap_t::iterator oldestIter = this->entries.find( this->useOrder.begin()->second );
+
+        assert( oldestIter != this->entries.end() );
+
+        RemoveEntry( oldestIter, deleteFileNames );
+
+        this->evictCount++;
+    }
+}
+
+void ConversionResultCache::DeleteEntryFiles( const std::vector <std::string>& deleteFileNames )
+{
+    for ( const std::string& fileName : deleteFileNames )
+    {
+        // If the file is still open somewhere then it is left behind; the next run picks it up again.
+        this->cacheRoot->Delete( fileName.c_str() );
+    }
+}
+
+bool ConversionResultCache::Lookup( const contentKey& key, std::vector <char>& dataOut )
+{
+    std::string entryName = key.GetEntryName();
+
+    rw::uint64 entryDataSize;
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        entryMap_t::iterator entryIter = this->entries.find( entryName );
+
+        if ( entryIter == this->entries.end() )
+        {
+            this->missCount++;
+
+            return false;
+        }
+
+        entryDataSize = entryIter->second.dataSize;
+
+        // Mark it as used before reading it, so that it is not the next one to be evicted.
+        TouchEntry( entryIter );
+    }
+
+    // Entry files are only ever published complete, so we read all of the data or nothing.
+    std::vector <char> entryData;
+
+    bool hasRead = false;
+
+    if ( CFile *entryStream = this->cacheRoot->Open( getEntryFileName( entryName ).c_str(), "rb" ) )
+    {
+        try
+        {
+            ReadStreamIntoMemory( entryStream, entryData );
+        }
+        catch( ... )
+        {
+            delete entryStream;
+
+            throw;
+        }
+
+        delete entryStream;
+
+        hasRead = ( entryData.size() == entryDataSize );
+    }
+
+    std::vector <std::string> deleteFileNames;
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        if ( hasRead )
+        {
+            this->hitCount++;
+            this->hitByteCount += entryData.size();
+        }
+        else
+        {
+            this->missCount++;
+
+            // The entry has been damaged or evicted in the meantime, so forget about it.
+            entryMap_t::iterator entryIter = this->entries.find( entryName );
+
+            if ( entryIter != this->entries.end() )
+            {
+                RemoveEntry( entryIter, deleteFileNames );
+            }
+        }
+    }
+
+    DeleteEntryFiles( deleteFileNames );
+
+    if ( hasRead )
+    {
+        dataOut = std::move( entryData );
+    }
+
+    return hasRead;
+}
+
+void ConversionResultCache::Store( const contentKey& key, const std::vector <char>& data )
+{
+    rw::uint64 dataSize = data.size();
+
+    // Results that do not fit at all would just empty the cache.
+    if ( dataSize > this->maxCacheSize )
+        return;
+
+    std::string entryName = key.GetEntryName();
+
+    std::vector <std::string> deleteFileNames;
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        entryMap_t::iterator entryIter = this->entries.find( entryName );
+
+        if ( entryIter != this->entries.end() )
+        {
+            // Another thread has converted the same input.
+            TouchEntry( entryIter );
+            return;
+        }
+
+        if ( this->pendingStores.find( entryName ) != this->pendingStores.end() )
+        {
+            // Another thread is storing the same input right now.
+            return;
+        }
+
+        EvictEntries( dataSize, deleteFileNames );
+
+        // Reserve the space, so that stores running at the same time do not exceed the limit.
+        this->totalSize += dataSize;
+
+        this->pendingStores.insert( entryName );
+    }
+
+    bool hasStored = false;
+
+    try
+    {
+        DeleteEntryFiles( deleteFileNames );
+
+        std::string fileName = getEntryFileName( entryName );
+        std::string tempFileName = getEntryTempFileName( entryName );
+
+        if ( CFile *entryStream = this->cacheRoot->Open( tempFileName.c_str(), "wb" ) )
+        {
+            size_t writeCount = entryStream->Write( data.data(), 1, data.size() );
+
+            delete entryStream;
+
+            if ( writeCount == data.size() )
+            {
+                // A file that was left behind by an eviction would be in the way.
+                this->cacheRoot->Delete( fileName.c_str() );
+
+                hasStored = this->cacheRoot->Rename( tempFileName.c_str(), fileName.c_str() );
+            }
+
+            if ( !hasStored )
+            {
+                // Do not leave broken entries behind.
+                this->cacheRoot->Delete( tempFileName.c_str() );
+            }
+        }
+    }
+    catch( ... )
+    {
+        std::unique_lock <std::mutex> guard( this->lock );
+
+        this->pendingStores.erase( entryName );
+
+        this->totalSize -= dataSize;
+
+        throw;
+    }
+
+    std::unique_lock <std::mutex> guard( this->lock );
+
+    this->pendingStores.erase( entryName );
+
+    // The reservation either becomes the entry or is given back.
+    this->totalSize -= dataSize;
+
+    if ( hasStored )
+    {
+        InsertEntry( entryName, dataSize );
+
+        this->storeCount++;
+    }
+}
+
+static inline std::string formatMegabytes( rw::uint64 byteCount )
+{
+    char sizeBuf[ 32 ];
+
+    snprintf( sizeBuf, sizeof( sizeBuf ), "%.1f MB", (double)byteCount / ( 1024.0 * 1024.0 ) );
+
+    return sizeBuf;
+}
+
+void ConversionResultCache::PrintStatistics( MessageReceiver *receiver ) const
+{
+    std::unique_lock <std::mutex> guard( this->lock );
+
+    receiver->OnMessage(
+        "conversion cache: " +
+        std::to_string( this->hitCount ) + " hits (" + formatMegabytes( this->hitByteCount ) + "), " +
+        std::to_string( this->missCount ) + " misses, " +
+        std::to_string( this->storeCount ) + " stored, " +
+        std::to_string( this->evictCount ) + " evicted; " +
+        std::to_string( this->entries.size() ) + " entries using " + formatMegabytes( this->totalSize ) + " of " + formatMegabytes( this->maxCacheSize ) + "\n"
+    );
+}
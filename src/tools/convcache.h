@@ -0,0 +1,97 @@
+#ifndef _CONVERSION_RESULT_CACHE_
+#define _CONVERSION_RESULT_CACHE_
+
+#include "shared.h"
+
+#include <map>
+#include <set>
+#include <mutex>
+
+// On-disk cache of conversion results.
+// Results are addressed by the contents of their input and a description of everything else that the
+// result depends on, like the normalized run configuration of a tool. Hence files that did not change
+// since the last run can be copied from the cache instead of being converted again.
+// The total size of the cache is bounded; the entries that were not used for the longest time are
+// evicted first. The cache can be used by many threads at once; entry files are read and written
+// outside of the lock and are published by renaming a complete file.
+struct ConversionResultCache
+{
+    // Hash of the input of a conversion.
+    struct contentKey
+    {
+        // The description should contain a version tag, so that results of older formats are not reused.
+        contentKey( const std::string& configDesc );
+
+        // Data has to be appended in the same order for every run.
+        void AppendData( const void *data, size_t dataSize );
+        void AppendString( const std::string& str );
+
+        std::string GetEntryName( void ) const;
+
+    private:
+        rw::uint64 hashLanes[2];
+    };
+
+    ConversionResultCache( CFileTranslator *cacheRoot, rw::uint64 maxCacheSize );
+    ~ConversionResultCache( void );
+
+    bool Lookup( const contentKey& key, std::vector <char>& dataOut );
+    void Store( const contentKey& key, const std::vector <char>& data );
+
+    // Writes out the index of entries; is done on destruction too.
+    void SaveIndex( void );
+
+    void PrintStatistics( MessageReceiver *receiver ) const;
+
+    // Appends every engine setting that can change a conversion result or its warnings, so that
+    // all tools build their keys from the same description of the engine.
+    static void AppendEngineSettingsDescription( rw::Interface *rwEngine, std::string& desc );
+
+    // Entries of converted files hold the warnings of the conversion in front of the result data,
+    // so that they can be output again on a cache hit.
+    static void PackResultEntry( const std::string& warnings, const std::vector <char>& resultData, std::vector <char>& entryOut );
+    static bool UnpackResultEntry( const std::vector <char>& entryData, std::string& warningsOut, std::vector <char>& resultDataOut );
+
+private:
+    struct cacheEntry
+    {
+        rw::uint64 dataSize;
+        rw::uint64 lastUse;
+    };
+
+    typedef std::map <std::string, cacheEntry> entryMap_t;
+
+    // Names of the entries by their last use, oldest first.
+    typedef std::map <rw::uint64, std::string> useOrderMap_t;
+
+    void LoadIndex( void );
+    void InsertEntry( const std::string& entryName, rw::uint64 dataSize );
+    void TouchEntry( entryMap_t::iterator entryIter );
+    void RemoveEntry( entryMap_t::iterator entryIter, std::vector <std::string>& deleteFileNames );
+    void EvictEntries( rw::uint64 requiredSize, std::vector <std::string>& deleteFileNames );
+    void DeleteEntryFiles( const std::vector <std::string>& deleteFileNames );
+
+    CFileTranslator *cacheRoot;
+    rw::uint64 maxCacheSize;
+
+    mutable std::mutex lock;
+
+    entryMap_t entries;
+    useOrderMap_t useOrder;
+
+    // Entries whose file is being written; their size is counted in totalSize already.
+    std::set <std::string> pendingStores;
+
+    rw::uint64 totalSize;
+    rw::uint64 useCounter;
+    bool isIndexDirty;
+
+    // Statistics of this run.
+    rw::uint64 hitCount;
+    rw::uint64 missCount;
+    rw::uint64 storeCount;
+    rw::uint64 evictCount;
+    rw::uint64 hitByteCount;
+};
+
+#endif //_CONVERSION_RESULT_CACHE_
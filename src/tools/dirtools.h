@@ -1,5 +1,16 @@
 #include "shared.h"
 
+// Reads the remaining contents of a stream into memory.
+inline void ReadStreamIntoMemory( CFile *stream, std::vector <char>& dataOut )
+{
+    char buffer[ 0x4000 ];
+
+    while ( size_t readCount = stream->Read( buffer, 1, sizeof( buffer ) ) )
+    {
+        dataOut.insert( dataOut.end(), buffer, buffer + readCount );
+    }
+}
+
 template <typename sentryType>
 struct gtaFileProcessor
 {
@@ -28,7 +39,10 @@ struct gtaFileProcessor
         traverse.reconstruct_archives = this->reconstruct_archives;
         traverse.use_compressed_img_archives = this->use_compressed_img_archives;
 
-        discHandle->ScanDirectory( "@", "*", true, NULL, _discFileCallback, &traverse );
+        _processDirectory( traverse );
+
+        // Write out anything that the sentry still has queued up.
+        theSentry->OnFlushPendingFiles();
     }
 
     inline void setArchiveReconstruction( bool doReconstruct )
@@ -66,6 +80,26 @@ private:
         sentryType *sentry;
     };
 
+    static void _collectFileCallback( const filePath& discFilePathAbs, void *userdata )
+    {
+        std::vector <filePath> *fileList = (std::vector <filePath>*)userdata;
+
+        fileList->push_back( discFilePathAbs );
+    }
+
+    static void _processDirectory( _discFileTraverse& traverse )
+    {
+        // Enumerate all the work first, so that sentries can process files while we are still walking.
+        std::vector <filePath> fileList;
+
+        traverse.discHandle->ScanDirectory( "@", "*", true, NULL, _collectFileCallback, &fileList );
+
+        for ( const filePath& discFilePathAbs : fileList )
+        {
+            _discFileCallback( discFilePathAbs, &traverse );
+        }
+    }
+
     static void _discFileCallback( const filePath& discFilePathAbs, void *userdata )
     {
         _discFileTraverse *info = (_discFileTraverse*)userdata;
@@ -108,6 +142,13 @@ private:
 
                     if ( srcIMGRoot )
                     {
+                        // Files that were queued before have to land in the build root before the archive does.
+                        // They belong to the directory that we are walking.
+                        if ( info->sentry->OnFlushPendingFiles() )
+                        {
+                            anyWork = true;
+                        }
+
                         try
                         {
                             // If we have found an IMG archive, we perform the same stuff for files inside of it.
@@ -179,7 +220,13 @@ private:
                                     traverse.reconstruct_archives = info->reconstruct_archives;
                                     traverse.use_compressed_img_archives = info->use_compressed_img_archives;
 
-                                    srcIMGRoot->ScanDirectory( "@", "*", true, NULL, _discFileCallback, &traverse );
+                                    _processDirectory( traverse );
+
+                                    // All files of the archive have to be written before we can save it.
+                                    if ( info->sentry->OnFlushPendingFiles() )
+                                    {
+                                        traverse.anyWork = true;
+                                    }
 
                                     if ( outputRoot_archive != NULL )
                                     {
@@ -4,6 +4,8 @@
 
 #include "txdbuild.h"
 
+#include "convcache.h"
+
 static rw::TextureBase* RwMakeTextureFromStream( rw::Interface *rwEngine, rw::Stream *imgStream, rwkind::eTargetGame targetGame, rwkind::eTargetPlatform targetPlatform )
 {
     // Since we do not care about warnings, we can just process things here.
@@ -11,36 +13,43 @@ static rw::TextureBase* RwMakeTextureFromStream( rw::Interface *rwEngine, rw::St
 
     rw::int64 streamBeg = imgStream->tell();
 
+    // Streams that carry the magic number of an image format cannot be texture chunks,
+    // so we skip the chunk parsing for them.
+    bool isImageFile = ( rw::IdentifyImagingFormat( imgStream, false ) != NULL );
+
     // First check whether it is a texture chunk.
-    try
+    if ( !isImageFile )
     {
-        rw::RwObject *rwObj = rwEngine->Deserialize( imgStream );
-
-        if ( rwObj )
+        try
         {
-            try
+            rw::RwObject *rwObj = rwEngine->Deserialize( imgStream );
+
+            if ( rwObj )
             {
-                if ( rw::TextureBase *texChunk = rw::ToTexture( rwEngine, rwObj ) )
+                try
                 {
-                    return texChunk;
+                    if ( rw::TextureBase *texChunk = rw::ToTexture( rwEngine, rwObj ) )
+                    {
+                        return texChunk;
+                    }
                 }
-            }
-            catch( ... )
-            {
+                catch( ... )
+                {
+                    rwEngine->DeleteRwObject( rwObj );
+                    throw;
+                }
+
                 rwEngine->DeleteRwObject( rwObj );
-                throw;
             }
-
-            rwEngine->DeleteRwObject( rwObj );
         }
-    }
-    catch( rw::RwException& )
-    {
-        // Ignore failed texture chunk deserialization.
-        // We still have other options.
-    }
+        catch( rw::RwException& )
+        {
+            // Ignore failed texture chunk deserialization.
+            // We still have other options.
+        }
 
-    imgStream->seek( streamBeg, rw::RWSEEK_BEG );
+        imgStream->seek( streamBeg, rw::RWSEEK_BEG );
+    }
 
     // Next check whether we have an image.
     try
@@ -93,194 +102,345 @@ static rw::TextureBase* RwMakeTextureFromStream( rw::Interface *rwEngine, rw::St
     return NULL;
 }
 
-void BuildTXDArchives( rw::Interface *rwEngine, TxdBuildModule *module, CFileTranslator *gameRoot, CFileTranslator *outputRoot, const TxdBuildModule::run_config& config )
+// Turns an image file into a texture of the dictionary.
+// Files that cannot be turned into a texture are skipped.
+static void AddTextureFromStream( rw::Interface *rwEngine, rw::TexDictionary *texDict, rw::Stream *imgStream, const filePath& texturePath, const TxdBuildModule::run_config& config )
 {
-    // Process things.
-    auto dir_callback = [&]( const filePath& dirPath )
+    try
     {
-        try
+        // Try turning it into a texture now.
+        rw::TextureBase *imgTex = RwMakeTextureFromStream( rwEngine, imgStream, config.targetGame, config.targetPlatform );
+
+        if ( imgTex )
         {
-            rw::TexDictionary *texDict = rw::CreateTexDictionary( rwEngine );
+            try
+            {
+                // Give the texture a name based on the original filename.
+                filePath texName = FileSystem::GetFileNameItem( texturePath, false );
+
+                std::string ansiTexName = texName.convert_ansi();
+                                            
+                imgTex->SetName( ansiTexName.c_str() );
 
-            if ( !texDict )
+                // Set some default rendering properties.
+                imgTex->SetUAddressing( rw::RWTEXADDRESS_WRAP );
+                imgTex->SetVAddressing( rw::RWTEXADDRESS_WRAP );
+
+                // ;)
+                imgTex->improveFiltering();
+
+                // Add our texture to the dictionary!
+                imgTex->AddToDictionary( texDict );
+            }
+            catch( ... )
             {
-                throw rw::RwException( "failed to allocate texture dictionary object" );
+                // In very rare cases we might have encountered an error.
+                // This means that we decided against the texture, so delete it.
+                rwEngine->DeleteRwObject( imgTex );
+
+                throw;
             }
-        
+        }
+    }
+    catch( rw::RwException& )
+    {
+        // If we failed to parse anything, ignore the error.
+    }
+}
+
+// If we have at least one texture in this texture dictionary, we can initialize it and write away.
+static bool FinishBuiltTXD( rw::TexDictionary *texDict )
+{
+    if ( texDict->GetTextureCount() == 0 )
+        return false;
+
+    // We give this TXD the version of the first texture inside, for good measure.
+    rw::TextureBase *firstTex = texDict->GetTextureIterator().Resolve();
+
+    texDict->SetEngineVersion( firstTex->GetEngineVersion() );
+
+    return true;
+}
+
+// Image file of a texture dictionary that is being built.
+struct txdbuildSourceFile
+{
+    filePath path;
+    std::vector <char> data;
+};
+
+// Reads all image files of a directory into memory, decompressing them if necessary.
+// They make up the key of the conversion cache, so they are read before anything is built.
+static void ReadTXDSourceFiles( TxdBuildModule *module, CFileTranslator *gameRoot, const filePath& dirPath, std::vector <txdbuildSourceFile>& sourceFilesOut )
+{
+    auto per_dir_file_cb = [&]( const filePath& texturePath )
+    {
+        // We first have to establish a stream to the file.
+        CFile *fsImgStream = gameRoot->Open( texturePath, L"rb" );
+
+        if ( fsImgStream )
+        {
             try
             {
-                auto per_dir_file_cb = [&]( const filePath& texturePath )
+                // Decompress if we find compressed things. ;)
+                fsImgStream = module->WrapStreamCodec( fsImgStream );
+            }
+            catch( ... )
+            {
+                delete fsImgStream;
+
+                throw;
+            }
+        }
+
+        if ( fsImgStream )
+        {
+            txdbuildSourceFile srcFile;
+            srcFile.path = texturePath;
+
+            try
+            {
+                ReadStreamIntoMemory( fsImgStream, srcFile.data );
+            }
+            catch( ... )
+            {
+                delete fsImgStream;
+
+                throw;
+            }
+
+            delete fsImgStream;
+
+            sourceFilesOut.push_back( std::move( srcFile ) );
+        }
+    };
+
+    gameRoot->ScanDirectory( dirPath, "*", false, NULL, std::move( per_dir_file_cb ), NULL );
+}
+
+// Builds a texture dictionary out of image files and returns it serialized.
+// Returns false if none of the files could be turned into a texture.
+static bool BuildTXDFromSourceFiles( rw::Interface *rwEngine, const std::vector <txdbuildSourceFile>& sourceFiles, const TxdBuildModule::run_config& config, std::vector <char>& txdDataOut )
+{
+    rw::TexDictionary *texDict = rw::CreateTexDictionary( rwEngine );
+
+    if ( !texDict )
+    {
+        throw rw::RwException( "failed to allocate texture dictionary object" );
+    }
+
+    bool hasBuilt = false;
+
+    try
+    {
+        for ( const txdbuildSourceFile& srcFile : sourceFiles )
+        {
+            rw::streamConstructionMemoryParam_t imgParam( (void*)srcFile.data.data(), srcFile.data.size() );
+
+            rw::Stream *imgStream = rwEngine->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_READONLY, &imgParam );
+
+            if ( imgStream )
+            {
+                try
                 {
-                    // We first have to establish a stream to the file.
-                    CFile *fsImgStream = gameRoot->Open( texturePath, L"rb" );
+                    AddTextureFromStream( rwEngine, texDict, imgStream, srcFile.path, config );
+                }
+                catch( ... )
+                {
+                    rwEngine->DeleteStream( imgStream );
 
-                    if ( fsImgStream )
-                    {
-                        try
-                        {
-                            // Decompress if we find compressed things. ;)
-                            fsImgStream = module->WrapStreamCodec( fsImgStream );
-                        }
-                        catch( ... )
-                        {
-                            delete fsImgStream;
+                    throw;
+                }
 
-                            throw;
-                        }
-                    }
+                rwEngine->DeleteStream( imgStream );
+            }
+        }
 
-                    if ( fsImgStream )
-                    {
-                        try
-                        {
-                            // Try to turn this file into a texture.
-                            try
-                            {
-                                rw::Stream *imgStream = RwStreamCreateTranslated( rwEngine, fsImgStream );
-
-                                if ( imgStream )
-                                {
-                                    try
-                                    {
-                                        // We got all streams prepared!
-                                        // Try turning it into a texture now.
-                                        rw::TextureBase *imgTex = RwMakeTextureFromStream( rwEngine, imgStream, config.targetGame, config.targetPlatform );
-
-                                        if ( imgTex )
-                                        {
-                                            try
-                                            {
-                                                // Give the texture a name based on the original filename.
-                                                filePath texName = FileSystem::GetFileNameItem( texturePath, false );
-
-                                                std::string ansiTexName = texName.convert_ansi();
-                                            
-                                                imgTex->SetName( ansiTexName.c_str() );
-
-                                                // Set some default rendering properties.
-                                                imgTex->SetUAddressing( rw::RWTEXADDRESS_WRAP );
-                                                imgTex->SetVAddressing( rw::RWTEXADDRESS_WRAP );
-
-                                                // ;)
-                                                imgTex->improveFiltering();
-
-                                                // Add our texture to the dictionary!
-                                                imgTex->AddToDictionary( texDict );
-                                            }
-                                            catch( ... )
-                                            {
-                                                // In very rare cases we might have encountered an error.
-                                                // This means that we decided against the texture, so delete it.
-                                                rwEngine->DeleteRwObject( imgTex );
-
-                                                throw;
-                                            }
-                                        }
-                                    }
-                                    catch( ... )
-                                    {
-                                        rwEngine->DeleteStream( imgStream );
-
-                                        throw;
-                                    }
-
-                                    rwEngine->DeleteStream( imgStream );
-                                }
-                            }
-                            catch( rw::RwException& )
-                            {
-                                // If we failed to parse anything, ignore the error.
-                            }
-                        }
-                        catch( ... )
-                        {
-                            delete fsImgStream;
+        if ( FinishBuiltTXD( texDict ) )
+        {
+            rw::streamConstructionMemoryParam_t txdParam( NULL, 0 );
 
-                            throw;
-                        }
+            rw::Stream *txdStream = rwEngine->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &txdParam );
 
-                        delete fsImgStream;
-                    }
-                };
+            if ( txdStream )
+            {
+                try
+                {
+                    // Finally, get to write this thing.
+                    rwEngine->Serialize( texDict, txdStream );
+
+                    txdDataOut.resize( (size_t)txdStream->size() );
 
-                gameRoot->ScanDirectory( dirPath, "*", false, NULL, std::move( per_dir_file_cb ), NULL );
+                    txdStream->seek( 0, rw::RWSEEK_BEG );
+                    txdStream->read( txdDataOut.data(), txdDataOut.size() );
+                }
+                catch( ... )
+                {
+                    rwEngine->DeleteStream( txdStream );
+
+                    throw;
+                }
+
+                rwEngine->DeleteStream( txdStream );
+
+                hasBuilt = true;
+            }
+        }
+    }
+    catch( ... )
+    {
+        rwEngine->DeleteRwObject( texDict );
+
+        throw;
+    }
+
+    rwEngine->DeleteRwObject( texDict );
+
+    return hasBuilt;
+}
+
+// Collects the warnings of building one texture dictionary, so they can be cached with it.
+struct txdbuildWarningBuffer : public rw::WarningManagerInterface
+{
+    std::string buffer;
+
+    void OnWarning( std::string&& message ) override
+    {
+        if ( !buffer.empty() )
+        {
+            buffer += '\n';
+        }
+
+        buffer += message;
+    }
+};
+
+// Describes everything besides the image files that a built TXD depends on.
+// The mipmap settings are left out because the build does not use them.
+// The engine settings are inherited from the engine that we run on, so they are taken from there.
+static std::string MakeCacheConfigDescription( rw::Interface *rwEngine, const TxdBuildModule::run_config& config )
+{
+    // Increase the version whenever the build changes its results.
+    std::string desc = "txdbuild 3";
+
+    desc += "; platform " + std::to_string( (int)config.targetPlatform );
+    desc += "; game " + std::to_string( (int)config.targetGame );
+
+    ConversionResultCache::AppendEngineSettingsDescription( rwEngine, desc );
+
+    return desc;
+}
+
+void BuildTXDArchives( rw::Interface *rwEngine, TxdBuildModule *module, CFileTranslator *gameRoot, CFileTranslator *outputRoot, const TxdBuildModule::run_config& config, ConversionResultCache *resultCache )
+{
+    std::string cacheConfigDesc = MakeCacheConfigDescription( rwEngine, config );
+
+    txdbuildWarningBuffer warnings;
 
-                // If we have at least one texture in this texture dictionary, we can initialize it and write away.
-                if ( texDict->GetTextureCount() != 0 )
+    // Process things.
+    auto dir_callback = [&]( const filePath& dirPath )
+    {
+        try
+        {
+            // We want to write the TXD with the same name as the directory had.
+            // Here we can use a trick: trimm of the last character of the directory path, always a slash, and replace it with ".txd" !
+            // The path has to be relative, as we want to write it into the output root.
+            filePath txdWritePath;
+
+            bool hasPath = gameRoot->GetRelativePathFromRoot( dirPath, false, txdWritePath );
+
+            if ( !hasPath )
+                return;
+
+            // Trimm off the slash, if it exists.
+            {
+                size_t outPathLen = txdWritePath.size();
+
+                if ( outPathLen > 0 )
                 {
-                    // We give this TXD the version of the first texture inside, for good measure.
-                    rw::TextureBase *firstTex = texDict->GetTextureIterator().Resolve();
+                    txdWritePath.resize( outPathLen - 1 );  // Here cannot be encoding issues as long as the character is a traditional slash.
+                }
+            }
 
-                    texDict->SetEngineVersion( firstTex->GetEngineVersion() );
+            txdWritePath += L".txd";
 
-                    // Now write it to disk.
-                    // We want to write it with the same name as the directory had.
-                    // Here we can use a trick: trimm of the last character of the directory path, always a slash, and replace it with ".txd" !
-                    // The path has to be relative, as we want to write it into the output root.
-                    filePath txdWritePath;
+            std::vector <txdbuildSourceFile> sourceFiles;
 
-                    bool hasPath = gameRoot->GetRelativePathFromRoot( dirPath, false, txdWritePath );
+            ReadTXDSourceFiles( module, gameRoot, dirPath, sourceFiles );
 
-                    if ( hasPath )
-                    {
-                        // Trimm off the slash, if it exists.
-                        {
-                            size_t outPathLen = txdWritePath.size();
+            if ( sourceFiles.empty() )
+                return;
 
-                            if ( outPathLen > 0 )
-                            {
-                                txdWritePath.resize( outPathLen - 1 );  // Here cannot be encoding issues as long as the character is a traditional slash.
-                            }
-                        }
+            ConversionResultCache::contentKey cacheKey( cacheConfigDesc );
 
-                        txdWritePath += L".txd";
+            std::vector <char> txdData;
 
-                        // Now establish the stream and push it!
-                        CFile *fsTXDStream = outputRoot->Open( txdWritePath, L"wb" );
+            bool hasTXD = false;
+            bool isFromCache = false;
 
-                        if ( fsTXDStream )
-                        {
-                            try
-                            {
-                                rw::Stream *txdStream = RwStreamCreateTranslated( rwEngine, fsTXDStream );
-
-                                if ( txdStream )
-                                {
-                                    try
-                                    {
-                                        // Finally, get to write this thing.
-                                        rwEngine->Serialize( texDict, txdStream );
-                                    }
-                                    catch( ... )
-                                    {
-                                        rwEngine->DeleteStream( txdStream );
-
-                                        throw;
-                                    }
-
-                                    rwEngine->DeleteStream( txdStream );
-                                }
-                            }
-                            catch( ... )
-                            {
-                                delete fsTXDStream;
-
-                                throw;
-                            }
-
-                            delete fsTXDStream;
-                        }
-                    }
+            warnings.buffer.clear();
+
+            if ( resultCache )
+            {
+                // Texture names come from the file names.
+                for ( const txdbuildSourceFile& srcFile : sourceFiles )
+                {
+                    cacheKey.AppendString( FileSystem::GetFileNameItem( srcFile.path, false ).convert_ansi() );
+                    cacheKey.AppendData( srcFile.data.data(), srcFile.data.size() );
                 }
+
+                std::vector <char> entryData;
+
+                isFromCache =
+                    ( resultCache->Lookup( cacheKey, entryData ) &&
+                      ConversionResultCache::UnpackResultEntry( entryData, warnings.buffer, txdData ) );
+
+                hasTXD = isFromCache;
             }
-            catch( ... )
+
+            if ( !isFromCache )
             {
-                rwEngine->DeleteRwObject( texDict );
+                hasTXD = BuildTXDFromSourceFiles( rwEngine, sourceFiles, config, txdData );
 
-                throw;
+                if ( hasTXD && resultCache )
+                {
+                    // The warnings are output again on a cache hit.
+                    std::vector <char> entryData;
+
+                    ConversionResultCache::PackResultEntry( warnings.buffer, txdData, entryData );
+
+                    resultCache->Store( cacheKey, entryData );
+                }
             }
 
-            rwEngine->DeleteRwObject( texDict );
+            if ( !warnings.buffer.empty() )
+            {
+                module->OnMessage( "* " + txdWritePath.convert_ansi() + "\n- Warnings:\n" + warnings.buffer + "\n\n" );
+
+                warnings.buffer.clear();
+            }
+
+            if ( hasTXD )
+            {
+                // Now establish the stream and push it!
+                CFile *fsTXDStream = outputRoot->Open( txdWritePath, L"wb" );
+
+                if ( fsTXDStream )
+                {
+                    try
+                    {
+                        fsTXDStream->Write( txdData.data(), 1, txdData.size() );
+                    }
+                    catch( ... )
+                    {
+                        delete fsTXDStream;
+
+                        throw;
+                    }
+
+                    delete fsTXDStream;
+                }
+            }
         }
         catch( rw::RwException& )
         {
@@ -288,8 +448,24 @@ void BuildTXDArchives( rw::Interface *rwEngine, TxdBuildModule *module, CFileTra
         }
     };
 
-    // Let us use the kickass C++11 lambdas :)
-    gameRoot->ScanDirectory( "@", "*", true, std::move( dir_callback ), NULL, NULL );
+    // The warnings of each TXD are collected, so that cache hits can output them again.
+    rw::WarningManagerInterface *prevWarningMan = rwEngine->GetWarningManager();
+
+    rwEngine->SetWarningManager( &warnings );
+
+    try
+    {
+        // Let us use the kickass C++11 lambdas :)
+        gameRoot->ScanDirectory( "@", "*", true, std::move( dir_callback ), NULL, NULL );
+    }
+    catch( ... )
+    {
+        rwEngine->SetWarningManager( prevWarningMan );
+
+        throw;
+    }
+
+    rwEngine->SetWarningManager( prevWarningMan );
 }
 
 bool TxdBuildModule::RunApplication( const run_config& config )
@@ -301,9 +477,6 @@ bool TxdBuildModule::RunApplication( const run_config& config )
 
     try
     {
-        rwEngine->SetWarningLevel( 0 );
-        rwEngine->SetWarningManager( NULL );
-
         // Get handles to the input and output directories.
         CFileTranslator *gameRootTranslator = NULL;
 
@@ -319,20 +492,63 @@ bool TxdBuildModule::RunApplication( const run_config& config )
 
                 if ( hasOutputRoot )
                 {
+                    CFileTranslator *cacheRootTranslator = NULL;
+
+                    bool hasCacheRoot = false;
+
+                    if ( !config.cacheRoot.empty() )
+                    {
+                        hasCacheRoot = obtainAbsolutePath( config.cacheRoot.c_str(), cacheRootTranslator, true );
+                    }
+
+                    ConversionResultCache *resultCache = NULL;
+
                     try
                     {
+                        if ( hasCacheRoot )
+                        {
+                            resultCache = new ConversionResultCache( cacheRootTranslator, (rw::uint64)config.cacheMaxSize * 1024 * 1024 );
+                        }
+
                         if ( hasGameRoot && hasOutputRoot )
                         {
-                            BuildTXDArchives( this->rwEngine, this, gameRootTranslator, outputRootTranslator, config );
+                            BuildTXDArchives( this->rwEngine, this, gameRootTranslator, outputRootTranslator, config, resultCache );
+                        }
+
+                        if ( resultCache )
+                        {
+                            resultCache->SaveIndex();
+
+                            resultCache->PrintStatistics( this );
                         }
                     }
                     catch( ... )
                     {
+                        if ( resultCache )
+                        {
+                            delete resultCache;
+                        }
+
+                        if ( hasCacheRoot )
+                        {
+                            delete cacheRootTranslator;
+                        }
+
                         delete outputRootTranslator;
 
                         throw;
                     }
 
+                    if ( resultCache )
+                    {
+                        delete resultCache;
+                    }
+
+                    if ( hasCacheRoot )
+                    {
+                        delete cacheRootTranslator;
+                    }
+
                     delete outputRootTranslator;
                 }
             }
@@ -19,6 +19,12 @@ struct TxdBuildModule abstract : public MessageReceiver
 
         bool generateMipmaps = false;
         int curMipMaxLevel = 0;
+
+        // Directory of the conversion result cache; the cache is not used if empty.
+        std::wstring cacheRoot;
+
+        // Size limit of the conversion result cache, in megabytes.
+        rw::uint32 cacheMaxSize = 1024;
     };
 
     bool RunApplication( const run_config& cfg );
@@ -220,6 +220,11 @@ struct _discFileSentry_txdexport
         return anyWork;
     }
 
+    inline bool OnFlushPendingFiles( void )
+    {
+        return false;
+    }
+
     inline void OnArchiveFail( const filePath& fileName, const filePath& extention )
     {
         return;
@@ -4,10 +4,16 @@
 
 #include <iostream>
 #include <streambuf>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <gtaconfig/include.h>
 
 #include "dirtools.h"
 
+#include "convcache.h"
+
 using namespace rwkind;
 
 
@@ -21,13 +27,41 @@ static inline void ConvertRasterToPlatformEx( rw::TextureBase *theTexture, rw::R
     }
 }
 
+// Converts many textures at once, spread across the worker pool of the engine.
+static inline void ConvertTexturesToPlatformEx( rw::Interface *rwEngine, const std::vector <rw::TextureBase*>& textures, rwkind::eTargetPlatform targetPlatform, rwkind::eTargetGame targetGame )
+{
+    const char *nativeName = rwkind::GetTargetNativeFormatName( targetPlatform, targetGame );
+
+    if ( nativeName == NULL || textures.empty() )
+        return;
+
+    rw::rasterConversionResults_t results;
+
+    rw::ConvertTextureRastersTo( rwEngine, textures.data(), textures.size(), nativeName, &results );
+
+    for ( const rw::rasterConversionResult& result : results )
+    {
+        if ( result.hasSucceeded == false )
+        {
+            std::string warning = "TxdGen: failed to convert texture " + result.texHandle->GetName();
+
+            if ( result.errorMessage.empty() == false )
+            {
+                warning += " (" + result.errorMessage + ")";
+            }
+
+            rwEngine->PushWarning( std::move( warning ) );
+        }
+    }
+}
+
 bool TxdGenModule::ProcessTXDArchive(
-    CFileTranslator *srcRoot, CFile *srcStream, CFile *targetStream, eTargetPlatform targetPlatform, eTargetGame targetGame,
+    rw::Stream *txd_stream, rw::Stream *rwTargetStream, eTargetPlatform targetPlatform, eTargetGame targetGame,
     bool clearMipmaps,
     bool generateMipmaps, rw::eMipmapGenerationMode mipGenMode, rw::uint32 mipGenMaxLevel,
     bool improveFiltering,
     bool doCompress, float compressionQuality,
-    bool outputDebug, CFileTranslator *debugRoot,
+    CFileTranslator *debugRoot, const filePath *relSrcPath,
     const rw::LibraryVersion& gameVersion,
     std::string& errMsg
 ) const
@@ -37,8 +71,6 @@ bool TxdGenModule::ProcessTXDArchive(
     bool hasProcessed = false;
 
     // Optimize the texture archive.
-    rw::Stream *txd_stream = RwStreamCreateTranslated( rwEngine, srcStream );
-
     try
     {
         rw::TexDictionary *txd = NULL;
@@ -87,6 +119,11 @@ bool TxdGenModule::ProcessTXDArchive(
 
                 try
                 {
+                    std::vector <rw::TextureBase*> allTextures;
+                    std::vector <bool> convertsBeforehand;
+
+                    std::vector <rw::TextureBase*> beforehandTextures;
+
                     for ( rw::TexDictionary::texIter_t iter = txd->GetTextureIterator(); !iter.IsEnd(); iter.Increment() )
                     {
                         rw::TextureBase *theTexture = iter.Resolve();
@@ -94,22 +131,38 @@ bool TxdGenModule::ProcessTXDArchive(
                         // Update the version of this texture.
                         theTexture->SetEngineVersion( gameVersion );
 
-                        // We need to modify the raster.
-                        rw::Raster *texRaster = theTexture->GetRaster();
+                        // Decide whether to convert to target architecture beforehand or afterward.
+                        bool shouldConvertBeforehand = false;
 
-                        if ( texRaster )
+                        if ( rw::Raster *texRaster = theTexture->GetRaster() )
                         {
-                            // Decide whether to convert to target architecture beforehand or afterward.
-                            bool shouldConvertBeforehand = ShouldRasterConvertBeforehand( texRaster, targetPlatform );
+                            shouldConvertBeforehand = ShouldRasterConvertBeforehand( texRaster, targetPlatform );
+                        }
 
-                            bool hasConvertedToTargetArchitecture = false;
+                        allTextures.push_back( theTexture );
+                        convertsBeforehand.push_back( shouldConvertBeforehand );
 
-                            if ( shouldConvertBeforehand == true )
-                            {
-                                ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
+                        if ( shouldConvertBeforehand )
+                        {
+                            beforehandTextures.push_back( theTexture );
+                        }
+                    }
 
-                                hasConvertedToTargetArchitecture = true;
-                            }
+                    // Textures are independent of each other, so they are converted at the same time.
+                    ConvertTexturesToPlatformEx( rwEngine, beforehandTextures, targetPlatform, targetGame );
+
+                    std::vector <rw::TextureBase*> afterwardTextures;
+
+                    for ( size_t n = 0; n < allTextures.size(); n++ )
+                    {
+                        rw::TextureBase *theTexture = allTextures[ n ];
+
+                        // We need to modify the raster.
+                        rw::Raster *texRaster = theTexture->GetRaster();
+
+                        if ( texRaster )
+                        {
+                            bool hasConvertedToTargetArchitecture = convertsBeforehand[ n ];
 
                             // Clear mipmaps if requested.
                             if ( clearMipmaps )
@@ -129,23 +182,17 @@ bool TxdGenModule::ProcessTXDArchive(
                             }
 
                             // Output debug stuff.
-                            if ( outputDebug && debugRoot != NULL )
+                            if ( debugRoot != NULL )
                             {
                                 // We want to debug mipmap generation, so output debug textures only using mipmaps.
                                 //if ( _meetsDebugCriteria( tex ) )
                                 {
-                                    std::wstring srcPath = srcStream->GetPath().convert_unicode();
-
-                                    filePath relSrcPath;
-
-                                    bool hasRelSrcPath = srcRoot->GetRelativePathFromRoot( srcPath.c_str(), true, relSrcPath );
-
-                                    if ( hasRelSrcPath )
+                                    if ( relSrcPath != NULL )
                                     {
                                         // Create a unique filename for this texture.
                                         filePath directoryPart;
 
-                                        filePath fileNamePart = FileSystem::GetFileNameItem( relSrcPath.c_str(), false, &directoryPart, NULL );
+                                        filePath fileNamePart = FileSystem::GetFileNameItem( relSrcPath->c_str(), false, &directoryPart, NULL );
 
                                         if ( fileNamePart.size() != 0 )
                                         {
@@ -247,17 +294,14 @@ bool TxdGenModule::ProcessTXDArchive(
                             }
 
                             // Convert it into the target platform.
-                            if ( shouldConvertBeforehand == false )
+                            if ( hasConvertedToTargetArchitecture == false )
                             {
-                                if ( hasConvertedToTargetArchitecture == false )
-                                {
-                                    ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
-
-                                    hasConvertedToTargetArchitecture = true;
-                                }
+                                afterwardTextures.push_back( theTexture );
                             }
                         }
                     }
+
+                    ConvertTexturesToPlatformEx( rwEngine, afterwardTextures, targetPlatform, targetGame );
                 }
                 catch( rw::RwException& except )
                 {
@@ -280,32 +324,19 @@ bool TxdGenModule::ProcessTXDArchive(
                 if ( processSuccessful )
                 {
                     // Write the TXD into the target stream.
-                    rw::Stream *rwTargetStream = RwStreamCreateTranslated( rwEngine, targetStream );
-
-                    if ( targetStream )
+                    if ( rwTargetStream )
                     {
                         try
                         {
-                            try
-                            {
-                                rwEngine->Serialize( txd, rwTargetStream );
-                            }
-                            catch( rw::RwException& except )
-                            {
-                                errMsg = "error writing txd: " + except.message;
-                                
-                                throw;
-                            }
+                            rwEngine->Serialize( txd, rwTargetStream );
                         }
-                        catch( ... )
+                        catch( rw::RwException& except )
                         {
-                            rwEngine->DeleteStream( rwTargetStream );
-
+                            errMsg = "error writing txd: " + except.message;
+                                
                             throw;
                         }
 
-                        rwEngine->DeleteStream( rwTargetStream );
-
                         hasProcessed = true;
                     }
                 }
@@ -327,29 +358,76 @@ bool TxdGenModule::ProcessTXDArchive(
     {
         hasProcessed = false;
     }
-    catch( ... )
+
+    return hasProcessed;
+}
+
+struct _discFileSentry_txdgen;
+
+// Converts TXD files on a pool of worker threads.
+// The results are written out by the thread that queued them, in the order they were queued, so that the
+// output (rebuilt IMG archives especially) does not depend on the amount of workers.
+struct txdgenConversionPipeline
+{
+    struct conversionJob
     {
-        hasProcessed = false;
+        CFileTranslator *buildRoot;
+        filePath relPathFromRoot;
 
-        if ( txd_stream )
-        {
-            rwEngine->DeleteStream( txd_stream );
+        bool isTXD;
 
-            txd_stream = NULL;
-        }
+        std::vector <char> srcData;
+        std::vector <char> dstData;
 
-        throw;
-    }
+        bool hasProcessed = false;
+        bool isFinished = false;
+        bool isFromCache = false;
 
-    if ( txd_stream )
-    {
-        rwEngine->DeleteStream( txd_stream );
+        std::string errorMessage;
+
+        TxdGenModule::RwWarningBuffer warnings;
+    };
+
+    txdgenConversionPipeline( _discFileSentry_txdgen *sentry, const TxdGenModule::run_config& cfg, rw::uint32 workerCount );
+    ~txdgenConversionPipeline( void );
 
-        txd_stream = NULL;
+    // Takes ownership of the job.
+    void Submit( conversionJob *job );
+
+    // Writes out all queued jobs.
+    void Flush( void );
+
+    inline bool HasPendingJobs( void ) const
+    {
+        return ( this->pendingJobs.empty() == false );
     }
 
-    return hasProcessed;
-}
+private:
+    void Shutdown( void );
+
+    void ExecuteJob( conversionJob *job );
+
+    void CommitFrontJob( void );
+
+    static void __cdecl _workerThreadEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud );
+
+    _discFileSentry_txdgen *sentry;
+    const TxdGenModule::run_config& cfg;
+
+    // Bounds the amount of file data that is kept in memory.
+    size_t maxPendingJobs;
+
+    std::vector <rw::thread_t> workerThreads;
+
+    std::mutex queueLock;
+    std::condition_variable jobAvailableCond;
+    std::condition_variable jobFinishedCond;
+
+    bool isTerminating;
+
+    std::deque <conversionJob*> waitingJobs;   // not picked up by any worker yet
+    std::deque <conversionJob*> pendingJobs;   // all jobs that have not been written out, in submission order
+};
 
 struct _discFileSentry_txdgen
 {
@@ -366,6 +444,10 @@ struct _discFileSentry_txdgen
     rw::LibraryVersion gameVersion;
     bool outputDebug;
     CFileTranslator *debugTranslator;
+    txdgenConversionPipeline *pipeline;
+    bool hasConvertedFiles;
+    ConversionResultCache *resultCache;
+    std::string cacheConfigDesc;
 
     inline bool OnSingletonFile(
         CFileTranslator *sourceRoot, CFileTranslator *buildRoot, const filePath& relPathFromRoot,
@@ -377,85 +459,226 @@ struct _discFileSentry_txdgen
         rw::CheckThreadHazards( module->GetEngine() );
 
         // Decide whether we need a copy.
-        bool requiresCopy = false;
+        bool isTXD = extention.equals( "TXD", false );
+
+        if ( !isTXD && !isInArchive )
+            return false;
+
+        if ( !sourceStream )
+            return false;
+
+        // Files that we just copy do not have to wait for the workers unless we have to keep the order.
+        if ( !isTXD && !pipeline->HasPendingJobs() )
+        {
+            CFile *targetStream = buildRoot->Open( relPathFromRoot, L"wb" );
+
+            if ( targetStream )
+            {
+                try
+                {
+                    // Make sure we copy from the beginning of the source stream.
+                    sourceStream->Seek( 0, SEEK_SET );
+
+                    // Copy the stream contents.
+                    FileSystem::StreamCopy( *sourceStream, *targetStream );
+                }
+                catch( ... )
+                {
+                    delete targetStream;
 
-        bool anyWork = false;
+                    throw;
+                }
+
+                delete targetStream;
+            }
+
+            return false;
+        }
+
+        txdgenConversionPipeline::conversionJob *job = new txdgenConversionPipeline::conversionJob();
 
-        if ( extention.equals( "TXD", false ) == true || isInArchive )
+        try
         {
-            requiresCopy = true;
+            job->buildRoot = buildRoot;
+            job->relPathFromRoot = relPathFromRoot;
+            job->isTXD = isTXD;
+            job->warnings.module = module;
+
+            sourceStream->Seek( 0, SEEK_SET );
+
+            ReadStreamIntoMemory( sourceStream, job->srcData );
+        }
+        catch( ... )
+        {
+            delete job;
+
+            throw;
         }
 
-        // Open the target stream.
-        CFile *targetStream = NULL;
+        pipeline->Submit( job );
+
+        // Whether the conversion succeeded is reported by OnFlushPendingFiles.
+        return false;
+    }
+
+    // Called on worker threads (or on the submitting thread if there are none).
+    inline void ConvertJob( txdgenConversionPipeline::conversionJob& job ) const
+    {
+        rw::Interface *rwEngine = module->GetEngine();
 
-        if ( requiresCopy )
+        ConversionResultCache::contentKey cacheKey( this->cacheConfigDesc );
+
+        if ( this->resultCache )
         {
-            targetStream = buildRoot->Open( relPathFromRoot, L"wb" );
+            cacheKey.AppendData( job.srcData.data(), job.srcData.size() );
+
+            std::vector <char> entryData;
+
+            if ( this->resultCache->Lookup( cacheKey, entryData ) &&
+                 ConversionResultCache::UnpackResultEntry( entryData, job.warnings.buffer, job.dstData ) )
+            {
+                job.hasProcessed = true;
+                job.isFromCache = true;
+                return;
+            }
         }
 
-        if ( targetStream && sourceStream )
+        rw::streamConstructionMemoryParam_t srcParam( job.srcData.data(), job.srcData.size() );
+
+        rw::Stream *srcStream = rwEngine->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_READONLY, &srcParam );
+
+        if ( !srcStream )
         {
-            // Allow to perform custom logic on the source and target streams.
-            bool hasCopiedFile = false;
+            job.errorMessage = "failed to create memory stream";
+            return;
+        }
+
+        try
+        {
+            // Converted TXDs usually have about the same size as the originals.
+            rw::streamConstructionMemoryParam_t dstParam( NULL, job.srcData.size() );
+
+            rw::Stream *dstStream = rwEngine->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &dstParam );
+
+            try
             {
-                if ( extention.equals( "TXD", false ) == true )
+                job.hasProcessed = module->ProcessTXDArchive(
+                    srcStream, dstStream, this->targetPlatform, this->targetGame,
+                    this->clearMipmaps,
+                    this->generateMipmaps, this->mipGenMode, this->mipGenMaxLevel,
+                    this->improveFiltering,
+                    this->doCompress, this->compressionQuality,
+                    ( this->outputDebug ? this->debugTranslator : NULL ), &job.relPathFromRoot,
+                    this->gameVersion,
+                    job.errorMessage
+                );
+
+                if ( job.hasProcessed && dstStream )
                 {
-                    module->OnMessage( "*** " + relPathFromRoot.convert_ansi() + " ..." );
-
-                    std::string errorMessage;
-
-                    bool couldProcessTXD = this->module->ProcessTXDArchive(
-                        sourceRoot, sourceStream, targetStream, this->targetPlatform, this->targetGame,
-                        this->clearMipmaps,
-                        this->generateMipmaps, this->mipGenMode, this->mipGenMaxLevel,
-                        this->improveFiltering,
-                        this->doCompress, this->compressionQuality,
-                        this->outputDebug, this->debugTranslator,
-                        this->gameVersion,
-                        errorMessage
-                    );
+                    job.dstData.resize( (size_t)dstStream->size() );
+
+                    dstStream->seek( 0, rw::RWSEEK_BEG );
+                    dstStream->read( job.dstData.data(), job.dstData.size() );
 
-                    if ( couldProcessTXD )
+                    if ( this->resultCache )
                     {
-                        hasCopiedFile = true;
+                        // The warnings are output again on a cache hit.
+                        std::vector <char> entryData;
 
-                        anyWork = true;
+                        ConversionResultCache::PackResultEntry( job.warnings.buffer, job.dstData, entryData );
 
-                        module->OnMessage( "OK\n" );
+                        this->resultCache->Store( cacheKey, entryData );
                     }
-                    else
-                    {
-                        module->OnMessage( "error:\n" + errorMessage + "\n" );
-                    }
-
-                    // Output any warnings.
-                    module->_warningMan.Purge();
                 }
             }
-
-            if ( requiresCopy )
+            catch( ... )
             {
-                // If we have not yet created the new copy, we default to simple stream swap.
-                if ( !hasCopiedFile && targetStream )
+                if ( dstStream )
                 {
-                    // Make sure we copy from the beginning of the source stream.
-                    sourceStream->Seek( 0, SEEK_SET );
-                    
-                    // Copy the stream contents.
-                    FileSystem::StreamCopy( *sourceStream, *targetStream );
-
-                    hasCopiedFile = true;
+                    rwEngine->DeleteStream( dstStream );
                 }
+
+                throw;
+            }
+
+            if ( dstStream )
+            {
+                rwEngine->DeleteStream( dstStream );
+            }
+        }
+        catch( ... )
+        {
+            rwEngine->DeleteStream( srcStream );
+
+            throw;
+        }
+
+        rwEngine->DeleteStream( srcStream );
+    }
+
+    // Called on the submitting thread, in submission order.
+    inline void CommitJob( txdgenConversionPipeline::conversionJob& job )
+    {
+        CFile *targetStream = job.buildRoot->Open( job.relPathFromRoot, L"wb" );
+
+        if ( job.isTXD )
+        {
+            module->OnMessage( "*** " + job.relPathFromRoot.convert_ansi() + " ..." );
+
+            if ( job.hasProcessed )
+            {
+                this->hasConvertedFiles = true;
+            }
+
+            if ( job.isFromCache )
+            {
+                module->OnMessage( "OK (cached)\n" );
+            }
+            else if ( job.hasProcessed )
+            {
+                module->OnMessage( "OK\n" );
             }
+            else
+            {
+                module->OnMessage( "error:\n" + job.errorMessage + "\n" );
+            }
+
+            // Output any warnings.
+            job.warnings.Purge();
         }
 
         if ( targetStream )
         {
+            try
+            {
+                // If we could not convert the file, we just copy it.
+                const std::vector <char>& data = ( job.hasProcessed ? job.dstData : job.srcData );
+
+                targetStream->Write( data.data(), 1, data.size() );
+            }
+            catch( ... )
+            {
+                delete targetStream;
+
+                throw;
+            }
+
             delete targetStream;
         }
+    }
+
+    // Returns whether any TXD has been converted since the last flush.
+    // Queued files are only committed between flushes of the directory that they were found in, so the
+    // result belongs to that directory.
+    inline bool OnFlushPendingFiles( void )
+    {
+        pipeline->Flush();
 
-        return anyWork;
+        bool hadConvertedFiles = this->hasConvertedFiles;
+
+        this->hasConvertedFiles = false;
+
+        return hadConvertedFiles;
     }
 
     inline void OnArchiveFail( const filePath& fileName, const filePath& extention )
@@ -464,6 +687,245 @@ struct _discFileSentry_txdgen
     }
 };
 
+txdgenConversionPipeline::txdgenConversionPipeline( _discFileSentry_txdgen *sentry, const TxdGenModule::run_config& cfg, rw::uint32 workerCount ) : cfg( cfg )
+{
+    this->sentry = sentry;
+    this->isTerminating = false;
+    this->maxPendingJobs = std::max( (size_t)workerCount * 4, (size_t)1 );
+
+    // With only one worker, we convert on the submitting thread.
+    if ( workerCount > 1 )
+    {
+        rw::Interface *rwEngine = sentry->module->GetEngine();
+
+        try
+        {
+            for ( rw::uint32 n = 0; n < workerCount; n++ )
+            {
+                rw::thread_t workerThread = rw::MakeThread( rwEngine, _workerThreadEntryPoint, this );
+
+                if ( workerThread == NULL )
+                    break;
+
+                this->workerThreads.push_back( workerThread );
+
+                rw::ResumeThread( rwEngine, workerThread );
+            }
+        }
+        catch( ... )
+        {
+            Shutdown();
+
+            throw;
+        }
+    }
+}
+
+txdgenConversionPipeline::~txdgenConversionPipeline( void )
+{
+    Shutdown();
+}
+
+void txdgenConversionPipeline::Shutdown( void )
+{
+    rw::Interface *rwEngine = sentry->module->GetEngine();
+
+    {
+        std::unique_lock <std::mutex> lock( this->queueLock );
+
+        this->isTerminating = true;
+    }
+
+    this->jobAvailableCond.notify_all();
+
+    // Workers finish the job they are on before they quit.
+    for ( rw::thread_t workerThread : this->workerThreads )
+    {
+        rw::JoinThread( rwEngine, workerThread );
+
+        rw::CloseThread( rwEngine, workerThread );
+    }
+
+    this->workerThreads.clear();
+
+    // Anything that was not written out is lost.
+    for ( conversionJob *job : this->pendingJobs )
+    {
+        delete job;
+    }
+
+    this->pendingJobs.clear();
+    this->waitingJobs.clear();
+}
+
+void txdgenConversionPipeline::ExecuteJob( conversionJob *job )
+{
+    rw::Interface *rwEngine = sentry->module->GetEngine();
+
+    // Keep the warnings with the job, so they show up next to its log entry.
+    rw::WarningManagerInterface *prevWarningMan = rwEngine->GetWarningManager();
+
+    rwEngine->SetWarningManager( &job->warnings );
+
+    try
+    {
+        if ( job->isTXD )
+        {
+            sentry->ConvertJob( *job );
+        }
+    }
+    catch( rw::RwException& except )
+    {
+        job->hasProcessed = false;
+        job->errorMessage = except.message;
+    }
+    catch( ... )
+    {
+        if ( this->workerThreads.empty() )
+        {
+            rwEngine->SetWarningManager( prevWarningMan );
+
+            throw;
+        }
+
+        // Worker threads must not die on us.
+        job->hasProcessed = false;
+        job->errorMessage = "unknown error";
+    }
+
+    rwEngine->SetWarningManager( prevWarningMan );
+}
+
+void __cdecl txdgenConversionPipeline::_workerThreadEntryPoint( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud )
+{
+    txdgenConversionPipeline *pipeline = (txdgenConversionPipeline*)ud;
+
+    // Each worker has its own configuration, because it uses its own warning managers.
+    rw::AssignThreadedRuntimeConfig( rwEngine );
+
+    try
+    {
+        pipeline->sentry->module->ApplyEngineConfig( pipeline->cfg );
+
+        // We already keep all processors busy with whole TXDs.
+        rwEngine->SetDXTCompressionWorkerCount( 1 );
+        rwEngine->SetWorkerPoolSize( 1 );
+
+        std::unique_lock <std::mutex> lock( pipeline->queueLock );
+
+        while ( true )
+        {
+            while ( !pipeline->isTerminating && pipeline->waitingJobs.empty() )
+            {
+                pipeline->jobAvailableCond.wait( lock );
+            }
+
+            if ( pipeline->isTerminating )
+                break;
+
+            conversionJob *job = pipeline->waitingJobs.front();
+
+            pipeline->waitingJobs.pop_front();
+
+            lock.unlock();
+
+            pipeline->ExecuteJob( job );
+
+            lock.lock();
+
+            job->isFinished = true;
+
+            pipeline->jobFinishedCond.notify_all();
+        }
+    }
+    catch( ... )
+    {
+        rw::ReleaseThreadedRuntimeConfig( rwEngine );
+
+        throw;
+    }
+
+    rw::ReleaseThreadedRuntimeConfig( rwEngine );
+}
+
+void txdgenConversionPipeline::Submit( conversionJob *job )
+{
+    if ( this->workerThreads.empty() )
+    {
+        // Do it right away.
+        this->pendingJobs.push_back( job );
+
+        ExecuteJob( job );
+
+        job->isFinished = true;
+
+        CommitFrontJob();
+        return;
+    }
+
+    // Make room for the new job.
+    while ( this->pendingJobs.size() >= this->maxPendingJobs )
+    {
+        CommitFrontJob();
+    }
+
+    {
+        std::unique_lock <std::mutex> lock( this->queueLock );
+
+        // Copy jobs are finished right away.
+        job->isFinished = ( job->isTXD == false );
+
+        this->pendingJobs.push_back( job );
+
+        if ( job->isTXD )
+        {
+            this->waitingJobs.push_back( job );
+        }
+    }
+
+    if ( job->isTXD )
+    {
+        this->jobAvailableCond.notify_one();
+    }
+}
+
+void txdgenConversionPipeline::CommitFrontJob( void )
+{
+    conversionJob *job = this->pendingJobs.front();
+
+    {
+        std::unique_lock <std::mutex> lock( this->queueLock );
+
+        while ( !job->isFinished )
+        {
+            this->jobFinishedCond.wait( lock );
+        }
+    }
+
+    this->pendingJobs.pop_front();
+
+    try
+    {
+        sentry->CommitJob( *job );
+    }
+    catch( ... )
+    {
+        delete job;
+
+        throw;
+    }
+
+    delete job;
+}
+
+void txdgenConversionPipeline::Flush( void )
+{
+    while ( !this->pendingJobs.empty() )
+    {
+        CommitFrontJob();
+    }
+}
+
 inline bool isGoodEngine( const rw::Interface *engineInterface )
 {
     if ( engineInterface->IsObjectRegistered( "texture" ) == false )
@@ -689,6 +1151,10 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
                     {
                         cfg.c_palRuntimeType = rw::PALRUNTIME_PNGQUANT;
                     }
+                    else if ( stricmp( palRuntimeType, "mediancut" ) == 0 )
+                    {
+                        cfg.c_palRuntimeType = rw::PALRUNTIME_MEDIANCUT;
+                    }
                 }
 
                 // DXT compression method.
@@ -753,6 +1219,33 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
                 {
                     cfg.c_outputDebug = mainEntry->GetBool( "outputDebug" );
                 }
+
+                // Conversion worker count.
+                if ( mainEntry->Find( "workerCount" ) )
+                {
+                    int workerCount = mainEntry->GetInt( "workerCount" );
+
+                    if ( workerCount >= 0 )
+                    {
+                        cfg.c_workerCount = (rw::uint32)workerCount;
+                    }
+                }
+
+                // Conversion result cache.
+                if ( const char *newCacheRoot = mainEntry->Get( "cacheRoot" ) )
+                {
+                    cfg.c_cacheRoot = (std::wstring_convert <std::codecvt <wchar_t, char, std::mbstate_t>, wchar_t> ()).from_bytes( newCacheRoot );
+                }
+
+                if ( mainEntry->Find( "cacheMaxSize" ) )
+                {
+                    int cacheMaxSize = mainEntry->GetInt( "cacheMaxSize" );
+
+                    if ( cacheMaxSize >= 0 )
+                    {
+                        cfg.c_cacheMaxSize = (rw::uint32)cacheMaxSize;
+                    }
+                }
             }
 
             // Kill the configuration.
@@ -763,6 +1256,53 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
     return cfg;
 }
 
+// Describes everything besides the input file that the converted TXD depends on.
+// Settings that have no effect on the result are left out, so that they do not spoil the cache.
+// The engine settings are taken from the engine, which must have the configuration applied.
+static std::string MakeCacheConfigDescription( rw::Interface *rwEngine, const TxdGenModule::run_config& cfg, const rw::LibraryVersion& gameVersion )
+{
+    // Increase the version whenever the conversion changes its results.
+    std::string desc = "txdgen 3";
+
+    desc += "; platform " + std::to_string( (int)cfg.c_targetPlatform );
+    desc += "; game " + std::to_string( (int)cfg.c_gameType ) + " " + gameVersion.toString();
+    desc += "; clearMipmaps " + std::to_string( (int)cfg.c_clearMipmaps );
+
+    if ( cfg.c_generateMipmaps )
+    {
+        desc += "; generateMipmaps " + std::to_string( (int)cfg.c_mipGenMode ) + " " + std::to_string( cfg.c_mipGenMaxLevel );
+    }
+
+    desc += "; improveFiltering " + std::to_string( (int)cfg.c_improveFiltering );
+
+    if ( cfg.compressTextures )
+    {
+        desc += "; compress " + std::to_string( cfg.c_compressionQuality );
+    }
+
+    ConversionResultCache::AppendEngineSettingsDescription( rwEngine, desc );
+
+    return desc;
+}
+
+void TxdGenModule::ApplyEngineConfig( const run_config& cfg ) const
+{
+    rw::Interface *rwEngine = this->rwEngine;
+
+    rwEngine->SetPaletteRuntime( cfg.c_palRuntimeType );
+    rwEngine->SetDXTRuntime( cfg.c_dxtRuntimeType );
+
+    rwEngine->SetDXTPackedDecompression( cfg.c_dxtPackedDecompression );
+
+    rwEngine->SetFixIncompatibleRasters( cfg.c_fixIncompatibleRasters );
+
+    rwEngine->SetIgnoreSerializationBlockRegions( cfg.c_ignoreSerializationRegions );
+
+    rwEngine->SetWarningLevel( cfg.c_warningLevel );
+
+    rwEngine->SetIgnoreSecureWarnings( cfg.c_ignoreSecureWarnings );
+}
+
 bool TxdGenModule::ApplicationMain( const run_config& cfg )
 {
     this->OnMessage(
@@ -778,18 +1318,7 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
         rwEngine->SetWarningManager( &_warningMan );
 
         // Set some configuration.
-        rwEngine->SetPaletteRuntime( cfg.c_palRuntimeType );
-        rwEngine->SetDXTRuntime( cfg.c_dxtRuntimeType );
-
-        rwEngine->SetDXTPackedDecompression( cfg.c_dxtPackedDecompression );
-
-        rwEngine->SetFixIncompatibleRasters( cfg.c_fixIncompatibleRasters );
-
-        rwEngine->SetIgnoreSerializationBlockRegions( cfg.c_ignoreSerializationRegions );
-
-        rwEngine->SetWarningLevel( cfg.c_warningLevel );
-
-        rwEngine->SetIgnoreSecureWarnings( cfg.c_ignoreSecureWarnings );
+        ApplyEngineConfig( cfg );
 
         // Output some debug info.
         this->OnMessage(
@@ -971,6 +1500,10 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
         {
             strPalRuntimeType = "pngquant";
         }
+        else if ( cfg.c_palRuntimeType == rw::PALRUNTIME_MEDIANCUT )
+        {
+            strPalRuntimeType = "mediancut";
+        }
 
         this->OnMessage(
             std::string( "* palRuntimeType: " ) + strPalRuntimeType + "\n"
@@ -1019,6 +1552,38 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
             std::string( "* ignoreSerializationRegions: " ) + ( cfg.c_ignoreSerializationRegions ? "true" : "false" ) + "\n"
         );
 
+        // Decide about the amount of TXDs that we convert at once.
+        rw::uint32 workerCount = cfg.c_workerCount;
+
+        if ( workerCount == 0 )
+        {
+            workerCount = std::max( std::thread::hardware_concurrency(), 1u );
+        }
+
+        if ( cfg.c_outputDebug )
+        {
+            // The debug output is written from the conversion itself.
+            workerCount = 1;
+        }
+
+        this->OnMessage(
+            std::string( "* workerCount: " ) + std::to_string( workerCount ) + "\n"
+        );
+
+        // The debug output is written from the conversion itself, so we cannot skip it.
+        bool useResultCache = ( !cfg.c_cacheRoot.empty() && !cfg.c_outputDebug );
+
+        if ( useResultCache )
+        {
+            this->OnMessage(
+                L"* cacheRoot: " + cfg.c_cacheRoot + L"\n"
+            );
+
+            this->OnMessage(
+                std::string( "* cacheMaxSize: " ) + std::to_string( cfg.c_cacheMaxSize ) + " MB\n"
+            );
+        }
+
         // Finish with a newline.
         this->OnMessage( "\n" );
 
@@ -1040,6 +1605,28 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
                 hasDebugRoot = obtainAbsolutePath( L"debug_output/", absDebugOutputTranslator, true, true );
             }
 
+            CFileTranslator *absCacheTranslator = NULL;
+
+            bool hasCacheRoot = false;
+
+            if ( useResultCache )
+            {
+                hasCacheRoot = obtainAbsolutePath( cfg.c_cacheRoot.c_str(), absCacheTranslator, true, true );
+
+                if ( !hasCacheRoot )
+                {
+                    this->OnMessage( "could not get a filesystem handle to the cache root; converting without cache\n" );
+                }
+            }
+
+            // Has to outlive the conversion pipeline.
+            ConversionResultCache *resultCache = NULL;
+
+            if ( hasCacheRoot )
+            {
+                resultCache = new ConversionResultCache( absCacheTranslator, (rw::uint64)cfg.c_cacheMaxSize * 1024 * 1024 );
+            }
+
             if ( hasGameRoot && hasOutputRoot )
             {
                 try
@@ -1066,11 +1653,25 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
                     sentry.gameVersion = targetVersion;
                     sentry.outputDebug = cfg.c_outputDebug;
                     sentry.debugTranslator = absDebugOutputTranslator;
+                    sentry.hasConvertedFiles = false;
+                    sentry.resultCache = resultCache;
+                    sentry.cacheConfigDesc = MakeCacheConfigDescription( rwEngine, cfg, targetVersion );
+
+                    txdgenConversionPipeline pipeline( &sentry, cfg, workerCount );
+
+                    sentry.pipeline = &pipeline;
 
                     fileProc.process( &sentry, absGameRootTranslator, absOutputRootTranslator );
 
                     // Output any warnings.
                     _warningMan.Purge();
+
+                    if ( resultCache )
+                    {
+                        resultCache->SaveIndex();
+
+                        resultCache->PrintStatistics( this );
+                    }
                 }
                 catch( ... )
                 {
@@ -1096,6 +1697,16 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
             }
 
             // Clean up resources.
+            if ( resultCache )
+            {
+                delete resultCache;
+            }
+
+            if ( hasCacheRoot )
+            {
+                delete absCacheTranslator;
+            }
+
             if ( hasDebugRoot )
             {
                 delete absDebugOutputTranslator;
@@ -54,19 +54,30 @@ public:
         int c_warningLevel = 3;
 
         bool c_ignoreSecureWarnings = false;
+
+        // Amount of TXDs that are converted at the same time; 0 picks the amount of logical processors.
+        rw::uint32 c_workerCount = 0;
+
+        // Directory of the conversion result cache; the cache is not used if empty.
+        std::wstring c_cacheRoot;
+
+        // Size limit of the conversion result cache, in megabytes.
+        rw::uint32 c_cacheMaxSize = 1024;
     };
 
     run_config ParseConfig( CFileTranslator *root, const filePath& cfgPath ) const;
 
     bool ApplicationMain( const run_config& cfg );
 
+    void ApplyEngineConfig( const run_config& cfg ) const;
+
     bool ProcessTXDArchive(
-        CFileTranslator *srcRoot, CFile *srcStream, CFile *targetStream, rwkind::eTargetPlatform targetPlatform, rwkind::eTargetGame targetGame,
+        rw::Stream *txd_stream, rw::Stream *rwTargetStream, rwkind::eTargetPlatform targetPlatform, rwkind::eTargetGame targetGame,
         bool clearMipmaps,
         bool generateMipmaps, rw::eMipmapGenerationMode mipGenMode, rw::uint32 mipGenMaxLevel,
         bool improveFiltering,
         bool doCompress, float compressionQuality,
-        bool outputDebug, CFileTranslator *debugRoot,
+        CFileTranslator *debugRoot, const filePath *relSrcPath,
         const rw::LibraryVersion& gameVersion,
         std::string& errMsg
     ) const;
@@ -171,9 +171,29 @@ static HRESULT rasterToHBITMAP( rw::Raster *raster, rw::uint32 bmpWidth, rw::uin
     {
         for ( rw::uint32 y = 0; y < height; y++ )
         {
+            bitmapPixel *rowPixels = (bitmapPixel*)colorStart + y * width;
+
+            // bitmapPixel is laid out as BGRA, so the whole row can be fetched at once.
+            if ( pixelData.fetchrow( 0, y, width, rowPixels, rw::COLOR_BGRA ) )
+            {
+                if ( !hasAlpha )
+                {
+                    for ( rw::uint32 x = 0; x < width; x++ )
+                    {
+                        if ( rowPixels[ x ].a != 255 )
+                        {
+                            hasAlpha = true;
+                            break;
+                        }
+                    }
+                }
+
+                continue;
+            }
+
             for ( rw::uint32 x = 0; x < width; x++ )
             {
-                bitmapPixel *pix = (bitmapPixel*)colorStart + y * width + x;
+                bitmapPixel *pix = rowPixels + x;
 
                 rw::uint8 r, g, b, a;
 